@@ -0,0 +1,65 @@
+/****************************
+ * Summary statistics for repeated timings
+ ****************************/
+#include <stdlib.h>
+#include <math.h>
+#include "benchstat.h"
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *) a, y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+/* median of the sorted array x[0..n-1] */
+static double sorted_median(double *x, int n)
+{
+    return (n % 2) ? x[n/2] : (x[n/2 - 1] + x[n/2]) / 2;
+}
+
+/*
+ * benchstat - Summarize the n samples in x (x is sorted in place)
+ *
+ * The confidence interval is the usual order-statistic interval for
+ * the median: the number of samples below the true median is
+ * Binomial(n, 1/2), so with the normal approximation the samples of
+ * rank n/2 -/+ 1.96*sqrt(n)/2 bracket it 95% of the time. It makes no
+ * assumption about the shape of the distribution. With fewer than 6
+ * samples it degenerates to [min, max].
+ */
+void benchstat(double *x, int n, benchstat_t *s)
+{
+    double *dev;
+    double half;
+    int i, j, k;
+
+    s->n = n;
+    if (n <= 0) {
+	s->median = s->mad = s->lo = s->hi = 0;
+	return;
+    }
+
+    qsort(x, n, sizeof(double), cmp_double);
+    s->median = sorted_median(x, n);
+
+    if ((dev = malloc(n * sizeof(double))) == NULL) {
+	s->mad = 0;
+    } else {
+	for (i = 0; i < n; i++)
+	    dev[i] = fabs(x[i] - s->median);
+	qsort(dev, n, sizeof(double), cmp_double);
+	s->mad = sorted_median(dev, n);
+	free(dev);
+    }
+
+    /* 1-based ranks of the interval endpoints */
+    half = 1.96 * sqrt((double) n) / 2;
+    j = (int) floor(n / 2.0 - half);
+    k = (int) ceil(n / 2.0 + 1 + half);
+    if (j < 1)
+	j = 1;
+    if (k > n)
+	k = n;
+    s->lo = x[j - 1];
+    s->hi = x[k - 1];
+}
@@ -0,0 +1,22 @@
+/*
+ * benchstat.h - Robust summary statistics for repeated timings
+ *
+ * Timing samples are skewed (interrupts and migrations only ever make
+ * a run slower), so we summarize them with the median and the median
+ * absolute deviation rather than the mean and standard deviation, and
+ * put a distribution-free confidence interval around the median.
+ */
+#ifndef __BENCHSTAT_H_
+#define __BENCHSTAT_H_
+
+typedef struct {
+    int n;          /* number of samples */
+    double median;  /* sample median */
+    double mad;     /* median absolute deviation from the median */
+    double lo, hi;  /* 95% confidence interval for the median */
+} benchstat_t;
+
+/* Summarize the n samples in x (x is sorted in place) */
+void benchstat(double *x, int n, benchstat_t *s);
+
+#endif /* __BENCHSTAT_H_ */
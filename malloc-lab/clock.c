@@ -1,5 +1,5 @@
 /* 
- * clock.c - Routines for using the cycle counters on x86, 
+ * clock.c - Routines for using the cycle counters on x86, x86-64,
  *           Alpha, and Sparc boxes.
  * 
  * Copyright (c) 2002, R. Bryant and D. O'Hallaron, All rights reserved.
@@ -9,9 +9,25 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <time.h>
 #include <sys/times.h>
 #include "clock.h"
 
+/* Name of the counter in use, printed by mhz() in verbose mode */
+static char *counter_name = "cycle counter";
+
+/*
+ * raw_ns - Nanoseconds from the raw monotonic clock, which NTP never
+ * slews. Used to calibrate the counter, and as the counter itself on
+ * machines without a usable one.
+ */
+static unsigned long long raw_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return (unsigned long long) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
 
 /******************************************************* 
  * Machine dependent functions 
@@ -71,6 +87,67 @@ double get_counter()
 }
 /* $end x86cyclecounter */
 
+#elif defined(__x86_64__)
+/*******************************************************
+ * x86-64 versions of start_counter() and get_counter()
+ *******************************************************/
+
+/* 
+ * On current x86-64 parts the time stamp counter ticks at a constant
+ * rate regardless of frequency scaling and sleep states ("invariant
+ * TSC"), so it is a wall clock with cycle resolution. rdtscp waits
+ * until every earlier instruction has executed before reading it, and
+ * the lfence that follows keeps later instructions from starting
+ * before the read, so the timed code can't leak out of the interval.
+ * Without an invariant TSC (or without rdtscp) we count nanoseconds
+ * of CLOCK_MONOTONIC_RAW instead; mhz() then reports ~1000 MHz and
+ * all the conversions to seconds still work.
+ */
+static unsigned long long cyc_start = 0;
+static int use_tsc = -1; /* -1: not yet probed */
+
+/* Does the CPU have rdtscp and an invariant TSC? */
+static int tsc_usable(void)
+{
+    unsigned a, b, c, d;
+
+    asm volatile("cpuid" : "=a" (a), "=b" (b), "=c" (c), "=d" (d) : "a" (0x80000000));
+    if (a < 0x80000007)
+	return 0;
+    asm volatile("cpuid" : "=a" (a), "=b" (b), "=c" (c), "=d" (d) : "a" (0x80000001));
+    if (!(d & (1 << 27)))        /* rdtscp */
+	return 0;
+    asm volatile("cpuid" : "=a" (a), "=b" (b), "=c" (c), "=d" (d) : "a" (0x80000007));
+    return (d & (1 << 8)) != 0;  /* invariant TSC */
+}
+
+/* Read the counter */
+static unsigned long long access_counter(void)
+{
+    unsigned hi, lo, aux;
+
+    if (use_tsc < 0) {
+	use_tsc = tsc_usable();
+	counter_name = use_tsc ? "invariant TSC (rdtscp)" : "CLOCK_MONOTONIC_RAW";
+    }
+    if (!use_tsc)
+	return raw_ns();
+    asm volatile("rdtscp; lfence" : "=a" (lo), "=d" (hi), "=c" (aux) : : "memory");
+    return ((unsigned long long) hi << 32) | lo;
+}
+
+/* Record the current value of the cycle counter. */
+void start_counter()
+{
+    cyc_start = access_counter();
+}
+
+/* Return the number of cycles since the last call to start_counter. */
+double get_counter()
+{
+    return (double) (access_counter() - cyc_start);
+}
+
 #elif defined(__alpha)
 
 /****************************************************
@@ -140,23 +217,20 @@ double get_counter()
  * counter routines. Newer models of sparcs (v8plus) have cycle
  * counters that can be accessed from user programs, but since there
  * are still many sparc boxes out there that don't support this, we
- * haven't provided a Sparc version here.
+ * haven't provided a Sparc version here. Instead the "cycles" are
+ * nanoseconds of the raw monotonic clock.
  ***************************************************************/
+static unsigned long long cyc_start = 0;
 
 void start_counter()
 {
-    printf("ERROR: You are trying to use a start_counter routine in clock.c\n");
-    printf("that has not been implemented yet on this platform.\n");
-    printf("Please choose another timing package in config.h.\n");
-    exit(1);
+    counter_name = "CLOCK_MONOTONIC_RAW";
+    cyc_start = raw_ns();
 }
 
 double get_counter() 
 {
-    printf("ERROR: You are trying to use a get_counter routine in clock.c\n");
-    printf("that has not been implemented yet on this platform.\n");
-    printf("Please choose another timing package in config.h.\n");
-    exit(1);
+    return (double) (raw_ns() - cyc_start);
 }
 #endif
 
@@ -181,24 +255,40 @@ double ovhd()
 
 /* $begin mhz */
 /* Estimate the clock rate by measuring the cycles that elapse */ 
-/* while sleeping for sleeptime seconds */
-double mhz_full(int verbose, int sleeptime)
+/* while sleeping for about sleepns nanoseconds. The time actually */
+/* slept comes from the raw monotonic clock, so oversleeping doesn't */
+/* skew the estimate. */
+static double mhz_ns(int verbose, long sleepns)
 {
     double rate;
+    unsigned long long t0, t1;
+    struct timespec req;
+
+    req.tv_sec = sleepns / 1000000000L;
+    req.tv_nsec = sleepns % 1000000000L;
 
+    t0 = raw_ns();
     start_counter();
-    sleep(sleeptime);
-    rate = get_counter() / (1e6*sleeptime);
+    nanosleep(&req, NULL);
+    rate = get_counter();
+    t1 = raw_ns();
+    rate = rate * 1e3 / (double) (t1 - t0);
     if (verbose) 
-	printf("Processor clock rate ~= %.1f MHz\n", rate);
+	printf("Counter (%s) rate ~= %.1f MHz\n", counter_name, rate);
     return rate;
 }
+
+double mhz_full(int verbose, int sleeptime)
+{
+    return mhz_ns(verbose, sleeptime * 1000000000L);
+}
 /* $end mhz */
 
-/* Version using a default sleeptime */
+/* Version using a default sleeptime. With an invariant counter */
+/* and a nanosecond reference clock, 100 ms is plenty. */
 double mhz(int verbose)
 {
-    return mhz_full(verbose, 2);
+    return mhz_ns(verbose, 100000000L);
 }
 
 /** Special counters that compensate for timer interrupt overhead */
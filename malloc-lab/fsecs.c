@@ -2,6 +2,7 @@
  * High-level timing wrappers
  ****************************/
 #include <stdio.h>
+#include <unistd.h>
 #include "fsecs.h"
 #include "fcyc.h"
 #include "clock.h"
@@ -12,6 +13,29 @@ static double Mhz;  /* estimated CPU clock frequency */
 
 extern int verbose; /* -v option in mdriver.c */
 
+#if USE_FCYC
+/*
+ * cache_clear_bytes - How much memory fcyc should sweep to flush the
+ *     caches between samples: twice the last level cache, or 8 MB if
+ *     the C library can't tell us its size.
+ */
+static int cache_clear_bytes(void)
+{
+    long llc = -1;
+
+#ifdef _SC_LEVEL3_CACHE_SIZE
+    llc = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    if (llc <= 0)
+	llc = sysconf(_SC_LEVEL2_CACHE_SIZE);
+#endif
+    if (llc <= 0)
+	llc = 4 << 20;
+    if (llc > (64 << 20))
+	llc = 64 << 20;
+    return (int) (2 * llc);
+}
+#endif
+
 /*
  * init_fsecs - initialize the timing package
  */
@@ -26,7 +50,9 @@ void init_fsecs(void)
     /* set key parameters for the fcyc package */
     set_fcyc_maxsamples(20); 
     set_fcyc_clear_cache(1);
-    set_fcyc_compensate(1);
+    set_fcyc_cache_size(cache_clear_bytes());
+    set_fcyc_cache_block(64);
+    set_fcyc_compensate(0); /* tickless kernels: no periodic tick to correct for */
     set_fcyc_epsilon(0.01);
     set_fcyc_k(3);
     Mhz = mhz(verbose > 0);
@@ -54,4 +80,22 @@ double fsecs(fsecs_test_funct f, void *argp)
 #endif 
 }
 
+/*
+ * fsecs_once - Return the running time of a single run of f (in
+ *     seconds), with no K-best filtering or averaging, for callers
+ *     that want every sample
+ */
+double fsecs_once(fsecs_test_funct f, void *argp)
+{
+#if USE_FCYC
+    start_counter();
+    f(argp);
+    return get_counter()/(Mhz*1e6);
+#elif USE_ITIMER
+    return ftimer_itimer(f, argp, 1);
+#elif USE_GETTOD
+    return ftimer_gettod(f, argp, 1);
+#endif 
+}
+
 
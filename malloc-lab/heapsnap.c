@@ -0,0 +1,91 @@
+/****************************
+ * Binary snapshots of the heap layout
+ ****************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "heapsnap.h"
+
+/*
+ * heapsnap_new - Allocate an empty snapshot with room for nblocks blocks
+ */
+heapsnap_t *heapsnap_new(uint64_t nblocks)
+{
+    heapsnap_t *s;
+
+    if ((s = calloc(1, sizeof(heapsnap_t))) == NULL)
+	return NULL;
+    memcpy(s->hdr.magic, HEAPSNAP_MAGIC, sizeof(s->hdr.magic));
+    s->hdr.nblocks = nblocks;
+    s->size = malloc((nblocks ? nblocks : 1) * sizeof(uint32_t));
+    s->bin = malloc(nblocks ? nblocks : 1);
+    if (s->size == NULL || s->bin == NULL) {
+	heapsnap_free(s);
+	return NULL;
+    }
+    return s;
+}
+
+/*
+ * heapsnap_write - Write s to path; return 0, or -1 with errno set
+ */
+int heapsnap_write(char *path, heapsnap_t *s)
+{
+    FILE *fp;
+    size_t n = s->hdr.nblocks;
+    int ok;
+
+    if ((fp = fopen(path, "wb")) == NULL)
+	return -1;
+    ok = fwrite(&s->hdr, sizeof(s->hdr), 1, fp) == 1 &&
+	fwrite(s->size, sizeof(uint32_t), n, fp) == n &&
+	fwrite(s->bin, 1, n, fp) == n;
+    if (fclose(fp) != 0 || !ok)
+	return -1;
+    return 0;
+}
+
+/*
+ * heapsnap_read - Read a snapshot; return NULL with errno set
+ */
+heapsnap_t *heapsnap_read(char *path)
+{
+    FILE *fp;
+    heapsnap_hdr_t hdr;
+    heapsnap_t *s = NULL;
+    size_t n;
+
+    if ((fp = fopen(path, "rb")) == NULL)
+	return NULL;
+    if (fread(&hdr, sizeof(hdr), 1, fp) != 1 ||
+	memcmp(hdr.magic, HEAPSNAP_MAGIC, sizeof(hdr.magic)) != 0) {
+	fclose(fp);
+	errno = EINVAL;
+	return NULL;
+    }
+    n = hdr.nblocks;
+    if ((s = heapsnap_new(n)) != NULL) {
+	s->hdr = hdr;
+	if (fread(s->size, sizeof(uint32_t), n, fp) != n ||
+	    fread(s->bin, 1, n, fp) != n) {
+	    heapsnap_free(s);
+	    s = NULL;
+	    errno = EINVAL;
+	}
+    }
+    fclose(fp);
+    return s;
+}
+
+/*
+ * heapsnap_free - Free a snapshot
+ */
+void heapsnap_free(heapsnap_t *s)
+{
+    if (s == NULL)
+	return;
+    free(s->size);
+    free(s->bin);
+    free(s);
+}
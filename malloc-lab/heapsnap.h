@@ -0,0 +1,46 @@
+/*
+ * heapsnap.h - Binary snapshots of the heap layout
+ *
+ * mdriver -d writes one of these at chosen ops of a trace, and
+ * heapview reads them back. A snapshot file holds a heapsnap_hdr_t,
+ * then nblocks block sizes (uint32, bit 0 set if the block is
+ * allocated), then nblocks bins (int8, the free list the block is on,
+ * -1 for none), all in host byte order. Blocks are contiguous: the
+ * first one starts first bytes into the heap and each of the others
+ * starts where the previous one ends, so addresses are not stored.
+ */
+#ifndef __HEAPSNAP_H_
+#define __HEAPSNAP_H_
+
+#include <stdint.h>
+
+#define HEAPSNAP_MAGIC "MMSNAP1"   /* 8 bytes with the terminating 0 */
+
+typedef struct {
+    char magic[8];
+    uint64_t op;          /* trace ops done before the snapshot */
+    uint64_t heap_size;   /* bytes from the heap start to the brk */
+    uint64_t live_bytes;  /* payload requested by the live blocks */
+    uint64_t first;       /* offset of the first block from the heap start */
+    uint64_t nblocks;
+} heapsnap_hdr_t;
+
+typedef struct {
+    heapsnap_hdr_t hdr;
+    uint32_t *size;       /* block size | 1 if allocated */
+    int8_t *bin;
+} heapsnap_t;
+
+/* Allocate an empty snapshot with room for nblocks blocks (or NULL) */
+heapsnap_t *heapsnap_new(uint64_t nblocks);
+
+/* Write s to path; return 0, or -1 with errno set */
+int heapsnap_write(char *path, heapsnap_t *s);
+
+/* Read a snapshot; return NULL with errno set (EINVAL if it is not one) */
+heapsnap_t *heapsnap_read(char *path);
+
+/* Free a snapshot */
+void heapsnap_free(heapsnap_t *s);
+
+#endif /* __HEAPSNAP_H_ */
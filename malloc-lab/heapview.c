@@ -0,0 +1,343 @@
+/*
+ * heapview.c - Offline analyzer for the heap snapshots of mdriver -d
+ *
+ * For each snapshot file it prints
+ *
+ *   a summary     heap size, live payload, allocated and free blocks
+ *   a map         one character per cell of the heap, by how much of
+ *                 the cell is allocated
+ *   free blocks   how the free bytes are spread over block sizes, and
+ *                 over the allocator's free lists when it reports them
+ *   pinning runs  runs of small allocated blocks sitting between two
+ *                 free blocks, biggest free space first: each one keeps
+ *                 left + run + right from being one free block
+ *
+ * usage: heapview [-w <cols>] [-r <rows>] [-s <bytes>] [-n <n>] <file.snap>...
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "heapsnap.h"
+
+/* Misc */
+#define SIZE_CLASSES 24 /* free size classes: <=32, <=64, ... <=128MB */
+#define MAX_BINS 128	/* free lists we keep counts for */
+
+/* Command line settings */
+static int map_cols = 64;	   /* characters per map row */
+static int map_rows = 32;	   /* at most this many map rows */
+static size_t small_max = 256; /* largest block size that counts as small */
+static int top_runs = 10;	   /* pinning runs to show */
+
+/* A run of small allocated blocks between two free blocks */
+typedef struct
+{
+	uint64_t offset;	 /* heap offset of the first block of the run */
+	int blocks;			 /* allocated blocks in the run */
+	uint64_t bytes;		 /* their total size */
+	uint64_t left;		 /* size of the free block before the run */
+	uint64_t right;		 /* size of the free block after it */
+} pinrun_t;
+
+static void usage(void);
+static void app_error(char *msg);
+
+#define BLK_SIZE(s, i) ((uint64_t)((s)->size[i] & ~7u))
+#define BLK_ALLOC(s, i) ((s)->size[i] & 1)
+
+/*
+ * print_summary - heap size, live payload and block counts
+ */
+static void print_summary(char *path, heapsnap_t *s)
+{
+	uint64_t i, alloc = 0, nalloc = 0, free_bytes = 0, nfree = 0, largest = 0;
+
+	for (i = 0; i < s->hdr.nblocks; i++)
+	{
+		if (BLK_ALLOC(s, i))
+		{
+			alloc += BLK_SIZE(s, i);
+			nalloc++;
+		}
+		else
+		{
+			free_bytes += BLK_SIZE(s, i);
+			nfree++;
+			if (BLK_SIZE(s, i) > largest)
+				largest = BLK_SIZE(s, i);
+		}
+	}
+
+	printf("%s: op %lu\n", path, (unsigned long)s->hdr.op);
+	printf("  heap %lu bytes, live payload %lu bytes (util %.1f%%)\n",
+		   (unsigned long)s->hdr.heap_size, (unsigned long)s->hdr.live_bytes,
+		   s->hdr.heap_size ? 100.0 * s->hdr.live_bytes / s->hdr.heap_size : 0.0);
+	printf("  allocated %lu blocks, %lu bytes; free %lu blocks, %lu bytes, largest %lu\n",
+		   (unsigned long)nalloc, (unsigned long)alloc, (unsigned long)nfree,
+		   (unsigned long)free_bytes, (unsigned long)largest);
+}
+
+/*
+ * print_map - Draw the heap, one character per cell of equal size:
+ *     '#' all allocated, '+' at least half, '-' less than half,
+ *     '.' all free, ' ' not covered by blocks (prologue, epilogue)
+ */
+static void print_map(heapsnap_t *s)
+{
+	uint64_t cell, ncells, c, i, lo, hi, start, end;
+	uint64_t *alloc, *covered;
+	int rows, r;
+	char ch;
+
+	/* A multiple of 8 bytes per cell, so the map fits in map_rows rows */
+	cell = (s->hdr.heap_size + (uint64_t)map_cols * map_rows - 1) / ((uint64_t)map_cols * map_rows);
+	cell = (cell + 7) & ~(uint64_t)7;
+	if (cell == 0)
+		cell = 8;
+	ncells = (s->hdr.heap_size + cell - 1) / cell;
+	rows = (int)((ncells + map_cols - 1) / map_cols);
+
+	alloc = calloc(ncells + 1, sizeof(uint64_t));
+	covered = calloc(ncells + 1, sizeof(uint64_t));
+	if (alloc == NULL || covered == NULL)
+		app_error("calloc failed in print_map");
+
+	/* Spread every block over the cells it overlaps */
+	start = s->hdr.first;
+	for (i = 0; i < s->hdr.nblocks; i++)
+	{
+		end = start + BLK_SIZE(s, i);
+		for (c = start / cell; c < ncells && c * cell < end; c++)
+		{
+			lo = (start > c * cell) ? start : c * cell;
+			hi = (end < (c + 1) * cell) ? end : (c + 1) * cell;
+			covered[c] += hi - lo;
+			if (BLK_ALLOC(s, i))
+				alloc[c] += hi - lo;
+		}
+		start = end;
+	}
+
+	printf("\n  Heap map, %lu bytes per cell ('#' allocated, '+' >= half, '-' < half, '.' free):\n",
+		   (unsigned long)cell);
+	for (r = 0; r < rows; r++)
+	{
+		printf("  %9lu |", (unsigned long)(r * map_cols * cell));
+		for (c = (uint64_t)r * map_cols; c < (uint64_t)(r + 1) * map_cols && c < ncells; c++)
+		{
+			if (covered[c] == 0)
+				ch = ' ';
+			else if (alloc[c] == 0)
+				ch = '.';
+			else if (alloc[c] == covered[c])
+				ch = '#';
+			else if (2 * alloc[c] >= covered[c])
+				ch = '+';
+			else
+				ch = '-';
+			putchar(ch);
+		}
+		printf("|\n");
+	}
+	free(alloc);
+	free(covered);
+}
+
+/*
+ * print_free - Free blocks by power-of-two size class and by free list
+ */
+static void print_free(heapsnap_t *s)
+{
+	uint64_t count[SIZE_CLASSES] = {0}, bytes[SIZE_CLASSES] = {0}, total = 0;
+	uint64_t bin_count[MAX_BINS] = {0}, bin_bytes[MAX_BINS] = {0};
+	uint64_t bin_min[MAX_BINS] = {0}, bin_max[MAX_BINS] = {0};
+	uint64_t i, size;
+	int k, b, have_bins = 0;
+	char label[32];
+
+	for (i = 0; i < s->hdr.nblocks; i++)
+	{
+		if (BLK_ALLOC(s, i))
+			continue;
+		size = BLK_SIZE(s, i);
+		for (k = 0; k < SIZE_CLASSES - 1 && size > (32ULL << k); k++)
+			;
+		count[k]++;
+		bytes[k] += size;
+		total += size;
+
+		b = s->bin[i];
+		if (b >= 0 && b < MAX_BINS)
+		{
+			have_bins = 1;
+			if (bin_count[b] == 0 || size < bin_min[b])
+				bin_min[b] = size;
+			if (size > bin_max[b])
+				bin_max[b] = size;
+			bin_count[b]++;
+			bin_bytes[b] += size;
+		}
+	}
+
+	printf("\n  Free blocks by size:\n");
+	printf("  %12s%10s%12s%8s\n", "size", "blocks", "bytes", "bytes%");
+	for (k = 0; k < SIZE_CLASSES; k++)
+	{
+		if (count[k] == 0)
+			continue;
+		sprintf(label, "<=%lu", (unsigned long)(32ULL << k));
+		printf("  %12s%10lu%12lu%7.1f%%\n", label, (unsigned long)count[k],
+			   (unsigned long)bytes[k], 100.0 * bytes[k] / total);
+	}
+
+	if (!have_bins)
+		return;
+	printf("\n  Free blocks by free list:\n");
+	printf("  %6s%10s%12s%10s%10s\n", "bin", "blocks", "bytes", "min", "max");
+	for (b = 0; b < MAX_BINS; b++)
+		if (bin_count[b] > 0)
+			printf("  %6d%10lu%12lu%10lu%10lu\n", b, (unsigned long)bin_count[b],
+				   (unsigned long)bin_bytes[b], (unsigned long)bin_min[b],
+				   (unsigned long)bin_max[b]);
+}
+
+static int cmp_pinned(const void *a, const void *b)
+{
+	const pinrun_t *x = a, *y = b;
+	uint64_t px = x->left + x->right, py = y->left + y->right;
+
+	return (px < py) - (px > py);
+}
+
+/*
+ * print_pinning - Runs of small allocated blocks (each at most small_max
+ *     bytes) with a free block on both sides, the most free space first
+ */
+static void print_pinning(heapsnap_t *s)
+{
+	pinrun_t *runs;
+	uint64_t i, j, offset, run_offset = 0;
+	int nruns = 0, k;
+
+	if ((runs = malloc((s->hdr.nblocks / 2 + 1) * sizeof(pinrun_t))) == NULL)
+		app_error("malloc failed in print_pinning");
+
+	offset = s->hdr.first;
+	for (i = 0; i < s->hdr.nblocks; i++)
+	{
+		/* A free block followed by a small allocated block starts a run */
+		if (BLK_ALLOC(s, i) || i + 1 >= s->hdr.nblocks ||
+			!BLK_ALLOC(s, i + 1) || BLK_SIZE(s, i + 1) > small_max)
+		{
+			offset += BLK_SIZE(s, i);
+			continue;
+		}
+		run_offset = offset + BLK_SIZE(s, i);
+		runs[nruns].offset = run_offset;
+		runs[nruns].left = BLK_SIZE(s, i);
+		runs[nruns].blocks = 0;
+		runs[nruns].bytes = 0;
+		for (j = i + 1; j < s->hdr.nblocks && BLK_ALLOC(s, j) && BLK_SIZE(s, j) <= small_max; j++)
+		{
+			runs[nruns].blocks++;
+			runs[nruns].bytes += BLK_SIZE(s, j);
+		}
+		offset = run_offset + runs[nruns].bytes;
+		if (j < s->hdr.nblocks && !BLK_ALLOC(s, j))
+		{
+			runs[nruns].right = BLK_SIZE(s, j);
+			nruns++;
+		}
+		i = j - 1; /* continue at the block after the run */
+	}
+
+	qsort(runs, nruns, sizeof(pinrun_t), cmp_pinned);
+	printf("\n  Runs of small (<= %lu byte) allocated blocks between free blocks: %d\n",
+		   (unsigned long)small_max, nruns);
+	if (nruns > 0)
+		printf("  %10s%8s%10s%10s%10s%12s\n", "offset", "blocks", "bytes",
+			   "left", "right", "if freed");
+	for (k = 0; k < nruns && k < top_runs; k++)
+		printf("  %10lu%8d%10lu%10lu%10lu%12lu\n", (unsigned long)runs[k].offset,
+			   runs[k].blocks, (unsigned long)runs[k].bytes,
+			   (unsigned long)runs[k].left, (unsigned long)runs[k].right,
+			   (unsigned long)(runs[k].left + runs[k].bytes + runs[k].right));
+	free(runs);
+}
+
+int main(int argc, char **argv)
+{
+	heapsnap_t *s;
+	int c, i;
+
+	while ((c = getopt(argc, argv, "w:r:s:n:h")) != EOF)
+	{
+		switch (c)
+		{
+		case 'w': /* Map width */
+			map_cols = atoi(optarg);
+			break;
+		case 'r': /* Map height */
+			map_rows = atoi(optarg);
+			break;
+		case 's': /* Largest small block */
+			small_max = atol(optarg);
+			break;
+		case 'n': /* Pinning runs to show */
+			top_runs = atoi(optarg);
+			break;
+		case 'h':
+			usage();
+			exit(0);
+		default:
+			usage();
+			exit(1);
+		}
+	}
+	if (optind >= argc || map_cols <= 0 || map_rows <= 0)
+	{
+		usage();
+		exit(1);
+	}
+
+	for (i = optind; i < argc; i++)
+	{
+		if ((s = heapsnap_read(argv[i])) == NULL)
+		{
+			fprintf(stderr, "heapview: %s: %s\n", argv[i],
+					errno == EINVAL ? "not a heap snapshot" : strerror(errno));
+			exit(1);
+		}
+		if (i > optind)
+			printf("\n");
+		print_summary(argv[i], s);
+		print_map(s);
+		print_free(s);
+		print_pinning(s);
+		heapsnap_free(s);
+	}
+	exit(0);
+}
+
+static void usage(void)
+{
+	fprintf(stderr, "Usage: heapview [-h] [-w <cols>] [-r <rows>] [-s <bytes>] [-n <n>] <file.snap>...\n");
+	fprintf(stderr, "Options\n");
+	fprintf(stderr, "\t-h         Print this message.\n");
+	fprintf(stderr, "\t-n <n>     Show the <n> biggest pinning runs (default 10).\n");
+	fprintf(stderr, "\t-r <rows>  At most <rows> rows in the heap map (default 32).\n");
+	fprintf(stderr, "\t-s <bytes> Blocks up to <bytes> count as small (default 256).\n");
+	fprintf(stderr, "\t-w <cols>  Cells per heap map row (default 64).\n");
+}
+
+/*
+ * app_error - Report an arbitrary application error
+ */
+static void app_error(char *msg)
+{
+	printf("%s\n", msg);
+	exit(1);
+}
@@ -0,0 +1,95 @@
+/****************************
+ * Log-linear latency histograms
+ ****************************/
+#include <string.h>
+#include "hist.h"
+
+/*
+ * bucket_of - Map a value to its bucket. The first 2*HIST_SUB buckets
+ *     hold 0..2*HIST_SUB-1 exactly; after that, bucket groups of
+ *     HIST_SUB cover [2^k, 2^(k+1)) in steps of 2^(k-HIST_SUB_BITS).
+ */
+static int bucket_of(unsigned long long v)
+{
+    int shift;
+
+    if (v < 2 * HIST_SUB)
+	return (int) v;
+    shift = (63 - __builtin_clzll(v)) - HIST_SUB_BITS;
+    return (shift + 1) * HIST_SUB + (int) ((v >> shift) - HIST_SUB);
+}
+
+/*
+ * hist_bucket_top - Return the largest value that maps to bucket b
+ */
+unsigned long long hist_bucket_top(int b)
+{
+    int shift;
+
+    if (b < 2 * HIST_SUB)
+	return b;
+    shift = b / HIST_SUB - 1;
+    return (((unsigned long long) (HIST_SUB + b % HIST_SUB) + 1) << shift) - 1;
+}
+
+/*
+ * hist_reset - Empty the histogram
+ */
+void hist_reset(hist_t *h)
+{
+    memset(h, 0, sizeof(hist_t));
+}
+
+/*
+ * hist_record - Count one value
+ */
+void hist_record(hist_t *h, unsigned long long v)
+{
+    h->buckets[bucket_of(v)]++;
+    h->count++;
+    if (v > h->max)
+	h->max = v;
+}
+
+/*
+ * hist_merge - Add every value counted in src to dst
+ */
+void hist_merge(hist_t *dst, hist_t *src)
+{
+    int b;
+
+    for (b = 0; b < HIST_BUCKETS; b++)
+	dst->buckets[b] += src->buckets[b];
+    dst->count += src->count;
+    if (src->max > dst->max)
+	dst->max = src->max;
+}
+
+/*
+ * hist_percentile - Return the value at percentile p (0..100). Like
+ *     HdrHistogram we report the top of the bucket that holds the
+ *     p-th value, capped at the largest value actually recorded.
+ */
+unsigned long long hist_percentile(hist_t *h, double p)
+{
+    unsigned long long rank, seen = 0, top;
+    int b;
+
+    if (h->count == 0)
+	return 0;
+
+    rank = (unsigned long long) (p / 100.0 * h->count + 0.5);
+    if (rank < 1)
+	rank = 1;
+    if (rank > h->count)
+	rank = h->count;
+
+    for (b = 0; b < HIST_BUCKETS; b++) {
+	seen += h->buckets[b];
+	if (seen >= rank) {
+	    top = hist_bucket_top(b);
+	    return (top < h->max) ? top : h->max;
+	}
+    }
+    return h->max;
+}
@@ -0,0 +1,37 @@
+/*
+ * hist.h - Log-linear latency histograms (HDR style)
+ *
+ * Values below 2*HIST_SUB are counted exactly. Above that, every power
+ * of two is split into HIST_SUB equal sub-buckets, so a recorded value
+ * is off by at most 1/HIST_SUB (about 3%) wherever it falls, and the
+ * whole 64-bit range fits in a fixed array.
+ */
+#ifndef __HIST_H_
+#define __HIST_H_
+
+#define HIST_SUB_BITS 5
+#define HIST_SUB      (1 << HIST_SUB_BITS)          /* sub-buckets per power of 2 */
+#define HIST_BUCKETS  ((64 - HIST_SUB_BITS + 1) * HIST_SUB)
+
+typedef struct {
+    unsigned long long count;                 /* number of recorded values */
+    unsigned long long max;                   /* largest recorded value */
+    unsigned long long buckets[HIST_BUCKETS];
+} hist_t;
+
+/* Empty the histogram */
+void hist_reset(hist_t *h);
+
+/* Count one value */
+void hist_record(hist_t *h, unsigned long long v);
+
+/* Add every value counted in src to dst */
+void hist_merge(hist_t *dst, hist_t *src);
+
+/* Return the largest value that maps to bucket b */
+unsigned long long hist_bucket_top(int b);
+
+/* Return the value at percentile p (0..100), accurate to one sub-bucket */
+unsigned long long hist_percentile(hist_t *h, double p);
+
+#endif /* __HIST_H_ */
@@ -0,0 +1,162 @@
+/****************************
+ * Hash map from trace ids to live blocks
+ ****************************/
+#include <stdlib.h>
+#include "idmap.h"
+
+#define IDMAP_MIN   64              /* smallest capacity */
+#define IDMAP_EMPTY UINT64_MAX      /* id of an unused slot */
+
+/* Fibonacci hashing: the top bits of id * 2^64/phi */
+static size_t slot_of(idmap_t *m, uint64_t id)
+{
+    return (size_t) ((id * 0x9e3779b97f4a7c15ULL) >> (64 - __builtin_ctzll(m->cap)));
+}
+
+/*
+ * alloc_slots - Allocate cap empty slots
+ */
+static idmap_entry_t *alloc_slots(size_t cap)
+{
+    idmap_entry_t *slots;
+    size_t i;
+
+    if ((slots = malloc(cap * sizeof(idmap_entry_t))) == NULL)
+	return NULL;
+    for (i = 0; i < cap; i++)
+	slots[i].id = IDMAP_EMPTY;
+    return slots;
+}
+
+/*
+ * resize - Rehash the map into cap slots; return -1 if out of memory
+ */
+static int resize(idmap_t *m, size_t cap)
+{
+    idmap_entry_t *old = m->slots, *slots;
+    size_t oldcap = m->cap, i, j;
+
+    if ((slots = alloc_slots(cap)) == NULL)
+	return -1;
+    m->slots = slots;
+    m->cap = cap;
+    for (i = 0; i < oldcap; i++) {
+	if (old[i].id == IDMAP_EMPTY)
+	    continue;
+	for (j = slot_of(m, old[i].id); slots[j].id != IDMAP_EMPTY; j = (j + 1) & (cap - 1))
+	    ;
+	slots[j] = old[i];
+    }
+    free(old);
+    if (cap > m->peak_cap)
+	m->peak_cap = cap;
+    return 0;
+}
+
+/*
+ * idmap_new - Make an empty map
+ */
+idmap_t *idmap_new(void)
+{
+    idmap_t *m;
+
+    if ((m = malloc(sizeof(idmap_t))) == NULL)
+	return NULL;
+    if ((m->slots = alloc_slots(IDMAP_MIN)) == NULL) {
+	free(m);
+	return NULL;
+    }
+    m->cap = m->peak_cap = IDMAP_MIN;
+    m->count = 0;
+    return m;
+}
+
+/*
+ * idmap_get - Find the entry of id
+ */
+idmap_entry_t *idmap_get(idmap_t *m, uint64_t id)
+{
+    size_t i;
+
+    for (i = slot_of(m, id); m->slots[i].id != IDMAP_EMPTY; i = (i + 1) & (m->cap - 1))
+	if (m->slots[i].id == id)
+	    return &m->slots[i];
+    return NULL;
+}
+
+/*
+ * idmap_put - Find the entry of id, adding it if needed. The table is
+ *     kept at most half full so probe sequences stay short.
+ */
+idmap_entry_t *idmap_put(idmap_t *m, uint64_t id)
+{
+    idmap_entry_t *e;
+    size_t i;
+
+    if (id == IDMAP_EMPTY)
+	return NULL;
+    if ((e = idmap_get(m, id)) != NULL)
+	return e;
+    if (2 * (m->count + 1) > m->cap && resize(m, 2 * m->cap) < 0)
+	return NULL;
+
+    for (i = slot_of(m, id); m->slots[i].id != IDMAP_EMPTY; i = (i + 1) & (m->cap - 1))
+	;
+    e = &m->slots[i];
+    e->id = id;
+    e->ptr = NULL;
+    e->size = 0;
+    e->tag = 0;
+    m->count++;
+    return e;
+}
+
+/*
+ * idmap_remove - Remove id. Instead of leaving a tombstone, the entries
+ *     after it in the probe run are shifted back into the hole, so a
+ *     map with a lot of churn never fills up with dead slots. Once it
+ *     is less than 1/8 full it shrinks by half.
+ */
+int idmap_remove(idmap_t *m, uint64_t id, idmap_entry_t *old)
+{
+    idmap_entry_t *e;
+    size_t hole, i, home, mask = m->cap - 1;
+
+    if ((e = idmap_get(m, id)) == NULL)
+	return 0;
+    if (old != NULL)
+	*old = *e;
+
+    hole = e - m->slots;
+    for (i = (hole + 1) & mask; m->slots[i].id != IDMAP_EMPTY; i = (i + 1) & mask) {
+	home = slot_of(m, m->slots[i].id);
+	/* Move i into the hole unless its home lies in (hole, i] */
+	if (((i - home) & mask) >= ((i - hole) & mask)) {
+	    m->slots[hole] = m->slots[i];
+	    hole = i;
+	}
+    }
+    m->slots[hole].id = IDMAP_EMPTY;
+    m->count--;
+
+    if (m->cap > IDMAP_MIN && 8 * m->count < m->cap)
+	resize(m, m->cap / 2);     /* if this fails the map just stays big */
+    return 1;
+}
+
+/*
+ * idmap_bytes - Bytes used by the table
+ */
+size_t idmap_bytes(idmap_t *m)
+{
+    return sizeof(idmap_t) + m->cap * sizeof(idmap_entry_t);
+}
+
+/*
+ * idmap_free - Free the map
+ */
+void idmap_free(idmap_t *m)
+{
+    free(m->slots);
+    free(m);
+}
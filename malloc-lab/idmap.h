@@ -0,0 +1,50 @@
+/*
+ * idmap.h - Hash map from trace ids to live blocks
+ *
+ * An open-addressing table (linear probing, power-of-two capacity)
+ * used instead of an array indexed by id when a trace is too long to
+ * allocate num_ids entries up front. The table grows and shrinks with
+ * the number of ids it holds, so its size follows the live set of the
+ * trace, not the number of ids the trace ever used.
+ */
+#ifndef __IDMAP_H_
+#define __IDMAP_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* One live id */
+typedef struct {
+    uint64_t id;
+    void *ptr;               /* the block, if any */
+    uint64_t size;           /* its requested size */
+    uint64_t tag;            /* free for the caller, e.g. the op that made it */
+} idmap_entry_t;
+
+typedef struct {
+    idmap_entry_t *slots;
+    size_t cap;              /* number of slots, a power of 2 */
+    size_t count;            /* ids in the map */
+    size_t peak_cap;         /* the largest cap so far */
+} idmap_t;
+
+/* Make an empty map; return NULL if out of memory */
+idmap_t *idmap_new(void);
+
+/* Return the entry of id, or NULL if it is not in the map */
+idmap_entry_t *idmap_get(idmap_t *m, uint64_t id);
+
+/* Return the entry of id, adding a zeroed one if it is not in the map;
+   NULL if out of memory. The entry moves when the map is changed. */
+idmap_entry_t *idmap_put(idmap_t *m, uint64_t id);
+
+/* Remove id, copying its entry to *old; return 0 if it wasn't there */
+int idmap_remove(idmap_t *m, uint64_t id, idmap_entry_t *old);
+
+/* Bytes used by the table */
+size_t idmap_bytes(idmap_t *m);
+
+/* Free the map */
+void idmap_free(idmap_t *m);
+
+#endif /* __IDMAP_H_ */
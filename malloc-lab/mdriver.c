@@ -7,20 +7,36 @@
  * Copyright (c) 2002, R. Bryant and D. O'Hallaron, All rights reserved.
  * May not be used, modified, or copied without permission.
  */
+#define _GNU_SOURCE /* for sched_setaffinity */
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <getopt.h>
 #include <errno.h>
 #include <string.h>
 #include <assert.h>
 #include <float.h>
 #include <time.h>
+#include <sched.h>
+#include <stdint.h>
+#include <limits.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 extern char *optarg; // Added declaration for optarg
 
 #include "mm.h"
 #include "memlib.h"
 #include "fsecs.h"
+#include "clock.h"
+#include "hist.h"
+#include "benchstat.h"
+#include "perfctr.h"
+#include "heapsnap.h"
+#include "traceio.h"
+#include "tracestream.h"
+#include "idmap.h"
 #include "config.h"
 
 /**********************
@@ -32,6 +48,9 @@ extern char *optarg; // Added declaration for optarg
 #define HDRLINES 4		   /* number of header lines in a trace file */
 #define LINENUM(i) (i + 5) /* cnvt trace request nums to linenums (origin 1) */
 
+/* Payload fill and check work in lines of this many bytes (-S) */
+#define VERIFY_LINE 64
+
 /* Returns true if p is ALIGNMENT-byte aligned */
 #define IS_ALIGNED(p) ((((unsigned int)(p)) % ALIGNMENT) == 0)
 
@@ -39,14 +58,22 @@ extern char *optarg; // Added declaration for optarg
  * The key compound data types
  *****************************/
 
-/* Records the extent of each block's payload */
+/*
+ * Records the extent of each block's payload. Live payloads never
+ * overlap, so the ranges are kept in an AVL tree ordered by lo.
+ */
 typedef struct range_t
 {
-	char *lo;			  /* low payload address */
-	char *hi;			  /* high payload address */
-	struct range_t *next; /* next list element */
+	char *lo;			   /* low payload address */
+	char *hi;			   /* high payload address */
+	struct range_t *left;  /* ranges below lo (next free record in the pool) */
+	struct range_t *right; /* ranges above hi */
+	int height;			   /* height of the subtree, 1 for a leaf */
 } range_t;
 
+/* Range records are carved out of chunks of this many */
+#define RANGE_CHUNK 4096
+
 /* Characterizes a single trace operation (allocator request) */
 typedef struct
 {
@@ -56,8 +83,9 @@ typedef struct
 		FREE,
 		REALLOC
 	} type;	   /* type of request */
-	int index; /* index for free() to use later */
-	int size;  /* byte size of alloc/realloc request */
+	int index;	 /* index for free() to use later */
+	size_t size; /* byte size of alloc/realloc request */
+	int hint;	 /* lifetime hint for alloc requests (MM_HINT_xxx) */
 } traceop_t;
 
 /* Holds the information for one trace file*/
@@ -70,6 +98,10 @@ typedef struct
 	traceop_t *ops;		 /* array of requests */
 	char **blocks;		 /* array of ptrs returned by malloc/realloc... */
 	size_t *block_sizes; /* ... and a corresponding array of payload sizes */
+	mm_arena_t **arenas; /* arena of each group of ids (-A only)... */
+	int *arena_live;	 /* ... the number of live blocks in it... */
+	char *arena_heap;	 /* ... whether it uses mm_malloc instead... */
+	size_t *arena_sizes; /* ... and the room in each id's block */
 } trace_t;
 
 /*
@@ -93,10 +125,70 @@ typedef struct
 
 	/* defined only for the student malloc package */
 	double util; /* space utilization for this trace (always 0 for libc) */
+	int sbrks;	 /* number of mem_sbrk calls made during the util run */
+	double heapsize; /* heap size in bytes at the end of the util run */
+	int skipped;	 /* ran out of heap in arena mode (-A), not an error */
+
+	/* defined only in benchmark mode (-r) */
+	benchstat_t bench; /* net secs per run over the repetitions */
+	double null_secs;  /* median secs of the empty replay loop */
+
+	/* defined only with hardware counters (-e) */
+	double counters[PERFCTR_NUM]; /* events counted in one run */
+
+#ifdef MM_STATS
+	/* allocator statistics of the util run, live/free bytes at its peak */
+	mm_stats_t mm;
+#endif
+
+#ifdef MM_PROFILE
+	/* per-function cycles in the util run */
+	mm_profile_t prof;
+#endif
 
 	/* Note: secs and util are only defined if valid is true */
 } stats_t;
 
+/* One of the slowest requests seen in the latency run (-L) */
+typedef struct
+{
+	unsigned long long cycles; /* time taken by the request */
+	int opnum;				   /* request number in the trace */
+} slowop_t;
+
+/* What a baseline results file (--baseline) says about one trace */
+typedef struct
+{
+	int found;		 /* does the baseline have this trace? */
+	int valid;		 /* was it valid in the baseline? */
+	double secs;	 /* secs per run... */
+	double util;	 /* ... space utilization... */
+	int bench_n;	 /* ... and, from benchmark mode, the number of runs... */
+	double lo, hi;	 /* ... and the 95% confidence interval of secs */
+} baseline_t;
+
+/* Per-request latencies of the mm malloc package on one trace (-L) */
+typedef struct
+{
+	hist_t hist[3];	   /* one histogram per request type (ALLOC, FREE, REALLOC) */
+	slowop_t *slowest; /* the slowest requests, slowest first... */
+	int nslow;		   /* ... and how many of them there are */
+	traceop_t *ops;	   /* the trace requests, to describe the slowest ones */
+} latency_t;
+
+/* Results of streaming one trace through the mm malloc package (-R) */
+typedef struct
+{
+	int valid;						/* replayed without errors? */
+	unsigned long long ops;			/* requests replayed */
+	unsigned long long peak_ids;	/* most ids live at once... */
+	unsigned long long peak_bytes;	/* ... and most payload bytes live at once */
+	double heapsize;				/* heap size at the end */
+	double secs;					/* replay time, including waits for the reader... */
+	double stall;					/* ... of which this much was waiting */
+	size_t harness;					/* peak bytes of the id map and the buffers */
+} stream_stats_t;
+
 /********************
  * Global variables
  *******************/
@@ -104,6 +196,77 @@ int verbose = 0;	   /* global flag for verbose output */
 static int errors = 0; /* number of errs found when running student malloc */
 char msg[MAXLINE];	   /* for whenever we need to compose an error message */
 
+/* If > 0, ids freed within this many ops are hinted short-lived (-H) */
+static int hint_window = 0;
+
+/* If > 0, ids are grouped this many at a time into arenas (-A), whose
+   chunks are sized from the group's first request, up to this many bytes */
+static int arena_group = 0;
+#define ARENA_MAX_CHUNK 4096
+
+/* Set by eval_mm_valid when the trace ran out of heap in arena mode */
+static int arena_out_of_heap = 0;
+
+/* If > 0, time every request and report this many slowest ones (-L) */
+static int lat_slowest = 0;
+
+/* Benchmark mode (-r): timed repetitions, untimed warmup runs, and the
+   cpu to pin to (-1 for none) */
+static int bench_reps = 0;
+static int bench_warmups = 2;
+static int bench_cpu = -1;
+
+/* If set, count hardware events in one run of each trace (-e) */
+static int count_events = 0;
+
+/* If > 0, sample the heap every this many ops of the util run and write
+   a fragmentation timeline per trace (-k) into a directory (-D) */
+static int timeline_every = 0;
+static char *timeline_dir = ".";
+static FILE *timeline_fp = NULL;
+
+/* Ops of the util run before which to dump a heap snapshot (-d), sorted,
+   and the trace file they are named after */
+#define MAX_DUMPS 64
+static int dump_ops[MAX_DUMPS];
+static int num_dumps = 0;
+static char *util_tracefile = NULL;
+
+#ifdef MM_STATS
+/* Allocator statistics of the last util run (filled in by eval_mm_util) */
+static mm_stats_t util_stats;
+#endif
+
+/* If > 0, fill and check only this many lines of each payload (-S) */
+static int verify_lines = 0;
+
+/* If set, stream the traces through mm malloc instead of loading them (-R) */
+static int stream_mode = 0;
+
+/* Results file to write (-o), baseline to compare against (-B), and the
+   slowdown in percent below which a change is not a regression (-T) */
+static char *output_file = NULL;
+static char *baseline_file = NULL;
+static double tolerance = 3.0;
+
+/* A utilization drop of more than this is a regression */
+#define UTIL_EPSILON 0.001
+
+/* mdriver exits with this status when it finds regressions */
+#define EXIT_REGRESSION 2
+
+/* Long forms of the command line flags */
+static struct option long_options[] = {
+	{"output", required_argument, NULL, 'o'},
+	{"baseline", required_argument, NULL, 'B'},
+	{"tolerance", required_argument, NULL, 'T'},
+	{"timeline", required_argument, NULL, 'k'},
+	{"timeline-dir", required_argument, NULL, 'D'},
+	{"dump", required_argument, NULL, 'd'},
+	{"verify-lines", required_argument, NULL, 'S'},
+	{"stream", no_argument, NULL, 'R'},
+	{NULL, 0, NULL, 0}};
+
 /* Directory where default tracefiles are found */
 static char tracedir[MAXLINE] = TRACEDIR;
 
@@ -115,15 +278,31 @@ static char *default_tracefiles[] = {
  * Function prototypes
  *********************/
 
-/* these functions manipulate range lists */
-static int add_range(range_t **ranges, char *lo, int size,
+/* these functions manipulate the range tree */
+static int add_range(range_t **ranges, char *lo, size_t size,
 					 int tracenum, int opnum);
 static void remove_range(range_t **ranges, char *lo);
 static void clear_ranges(range_t **ranges);
+static range_t *range_alloc(void);
+static void range_release(range_t *p);
+static range_t *range_balance(range_t *p);
+static range_t *range_insert(range_t *root, range_t *node);
+static range_t *range_delete(range_t *root, char *lo);
 
 /* These functions read, allocate, and free storage for traces */
 static trace_t *read_trace(char *tracedir, char *filename);
+static void alloc_trace_arrays(trace_t *trace);
+static void read_binary_trace(trace_t *trace, char *path);
 static void free_trace(trace_t *trace);
+static void set_lifetime_hints(trace_t *trace);
+
+/* These functions replay a trace with one arena per group of ids */
+static void set_arena_groups(trace_t *trace);
+static void reset_arenas(trace_t *trace);
+static char *arena_malloc(trace_t *trace, int index, size_t size);
+static char *arena_realloc(trace_t *trace, int index, size_t size);
+static void arena_free(trace_t *trace, int index);
+static void arena_skip(int tracenum, int opnum);
 
 /* Routines for evaluating the correctness and speed of libc malloc */
 static int eval_libc_valid(trace_t *trace, int tracenum);
@@ -132,14 +311,45 @@ static void eval_libc_speed(void *ptr);
 /* Routines for evaluating correctnes, space utilization, and speed
    of the student's malloc package in mm.c */
 static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges);
+static int bytes_differ(const char *p, size_t n, int byte);
+static size_t sample_line(int k, size_t nlines);
+static void fill_payload(char *p, size_t size, int byte);
+static int check_payload(char *p, size_t size, size_t limit, int byte);
 static double eval_mm_util(trace_t *trace, int tracenum, range_t **ranges);
+static void output_path(char *path, int len, char *tracefile, char *suffix);
+static FILE *open_timeline(char *tracefile);
+static void sample_timeline(int op, size_t live);
+static void parse_dumps(char *list);
+static void dump_snapshot(int op, size_t live);
 static void eval_mm_speed(void *ptr);
+static void eval_mm_latency(trace_t *trace, latency_t *lat);
+static void eval_null_speed(void *ptr);
+static void eval_mm_stream(char *path, int tracenum, stream_stats_t *st);
+static void bench_mm_speed(speed_t *params, stats_t *stats);
 
 /* Various helper routines */
 static void printresults(int n, stats_t *stats);
+static void printheap(int n, stats_t *stats);
+static void printlatency(int n, stats_t *stats, latency_t *lat);
+static void printbench(int n, stats_t *stats);
+static void printcounters(int n, stats_t *stats);
+static void printstream(int n, stream_stats_t *st);
+#ifdef MM_STATS
+static void printmmstats(int n, stats_t *stats);
+#endif
+#ifdef MM_PROFILE
+static void printprofile(int n, stats_t *stats);
+#endif
+
+/* These functions write results files and compare against a baseline */
+static void write_results(char *path, int n, char **names, stats_t *stats,
+						  latency_t *lat, double perfindex);
+static void read_baseline(char *path, int n, char **names, baseline_t *base);
+static int compare_baseline(int n, char **names, stats_t *stats, baseline_t *base);
 static void usage(void);
 static void unix_error(char *msg);
 static void malloc_error(int tracenum, int opnum, char *msg);
+static void stream_error(int tracenum, unsigned long long opnum, char *msg);
 static void app_error(char *msg);
 
 /**************
@@ -155,6 +365,7 @@ int main(int argc, char **argv)
 	range_t *ranges = NULL;		/* keeps track of block extents for one trace */
 	stats_t *libc_stats = NULL; /* libc stats for each trace */
 	stats_t *mm_stats = NULL;	/* mm (i.e. student) stats for each trace */
+	latency_t *mm_lat = NULL;	/* mm per-request latencies for each trace (-L) */
 	speed_t speed_params;		/* input parameters to the xx_speed routines */
 
 	int team_check = 1; /* If set, check team structure (reset by -a) */
@@ -164,11 +375,14 @@ int main(int argc, char **argv)
 	/* temporaries used to compute the performance index */
 	double secs, ops, util, avg_mm_util, avg_mm_throughput, p1, p2, perfindex;
 	int numcorrect;
+	int regressions = 0;
+	baseline_t *baseline = NULL;
 
 	/*
 	 * Read and interpret the command line arguments
 	 */
-	while ((c = getopt(argc, argv, "f:t:hvVgal")) != EOF)
+	while ((c = getopt_long(argc, argv, "f:t:H:A:L:r:w:c:o:B:T:k:D:d:S:ehvVgalR",
+							long_options, NULL)) != EOF)
 	{
 		printf("getopt returned: %d\n", c); // 디버깅용 출력 추가
 
@@ -192,6 +406,96 @@ int main(int argc, char **argv)
 			if (tracedir[strlen(tracedir) - 1] != '/')
 				strcat(tracedir, "/"); /* path always ends with "/" */
 			break;
+		case 'H': /* Derive lifetime hints from the trace */
+			hint_window = atoi(optarg);
+			if (hint_window <= 0)
+			{
+				usage();
+				exit(1);
+			}
+			break;
+		case 'A': /* Replay each group of ids in its own arena */
+			arena_group = atoi(optarg);
+			if (arena_group <= 0)
+			{
+				usage();
+				exit(1);
+			}
+			break;
+		case 'L': /* Time every request, report the slowest ones */
+			lat_slowest = atoi(optarg);
+			if (lat_slowest <= 0)
+			{
+				usage();
+				exit(1);
+			}
+			break;
+		case 'r': /* Benchmark mode: time <n> separate runs of each trace */
+			bench_reps = atoi(optarg);
+			if (bench_reps <= 0)
+			{
+				usage();
+				exit(1);
+			}
+			break;
+		case 'w': /* Untimed warmup runs in benchmark mode */
+			bench_warmups = atoi(optarg);
+			if (bench_warmups < 0)
+			{
+				usage();
+				exit(1);
+			}
+			break;
+		case 'c': /* Pin the driver to one cpu */
+			bench_cpu = atoi(optarg);
+			if (bench_cpu < 0)
+			{
+				usage();
+				exit(1);
+			}
+			break;
+		case 'o': /* Write the results to a JSON or CSV file */
+			output_file = optarg;
+			break;
+		case 'B': /* Compare against the results file of an earlier run */
+			baseline_file = optarg;
+			break;
+		case 'T': /* Slowdown (percent) that counts as a regression */
+			tolerance = atof(optarg);
+			if (tolerance < 0)
+			{
+				usage();
+				exit(1);
+			}
+			break;
+		case 'k': /* Fragmentation timeline: sample every <n> ops */
+			timeline_every = atoi(optarg);
+			if (timeline_every <= 0)
+			{
+				usage();
+				exit(1);
+			}
+			break;
+		case 'D': /* Directory for the timeline and snapshot files */
+			timeline_dir = optarg;
+			break;
+		case 'd': /* Dump heap snapshots before these ops */
+			parse_dumps(optarg);
+			break;
+		case 'S': /* Check only a sample of lines of each payload */
+			verify_lines = atoi(optarg);
+			if (verify_lines <= 0)
+			{
+				usage();
+				exit(1);
+			}
+			break;
+		case 'R': /* Stream the traces instead of loading them */
+			stream_mode = 1;
+			break;
+		case 'e': /* Count hardware events with perf_event_open */
+			count_events = 1;
+			break;
 		case 'a': /* Don't check team structure */
 			team_check = 0;
 			break;
@@ -213,6 +517,22 @@ int main(int argc, char **argv)
 		}
 	}
 
+	if (arena_group > 0 && hint_window > 0)
+		app_error("The -A and -H options are mutually exclusive");
+
+	/* Pin to one cpu so migrations don't show up as noise */
+	if (bench_cpu >= 0)
+	{
+		cpu_set_t set;
+
+		CPU_ZERO(&set);
+		CPU_SET(bench_cpu, &set);
+		if (sched_setaffinity(0, sizeof(set), &set) < 0)
+			unix_error("sched_setaffinity failed in main");
+		if (verbose)
+			printf("Pinned to cpu %d\n", bench_cpu);
+	}
+
 	/*
 	 * Check and print team info
 	 */
@@ -258,6 +578,18 @@ int main(int argc, char **argv)
 	/* Initialize the timing package */
 	init_fsecs();
 
+	/* Open the hardware counters; carry on without them if we can't */
+	if (count_events)
+	{
+		if (perfctr_open() == 0)
+		{
+			printf("Hardware counters unavailable: %s\n", perfctr_error());
+			count_events = 0;
+		}
+		else if (perfctr_error() != NULL && verbose)
+			printf("Some hardware counters unavailable: %s\n", perfctr_error());
+	}
+
 	/*
 	 * Optionally run and evaluate the libc malloc package
 	 */
@@ -307,10 +639,35 @@ int main(int argc, char **argv)
 	mm_stats = (stats_t *)calloc(num_tracefiles, sizeof(stats_t));
 	if (mm_stats == NULL)
 		unix_error("mm_stats calloc in main failed");
+	if (lat_slowest > 0 &&
+		(mm_lat = (latency_t *)calloc(num_tracefiles, sizeof(latency_t))) == NULL)
+		unix_error("mm_lat calloc in main failed");
 
 	/* Initialize the simulated memory system in memlib.c */
 	mem_init();
 
+	/* Streaming replay (-R): one pass over each trace, no other runs */
+	if (stream_mode)
+	{
+		stream_stats_t *st;
+		char path[MAXLINE];
+
+		if ((st = (stream_stats_t *)calloc(num_tracefiles, sizeof(stream_stats_t))) == NULL)
+			unix_error("stream stats calloc in main failed");
+		for (i = 0; i < num_tracefiles; i++)
+		{
+			strcpy(path, tracedir);
+			strcat(path, tracefiles[i]);
+			if (verbose > 1)
+				printf("Streaming %s\n", path);
+			eval_mm_stream(path, i, &st[i]);
+		}
+		printf("\nStreaming replay of mm malloc:\n");
+		printstream(num_tracefiles, st);
+		free(st);
+		exit(errors > 0);
+	}
+
 	/* Evaluate student's mm malloc package using the K-best scheme */
 	for (i = 0; i < num_tracefiles; i++)
 	{
@@ -319,16 +676,50 @@ int main(int argc, char **argv)
 		if (verbose > 1)
 			printf("Checking mm_malloc for correctness, ");
 		mm_stats[i].valid = eval_mm_valid(trace, i, &ranges);
+		mm_stats[i].skipped = !mm_stats[i].valid && arena_out_of_heap;
 		if (mm_stats[i].valid)
 		{
 			if (verbose > 1)
 				printf("efficiency, ");
+			if (timeline_every > 0)
+				timeline_fp = open_timeline(tracefiles[i]);
+			util_tracefile = tracefiles[i];
 			mm_stats[i].util = eval_mm_util(trace, i, &ranges);
+			if (timeline_fp != NULL)
+			{
+				fclose(timeline_fp);
+				timeline_fp = NULL;
+			}
+#ifdef MM_STATS
+			mm_stats[i].mm = util_stats;
+#endif
+#ifdef MM_PROFILE
+			mm_get_profile(&mm_stats[i].prof);
+#endif
+			mm_stats[i].sbrks = mem_sbrk_calls();
+			mm_stats[i].heapsize = mem_heapsize();
 			speed_params.trace = trace;
 			speed_params.ranges = ranges;
 			if (verbose > 1)
 				printf("and performance.\n");
-			mm_stats[i].secs = fsecs(eval_mm_speed, &speed_params);
+			if (bench_reps > 0)
+				bench_mm_speed(&speed_params, &mm_stats[i]);
+			else
+				mm_stats[i].secs = fsecs(eval_mm_speed, &speed_params);
+			if (count_events)
+			{
+				eval_mm_speed(&speed_params); /* warm up first */
+				perfctr_start();
+				eval_mm_speed(&speed_params);
+				perfctr_stop(mm_stats[i].counters);
+			}
+			if (lat_slowest > 0)
+				eval_mm_latency(trace, &mm_lat[i]);
+		}
+		if (lat_slowest > 0)
+		{
+			mm_lat[i].ops = trace->ops; /* keep the requests for the report */
+			trace->ops = NULL;
 		}
 		free_trace(trace);
 	}
@@ -338,6 +729,47 @@ int main(int argc, char **argv)
 	{
 		printf("\nResults for mm malloc:\n");
 		printresults(num_tracefiles, mm_stats);
+		printf("\nHeap growth for mm malloc:\n");
+		printheap(num_tracefiles, mm_stats);
+		printf("\n");
+	}
+
+	/* Display the benchmark statistics (-r) */
+	if (bench_reps > 0)
+	{
+		printf("\nBenchmark for mm malloc (%d runs, %d warmups, times in usecs):\n",
+			   bench_reps, bench_warmups);
+		printbench(num_tracefiles, mm_stats);
+		printf("\n");
+	}
+
+#ifdef MM_STATS
+	/* Display the allocator statistics (stats build) */
+	printf("\nAllocator statistics for mm malloc (util run):\n");
+	printmmstats(num_tracefiles, mm_stats);
+	printf("\n");
+#endif
+
+#ifdef MM_PROFILE
+	/* Display the per-function cycle breakdown (profile build) */
+	printf("\nCycles by function for mm malloc (util run):\n");
+	printprofile(num_tracefiles, mm_stats);
+	printf("\n");
+#endif
+
+	/* Display the hardware counters (-e) */
+	if (count_events)
+	{
+		printf("\nHardware counters for mm malloc (per request, one run):\n");
+		printcounters(num_tracefiles, mm_stats);
+		printf("\n");
+	}
+
+	/* Display the per-request latencies (-L) */
+	if (lat_slowest > 0)
+	{
+		printf("\nLatency for mm malloc (cycles per request):\n");
+		printlatency(num_tracefiles, mm_stats, mm_lat);
 		printf("\n");
 	}
 
@@ -350,20 +782,22 @@ int main(int argc, char **argv)
 	numcorrect = 0;
 	for (i = 0; i < num_tracefiles; i++)
 	{
-		secs += mm_stats[i].secs;
-		ops += mm_stats[i].ops;
-		util += mm_stats[i].util;
 		if (mm_stats[i].valid)
+		{
+			secs += mm_stats[i].secs;
+			ops += mm_stats[i].ops;
+			util += mm_stats[i].util;
 			numcorrect++;
+		}
 	}
-	avg_mm_util = util / num_tracefiles;
+	avg_mm_util = numcorrect > 0 ? util / numcorrect : 0;
 
 	/*
 	 * Compute and print the performance index
 	 */
 	if (errors == 0)
 	{
-		avg_mm_throughput = ops / secs;
+		avg_mm_throughput = secs > 0 ? ops / secs : 0;
 
 		p1 = UTIL_WEIGHT * avg_mm_util;
 		if (avg_mm_throughput > AVG_LIBC_THRUPUT)
@@ -394,26 +828,190 @@ int main(int argc, char **argv)
 		printf("perfidx:%.0f\n", perfindex);
 	}
 
+	/*
+	 * Optionally save the results and compare them against a baseline
+	 */
+	if (output_file != NULL)
+		write_results(output_file, num_tracefiles, tracefiles, mm_stats,
+					  mm_lat, perfindex);
+
+	if (baseline_file != NULL)
+	{
+		if ((baseline = (baseline_t *)calloc(num_tracefiles, sizeof(baseline_t))) == NULL)
+			unix_error("baseline calloc in main failed");
+		read_baseline(baseline_file, num_tracefiles, tracefiles, baseline);
+		printf("\nComparison against baseline %s:\n", baseline_file);
+		regressions = compare_baseline(num_tracefiles, tracefiles, mm_stats, baseline);
+		if (regressions > 0)
+		{
+			printf("%d regression(s) against the baseline\n", regressions);
+			exit(EXIT_REGRESSION);
+		}
+	}
+
+	if (count_events)
+		perfctr_close();
 	exit(0);
 }
 
 /*****************************************************************
- * The following routines manipulate the range list, which keeps
+ * The following routines manipulate the range tree, which keeps
  * track of the extent of every allocated block payload. We use the
- * range list to detect any overlapping allocated blocks.
+ * range tree to detect any overlapping allocated blocks: since the
+ * live payloads are disjoint, a new payload can only overlap its
+ * neighbours in address order, so every check, insert and delete
+ * takes O(log n) time.
  ****************************************************************/
 
+/* Free range records, linked through left */
+static range_t *range_pool = NULL;
+
+/*
+ * range_alloc - Take a range record from the pool, refilling the pool
+ *     a chunk at a time. Chunks are never returned to libc.
+ */
+static range_t *range_alloc(void)
+{
+	range_t *p;
+	int i;
+
+	if (range_pool == NULL)
+	{
+		if ((p = (range_t *)malloc(RANGE_CHUNK * sizeof(range_t))) == NULL)
+			unix_error("malloc error in range_alloc");
+		for (i = 0; i < RANGE_CHUNK; i++)
+			range_release(&p[i]);
+	}
+	p = range_pool;
+	range_pool = p->left;
+	return p;
+}
+
+/*
+ * range_release - Return a range record to the pool
+ */
+static void range_release(range_t *p)
+{
+	p->left = range_pool;
+	range_pool = p;
+}
+
+#define RANGE_HEIGHT(p) ((p) ? (p)->height : 0)
+
+/* Recompute the height of p from its children */
+static void range_height(range_t *p)
+{
+	int l = RANGE_HEIGHT(p->left), r = RANGE_HEIGHT(p->right);
+
+	p->height = 1 + (l > r ? l : r);
+}
+
+/* Rotate p's left child up; return the new subtree root */
+static range_t *range_rotate_right(range_t *p)
+{
+	range_t *q = p->left;
+
+	p->left = q->right;
+	q->right = p;
+	range_height(p);
+	range_height(q);
+	return q;
+}
+
+/* Rotate p's right child up; return the new subtree root */
+static range_t *range_rotate_left(range_t *p)
+{
+	range_t *q = p->right;
+
+	p->right = q->left;
+	q->left = p;
+	range_height(p);
+	range_height(q);
+	return q;
+}
+
+/*
+ * range_balance - Restore the AVL property at p after one of its
+ *     subtrees changed height by one; return the new subtree root
+ */
+static range_t *range_balance(range_t *p)
+{
+	int diff = RANGE_HEIGHT(p->left) - RANGE_HEIGHT(p->right);
+
+	if (diff > 1)
+	{
+		if (RANGE_HEIGHT(p->left->left) < RANGE_HEIGHT(p->left->right))
+			p->left = range_rotate_left(p->left);
+		return range_rotate_right(p);
+	}
+	if (diff < -1)
+	{
+		if (RANGE_HEIGHT(p->right->right) < RANGE_HEIGHT(p->right->left))
+			p->right = range_rotate_right(p->right);
+		return range_rotate_left(p);
+	}
+	range_height(p);
+	return p;
+}
+
+/*
+ * range_insert - Insert node (not overlapping any range in the tree);
+ *     return the new root
+ */
+static range_t *range_insert(range_t *root, range_t *node)
+{
+	if (root == NULL)
+		return node;
+	if (node->lo < root->lo)
+		root->left = range_insert(root->left, node);
+	else
+		root->right = range_insert(root->right, node);
+	return range_balance(root);
+}
+
+/*
+ * range_delete - Remove the range that starts at lo, if there is one,
+ *     and return its record to the pool; return the new root
+ */
+static range_t *range_delete(range_t *root, char *lo)
+{
+	range_t *p;
+
+	if (root == NULL)
+		return NULL;
+	if (lo < root->lo)
+		root->left = range_delete(root->left, lo);
+	else if (lo > root->lo)
+		root->right = range_delete(root->right, lo);
+	else
+	{
+		if (root->left == NULL || root->right == NULL)
+		{
+			p = (root->left != NULL) ? root->left : root->right;
+			range_release(root);
+			return p;
+		}
+		/* Two children: move the next range up into root's place */
+		for (p = root->right; p->left != NULL; p = p->left)
+			;
+		root->lo = p->lo;
+		root->hi = p->hi;
+		root->right = range_delete(root->right, p->lo);
+	}
+	return range_balance(root);
+}
+
 /*
  * add_range - As directed by request opnum in trace tracenum,
  *     we've just called the student's mm_malloc to allocate a block of
  *     size bytes at addr lo. After checking the block for correctness,
- *     we create a range struct for this block and add it to the range list.
+ *     we create a range struct for this block and add it to the range tree.
  */
-static int add_range(range_t **ranges, char *lo, int size,
+static int add_range(range_t **ranges, char *lo, size_t size,
 					 int tracenum, int opnum)
 {
 	char *hi = lo + size - 1;
-	range_t *p;
+	range_t *p, *below = NULL, *above = NULL;
 	char msg[MAXLINE];
 
 	assert(size > 0);
@@ -437,29 +1035,46 @@ static int add_range(range_t **ranges, char *lo, int size,
 		return 0;
 	}
 
-	/* The payload must not overlap any other payloads */
-	for (p = *ranges; p != NULL; p = p->next)
+	/*
+	 * The payload must not overlap any other payloads. Only the range
+	 * starting at or below lo and the one starting above it can.
+	 */
+	for (p = *ranges; p != NULL;)
 	{
-		if ((lo >= p->lo && lo <= p->hi) ||
-			(hi >= p->lo && hi <= p->hi))
+		if (p->lo <= lo)
 		{
-			sprintf(msg, "Payload (%p:%p) overlaps another payload (%p:%p)\n",
-					lo, hi, p->lo, p->hi);
-			malloc_error(tracenum, opnum, msg);
-			return 0;
+			below = p;
+			p = p->right;
+		}
+		else
+		{
+			above = p;
+			p = p->left;
 		}
 	}
+	p = NULL;
+	if (below != NULL && below->hi >= lo)
+		p = below;
+	else if (above != NULL && above->lo <= hi)
+		p = above;
+	if (p != NULL)
+	{
+		sprintf(msg, "Payload (%p:%p) overlaps another payload (%p:%p)\n",
+				lo, hi, p->lo, p->hi);
+		malloc_error(tracenum, opnum, msg);
+		return 0;
+	}
 
 	/*
 	 * Everything looks OK, so remember the extent of this block
-	 * by creating a range struct and adding it the range list.
+	 * by creating a range struct and adding it the range tree.
 	 */
-	if ((p = (range_t *)malloc(sizeof(range_t))) == NULL)
-		unix_error("malloc error in add_range");
-	p->next = *ranges;
+	p = range_alloc();
 	p->lo = lo;
 	p->hi = hi;
-	*ranges = p;
+	p->left = p->right = NULL;
+	p->height = 1;
+	*ranges = range_insert(*ranges, p);
 	return 1;
 }
 
@@ -468,21 +1083,7 @@ static int add_range(range_t **ranges, char *lo, int size,
  */
 static void remove_range(range_t **ranges, char *lo)
 {
-	range_t *p;
-	range_t **prevpp = ranges;
-	int size;
-
-	for (p = *ranges; p != NULL; p = p->next)
-	{
-		if (p->lo == lo)
-		{
-			*prevpp = p->next;
-			size = p->hi - p->lo + 1;
-			free(p);
-			break;
-		}
-		prevpp = &(p->next);
-	}
+	*ranges = range_delete(*ranges, lo);
 }
 
 /*
@@ -490,14 +1091,13 @@ static void remove_range(range_t **ranges, char *lo)
  */
 static void clear_ranges(range_t **ranges)
 {
-	range_t *p;
-	range_t *pnext;
+	range_t *p = *ranges;
 
-	for (p = *ranges; p != NULL; p = pnext)
-	{
-		pnext = p->next;
-		free(p);
-	}
+	if (p == NULL)
+		return;
+	clear_ranges(&p->left);
+	clear_ranges(&p->right);
+	range_release(p);
 	*ranges = NULL;
 }
 
@@ -525,9 +1125,17 @@ static trace_t *read_trace(char *tracedir, char *filename)
 	if ((trace = (trace_t *)malloc(sizeof(trace_t))) == NULL)
 		unix_error("malloc 1 failed in read_trance");
 
-	/* Read the trace file header */
 	strcpy(path, tracedir);
 	strcat(path, filename);
+
+	/* Binary traces are mapped and decoded in one pass */
+	if (traceio_is_binary(path) == 1)
+	{
+		read_binary_trace(trace, path);
+		goto loaded;
+	}
+
+	/* Read the trace file header */
 	if ((tracefile = fopen(path, "r")) == NULL)
 	{
 		sprintf(msg, "Could not open %s in read_trace", path);
@@ -538,20 +1146,7 @@ static trace_t *read_trace(char *tracedir, char *filename)
 	fscanf(tracefile, "%d", &(trace->num_ops));
 	fscanf(tracefile, "%d", &(trace->weight)); /* not used */
 
-	/* We'll store each request line in the trace in this array */
-	if ((trace->ops =
-			 (traceop_t *)malloc(trace->num_ops * sizeof(traceop_t))) == NULL)
-		unix_error("malloc 2 failed in read_trace");
-
-	/* We'll keep an array of pointers to the allocated blocks here... */
-	if ((trace->blocks =
-			 (char **)malloc(trace->num_ids * sizeof(char *))) == NULL)
-		unix_error("malloc 3 failed in read_trace");
-
-	/* ... along with the corresponding byte sizes of each block */
-	if ((trace->block_sizes =
-			 (size_t *)malloc(trace->num_ids * sizeof(size_t))) == NULL)
-		unix_error("malloc 4 failed in read_trace");
+	alloc_trace_arrays(trace);
 
 	/* read every request line in the trace file */
 	index = 0;
@@ -565,6 +1160,7 @@ static trace_t *read_trace(char *tracedir, char *filename)
 			trace->ops[op_index].type = ALLOC;
 			trace->ops[op_index].index = index;
 			trace->ops[op_index].size = size;
+			trace->ops[op_index].hint = MM_HINT_LONG;
 			max_index = (index > max_index) ? index : max_index;
 			break;
 		case 'r':
@@ -584,80 +1180,364 @@ static trace_t *read_trace(char *tracedir, char *filename)
 				   type[0], path);
 			exit(1);
 		}
+		fscanf(tracefile, "%*[^\n]"); /* e.g. a thread tag */
 		op_index++;
 	}
 	fclose(tracefile);
 	assert(max_index == trace->num_ids - 1);
 	assert(trace->num_ops == op_index);
 
-	return trace;
-}
+loaded:
+	if (hint_window > 0)
+		set_lifetime_hints(trace);
 
-/*
- * free_trace - Free the trace record and the three arrays it points
- *              to, all of which were allocated in read_trace().
- */
-void free_trace(trace_t *trace)
-{
-	free(trace->ops); /* free the three arrays... */
-	free(trace->blocks);
-	free(trace->block_sizes);
-	free(trace); /* and the trace record itself... */
-}
+	/* In arena mode, keep one arena per group of arena_group ids */
+	trace->arenas = NULL;
+	trace->arena_live = NULL;
+	trace->arena_heap = NULL;
+	trace->arena_sizes = NULL;
+	if (arena_group > 0)
+	{
+		int num_groups = (trace->num_ids + arena_group - 1) / arena_group;
+
+		if ((trace->arenas =
+				 (mm_arena_t **)malloc(num_groups * sizeof(mm_arena_t *))) == NULL ||
+			(trace->arena_live = (int *)malloc(num_groups * sizeof(int))) == NULL ||
+			(trace->arena_heap = (char *)malloc(num_groups)) == NULL ||
+			(trace->arena_sizes =
+				 (size_t *)malloc(trace->num_ids * sizeof(size_t))) == NULL)
+			unix_error("malloc 5 failed in read_trace");
+		set_arena_groups(trace);
+	}
 
-/**********************************************************************
- * The following functions evaluate the correctness, space utilization,
- * and throughput of the libc and mm malloc packages.
- **********************************************************************/
+	return trace;
+}
 
 /*
- * eval_mm_valid - Check the mm malloc package for correctness
+ * set_lifetime_hints - Mark every alloc request whose block is freed
+ *     within hint_window ops as MM_HINT_SHORT. The hints come from the
+ *     trace itself, so they are a perfect lifetime predictor and give
+ *     an upper bound on what lifetime-aware placement can buy.
  */
-static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges)
+static void set_lifetime_hints(trace_t *trace)
 {
-	int i, j;
-	int index;
-	int size;
-	int oldsize;
-	char *newp;
-	char *oldp;
-	char *p;
-
-	/* Reset the heap and free any records in the range list */
-	mem_reset_brk();
-	clear_ranges(ranges);
+	int i, index;
+	int nshort = 0, nalloc = 0;
+	int *alloc_op; /* op number of the most recent alloc of each id */
 
-	/* Call the mm package's init function */
-	if (mm_init() < 0)
-	{
-		malloc_error(tracenum, 0, "mm_init failed.");
-		return 0;
-	}
+	if ((alloc_op = (int *)malloc(trace->num_ids * sizeof(int))) == NULL)
+		unix_error("malloc failed in set_lifetime_hints");
 
-	/* Interpret each operation in the trace in order */
 	for (i = 0; i < trace->num_ops; i++)
 	{
 		index = trace->ops[i].index;
-		size = trace->ops[i].size;
-
 		switch (trace->ops[i].type)
 		{
-
-		case ALLOC: /* mm_malloc */
-
-			/* Call the student's malloc */
-			if ((p = mm_malloc(size)) == NULL)
+		case ALLOC:
+			alloc_op[index] = i;
+			nalloc++;
+			break;
+		case FREE:
+			if (i - alloc_op[index] <= hint_window)
 			{
-				malloc_error(tracenum, i, "mm_malloc failed.");
-				return 0;
+				trace->ops[alloc_op[index]].hint = MM_HINT_SHORT;
+				nshort++;
 			}
+			break;
+		default:
+			break;
+		}
+	}
+	free(alloc_op);
 
-			/*
-			 * Test the range of the new block for correctness and add it
-			 * to the range list if OK. The block must be  be aligned properly,
-			 * and must not overlap any currently allocated block.
-			 */
-			if (add_range(ranges, p, size, tracenum, i) == 0)
+	if (verbose > 1)
+		printf("Lifetime hints: %d of %d allocs freed within %d ops\n",
+			   nshort, nalloc, hint_window);
+}
+
+/*
+ * alloc_trace_arrays - Allocate the ops, blocks and block_sizes arrays
+ *     of a trace whose header has been read
+ */
+static void alloc_trace_arrays(trace_t *trace)
+{
+	/* We'll store each request line in the trace in this array */
+	if ((trace->ops =
+			 (traceop_t *)malloc(trace->num_ops * sizeof(traceop_t))) == NULL)
+		unix_error("malloc 2 failed in read_trace");
+
+	/* We'll keep an array of pointers to the allocated blocks here... */
+	if ((trace->blocks =
+			 (char **)malloc(trace->num_ids * sizeof(char *))) == NULL)
+		unix_error("malloc 3 failed in read_trace");
+
+	/* ... along with the corresponding byte sizes of each block */
+	if ((trace->block_sizes =
+			 (size_t *)malloc(trace->num_ids * sizeof(size_t))) == NULL)
+		unix_error("malloc 4 failed in read_trace");
+}
+
+/*
+ * read_binary_trace - Fill in trace from a binary trace file (traceio.h)
+ */
+static void read_binary_trace(trace_t *trace, char *path)
+{
+	traceio_t *t;
+	traceio_op_t op;
+	int i, rc;
+
+	if ((t = traceio_open(path)) == NULL)
+	{
+		sprintf(msg, "Could not open binary trace %s in read_trace", path);
+		unix_error(msg);
+	}
+	if (t->hdr->num_ids > INT_MAX || t->hdr->num_ops > INT_MAX)
+	{
+		sprintf(msg, "Trace %s is too big for mdriver", path);
+		app_error(msg);
+	}
+	trace->sugg_heapsize = (int)t->hdr->sugg_heapsize;
+	trace->num_ids = (int)t->hdr->num_ids;
+	trace->num_ops = (int)t->hdr->num_ops;
+	trace->weight = (int)t->hdr->weight;
+	alloc_trace_arrays(trace);
+
+	for (i = 0; (rc = traceio_next(t, &op)) > 0; i++)
+	{
+		if (i == trace->num_ops || op.id >= t->hdr->num_ids)
+			break;
+		if (op.type == TRACEIO_ALLOC)
+			trace->ops[i].type = ALLOC;
+		else if (op.type == TRACEIO_FREE)
+			trace->ops[i].type = FREE;
+		else
+			trace->ops[i].type = REALLOC;
+		trace->ops[i].index = (int)op.id;
+		trace->ops[i].size = op.size;
+		trace->ops[i].hint = MM_HINT_LONG;
+	}
+	if (rc != 0 || i != trace->num_ops)
+	{
+		sprintf(msg, "Corrupt binary trace %s (op %d)", path, i);
+		app_error(msg);
+	}
+	traceio_close(t);
+}
+
+/*
+ * free_trace - Free the trace record and the three arrays it points
+ *              to, all of which were allocated in read_trace().
+ */
+void free_trace(trace_t *trace)
+{
+	free(trace->ops); /* free the three arrays... */
+	free(trace->blocks);
+	free(trace->block_sizes);
+	free(trace->arenas); /* ... the arena bookkeeping, if any... */
+	free(trace->arena_live);
+	free(trace->arena_heap);
+	free(trace->arena_sizes);
+	free(trace); /* and the trace record itself... */
+}
+
+/*****************************************************************
+ * The following routines replay a trace in arena mode (-A). Ids
+ * are grouped arena_group at a time, and every group allocates from
+ * its own arena. Individual frees only count down the group's live
+ * blocks; when the last one dies the whole arena is released at once.
+ * This models request handlers whose objects all die together; a
+ * group that frees a block before its last allocation doesn't, and
+ * is replayed with mm_malloc instead.
+ ****************************************************************/
+
+/*
+ * set_arena_groups - Mark the groups whose blocks don't die together,
+ *     i.e. that free a block before they allocate or grow their last
+ */
+static void set_arena_groups(trace_t *trace)
+{
+	int num_groups = (trace->num_ids + arena_group - 1) / arena_group;
+	int i, group, nheap = 0;
+	char *freed; /* has the group freed a block yet? */
+
+	if ((freed = (char *)calloc(num_groups, 1)) == NULL)
+		unix_error("calloc failed in set_arena_groups");
+	memset(trace->arena_heap, 0, num_groups);
+
+	for (i = 0; i < trace->num_ops; i++)
+	{
+		group = trace->ops[i].index / arena_group;
+		if (trace->ops[i].type == FREE)
+			freed[group] = 1;
+		else if (freed[group] && !trace->arena_heap[group])
+		{
+			trace->arena_heap[group] = 1;
+			nheap++;
+		}
+	}
+	free(freed);
+
+	if (verbose > 1)
+		printf("Arena groups: %d groups of %d ids, %d of them with mm_malloc\n",
+			   num_groups, arena_group, nheap);
+}
+
+/*
+ * reset_arenas - Forget all arenas; called right after mm_init, since
+ *     the arenas lived in the heap that was just reset.
+ */
+static void reset_arenas(trace_t *trace)
+{
+	int num_groups = (trace->num_ids + arena_group - 1) / arena_group;
+
+	memset(trace->arenas, 0, num_groups * sizeof(mm_arena_t *));
+	memset(trace->arena_live, 0, num_groups * sizeof(int));
+}
+
+/*
+ * arena_malloc - Allocate the block of id index from its group's
+ *     arena, creating the arena the first time the group allocates.
+ *     Its chunks hold arena_group blocks the size of that first
+ *     request, up to ARENA_MAX_CHUNK bytes.
+ */
+static char *arena_malloc(trace_t *trace, int index, size_t size)
+{
+	int group = index / arena_group;
+	size_t chunk_size;
+	char *p;
+
+	if (trace->arena_heap[group])
+		return mm_malloc(size);
+	if (trace->arenas[group] == NULL)
+	{
+		chunk_size = (size_t)arena_group * size;
+		if (chunk_size > ARENA_MAX_CHUNK)
+			chunk_size = ARENA_MAX_CHUNK;
+		if ((trace->arenas[group] = mm_arena_create(chunk_size)) == NULL)
+			return NULL;
+	}
+	if ((p = mm_arena_alloc(trace->arenas[group], size)) == NULL)
+		return NULL;
+	trace->arena_live[group]++;
+	trace->arena_sizes[index] = size;
+	return p;
+}
+
+/*
+ * arena_realloc - Shrink in place, grow in place when the arena can
+ *     (mm_arena_realloc), and otherwise copy into a fresh block; the
+ *     old one stays until reset
+ */
+static char *arena_realloc(trace_t *trace, int index, size_t size)
+{
+	int group = index / arena_group;
+	char *newp;
+
+	if (trace->arena_heap[group])
+		return mm_realloc(trace->blocks[index], size);
+	if ((newp = mm_arena_realloc(trace->arenas[group], trace->blocks[index],
+								 trace->arena_sizes[index], size)) == NULL)
+		return NULL;
+	if (size > trace->arena_sizes[index])
+		trace->arena_sizes[index] = size;
+	return newp;
+}
+
+/*
+ * arena_free - Release the block of id index. Nothing is returned to
+ *     the heap until the last live block of the group is freed; then
+ *     the arena goes too, so that dead groups don't pin the heap.
+ */
+static void arena_free(trace_t *trace, int index)
+{
+	int group = index / arena_group;
+
+	if (trace->arena_heap[group])
+		mm_free(trace->blocks[index]);
+	else if (--trace->arena_live[group] == 0)
+	{
+		mm_arena_destroy(trace->arenas[group]);
+		trace->arenas[group] = NULL;
+	}
+}
+
+/*
+ * arena_skip - The trace ran out of heap in arena mode, since its
+ *     groups keep their dead blocks until the last one is freed. Such
+ *     a trace doesn't suit arenas: report it and skip it, not fail.
+ */
+static void arena_skip(int tracenum, int opnum)
+{
+	arena_out_of_heap = 1;
+	printf("Skipping trace %d: out of heap at line %d with arenas of %d ids\n",
+		   tracenum, LINENUM(opnum), arena_group);
+}
+
+/**********************************************************************
+ * The following functions evaluate the correctness, space utilization,
+ * and throughput of the libc and mm malloc packages.
+ **********************************************************************/
+
+/*
+ * eval_mm_valid - Check the mm malloc package for correctness
+ */
+static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges)
+{
+	int i;
+	int index;
+	size_t size;
+	size_t oldsize;
+	char *newp;
+	char *oldp;
+	char *p;
+
+	/* Reset the heap and free any records in the range list */
+	mem_reset_brk();
+	clear_ranges(ranges);
+	arena_out_of_heap = 0;
+
+	/* Call the mm package's init function */
+	if (mm_init() < 0)
+	{
+		malloc_error(tracenum, 0, "mm_init failed.");
+		return 0;
+	}
+	if (arena_group > 0)
+		reset_arenas(trace);
+
+	/* Interpret each operation in the trace in order */
+	for (i = 0; i < trace->num_ops; i++)
+	{
+		index = trace->ops[i].index;
+		size = trace->ops[i].size;
+
+		switch (trace->ops[i].type)
+		{
+
+		case ALLOC: /* mm_malloc */
+
+			/* Call the student's malloc */
+			if (arena_group > 0)
+				p = arena_malloc(trace, index, size);
+			else if (hint_window > 0)
+				p = mm_malloc_hint(size, trace->ops[i].hint);
+			else
+				p = mm_malloc(size);
+			if (p == NULL)
+			{
+				if (arena_group > 0)
+					arena_skip(tracenum, i);
+				else
+					malloc_error(tracenum, i, "mm_malloc failed.");
+				return 0;
+			}
+
+			/*
+			 * Test the range of the new block for correctness and add it
+			 * to the range list if OK. The block must be  be aligned properly,
+			 * and must not overlap any currently allocated block.
+			 */
+			if (add_range(ranges, p, size, tracenum, i) == 0)
 				return 0;
 
 			/* ADDED: cgw
@@ -665,7 +1545,7 @@ static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges)
 			 * if we realloc the block and wish to make sure that the old
 			 * data was copied to the new block
 			 */
-			memset(p, index & 0xFF, size);
+			fill_payload(p, size, index & 0xFF);
 
 			/* Remember region */
 			trace->blocks[index] = p;
@@ -676,9 +1556,16 @@ static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges)
 
 			/* Call the student's realloc */
 			oldp = trace->blocks[index];
-			if ((newp = mm_realloc(oldp, size)) == NULL)
+			if (arena_group > 0)
+				newp = arena_realloc(trace, index, size);
+			else
+				newp = mm_realloc(oldp, size);
+			if (newp == NULL)
 			{
-				malloc_error(tracenum, i, "mm_realloc failed.");
+				if (arena_group > 0)
+					arena_skip(tracenum, i);
+				else
+					malloc_error(tracenum, i, "mm_realloc failed.");
 				return 0;
 			}
 
@@ -695,18 +1582,13 @@ static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges)
 			 * of the new index
 			 */
 			oldsize = trace->block_sizes[index];
-			if (size < oldsize)
-				oldsize = size;
-			for (j = 0; j < oldsize; j++)
+			if (!check_payload(newp, oldsize, size, index & 0xFF))
 			{
-				if (newp[j] != (index & 0xFF))
-				{
-					malloc_error(tracenum, i, "mm_realloc did not preserve the "
-											  "data from old block");
-					return 0;
-				}
+				malloc_error(tracenum, i, "mm_realloc did not preserve the "
+										  "data from old block");
+				return 0;
 			}
-			memset(newp, index & 0xFF, size);
+			fill_payload(newp, size, index & 0xFF);
 
 			/* Remember region */
 			trace->blocks[index] = newp;
@@ -718,7 +1600,10 @@ static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges)
 			/* Remove region from list and call student's free function */
 			p = trace->blocks[index];
 			remove_range(ranges, p);
-			mm_free(p);
+			if (arena_group > 0)
+				arena_free(trace, index);
+			else
+				mm_free(p);
 			break;
 
 		default:
@@ -730,6 +1615,113 @@ static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges)
 	return 1;
 }
 
+/*
+ * bytes_differ - Return true if any of the n bytes at p is not byte.
+ *     Compares 64 bytes per iteration with SSE2 where we have it, and
+ *     a word at a time otherwise; either way the bytes are compared as
+ *     unsigned.
+ */
+static int bytes_differ(const char *p, size_t n, int byte)
+{
+	size_t i = 0;
+#ifdef __SSE2__
+	__m128i want = _mm_set1_epi8((char)byte);
+	__m128i eq;
+
+	for (; i + 64 <= n; i += 64)
+	{
+		eq = _mm_and_si128(
+			_mm_and_si128(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p + i)), want),
+						  _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p + i + 16)), want)),
+			_mm_and_si128(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p + i + 32)), want),
+						  _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p + i + 48)), want)));
+		if (_mm_movemask_epi8(eq) != 0xFFFF)
+			return 1;
+	}
+	for (; i + 16 <= n; i += 16)
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p + i)), want)) != 0xFFFF)
+			return 1;
+#else
+	uint64_t want = 0x0101010101010101ULL * (unsigned char)byte;
+	uint64_t w;
+
+	for (; i + 8 <= n; i += 8)
+	{
+		memcpy(&w, p + i, 8); /* unaligned load */
+		if (w != want)
+			return 1;
+	}
+#endif
+	for (; i < n; i++) /* the tail */
+		if ((unsigned char)p[i] != byte)
+			return 1;
+	return 0;
+}
+
+/*
+ * sample_line - The k-th line (of verify_lines) to fill and check in a
+ *     payload of nlines lines: the first, the last and the others spread
+ *     evenly in between, so both ends of every block are always covered
+ */
+static size_t sample_line(int k, size_t nlines)
+{
+	if (nlines <= (size_t)verify_lines)
+		return k;
+	if (verify_lines == 1)
+		return nlines - 1;
+	return k * (nlines - 1) / (verify_lines - 1);
+}
+
+/*
+ * fill_payload - Fill a payload of size bytes with byte, or with -S just
+ *     the sampled lines of it
+ */
+static void fill_payload(char *p, size_t size, int byte)
+{
+	size_t line, nlines;
+	int k;
+
+	if (verify_lines == 0)
+	{
+		memset(p, byte, size);
+		return;
+	}
+	nlines = (size + VERIFY_LINE - 1) / VERIFY_LINE;
+	for (k = 0; k < verify_lines && (size_t)k < nlines; k++)
+	{
+		line = sample_line(k, nlines) * VERIFY_LINE;
+		memset(p + line, byte, (size - line < VERIFY_LINE) ? size - line : VERIFY_LINE);
+	}
+}
+
+/*
+ * check_payload - Check that a payload filled by fill_payload(p, size,
+ *     byte) still holds byte in its first limit bytes (the part realloc
+ *     must preserve); return 1 if it does
+ */
+static int check_payload(char *p, size_t size, size_t limit, int byte)
+{
+	size_t line, len, nlines;
+	int k;
+
+	if (limit > size)
+		limit = size;
+	if (verify_lines == 0)
+		return !bytes_differ(p, limit, byte);
+
+	nlines = (size + VERIFY_LINE - 1) / VERIFY_LINE;
+	for (k = 0; k < verify_lines && (size_t)k < nlines; k++)
+	{
+		line = sample_line(k, nlines) * VERIFY_LINE;
+		if (line >= limit)
+			break;
+		len = (limit - line < VERIFY_LINE) ? limit - line : VERIFY_LINE;
+		if (bytes_differ(p + line, len, byte))
+			return 0;
+	}
+	return 1;
+}
+
 /*
  * eval_mm_util - Evaluate the space utilization of the student's package
  *   The idea is to remember the high water mark "hwm" of the heap for
@@ -745,19 +1737,36 @@ static double eval_mm_util(trace_t *trace, int tracenum, range_t **ranges)
 {
 	int i;
 	int index;
-	int size, newsize, oldsize;
-	int max_total_size = 0;
-	int total_size = 0;
+	size_t size, newsize, oldsize;
+	size_t max_total_size = 0;
+	size_t total_size = 0;
 	char *p;
 	char *newp, *oldp;
+	int next_dump = 0; /* first of dump_ops[] not yet written */
+#ifdef MM_STATS
+	int peak_pending = 0; /* reached a new peak, not yet snapshotted */
+	mm_stats_t end;
+
+	memset(&util_stats, 0, sizeof(util_stats));
+#endif
 
 	/* initialize the heap and the mm malloc package */
 	mem_reset_brk();
 	if (mm_init() < 0)
 		app_error("mm_init failed in eval_mm_util");
+	if (arena_group > 0)
+		reset_arenas(trace);
+	if (timeline_fp != NULL)
+		sample_timeline(0, 0);
 
 	for (i = 0; i < trace->num_ops; i++)
 	{
+		if (timeline_fp != NULL && i > 0 && i % timeline_every == 0)
+			sample_timeline(i, total_size);
+		while (next_dump < num_dumps && dump_ops[next_dump] <= i)
+			if (dump_ops[next_dump++] == i)
+				dump_snapshot(i, total_size);
+
 		switch (trace->ops[i].type)
 		{
 
@@ -765,7 +1774,13 @@ static double eval_mm_util(trace_t *trace, int tracenum, range_t **ranges)
 			index = trace->ops[i].index;
 			size = trace->ops[i].size;
 
-			if ((p = mm_malloc(size)) == NULL)
+			if (arena_group > 0)
+				p = arena_malloc(trace, index, size);
+			else if (hint_window > 0)
+				p = mm_malloc_hint(size, trace->ops[i].hint);
+			else
+				p = mm_malloc(size);
+			if (p == NULL)
 				app_error("mm_malloc failed in eval_mm_util");
 
 			/* Remember region and size */
@@ -777,6 +1792,9 @@ static double eval_mm_util(trace_t *trace, int tracenum, range_t **ranges)
 			total_size += size;
 
 			/* Update statistics */
+#ifdef MM_STATS
+			peak_pending |= (total_size > max_total_size);
+#endif
 			max_total_size = (total_size > max_total_size) ? total_size : max_total_size;
 			break;
 
@@ -786,7 +1804,11 @@ static double eval_mm_util(trace_t *trace, int tracenum, range_t **ranges)
 			oldsize = trace->block_sizes[index];
 
 			oldp = trace->blocks[index];
-			if ((newp = mm_realloc(oldp, newsize)) == NULL)
+			if (arena_group > 0)
+				newp = arena_realloc(trace, index, newsize);
+			else
+				newp = mm_realloc(oldp, newsize);
+			if (newp == NULL)
 				app_error("mm_realloc failed in eval_mm_util");
 
 			/* Remember region and size */
@@ -798,6 +1820,9 @@ static double eval_mm_util(trace_t *trace, int tracenum, range_t **ranges)
 			total_size += (newsize - oldsize);
 
 			/* Update statistics */
+#ifdef MM_STATS
+			peak_pending |= (total_size > max_total_size);
+#endif
 			max_total_size = (total_size > max_total_size) ? total_size : max_total_size;
 			break;
 
@@ -806,38 +1831,479 @@ static double eval_mm_util(trace_t *trace, int tracenum, range_t **ranges)
 			size = trace->block_sizes[index];
 			p = trace->blocks[index];
 
-			mm_free(p);
+#ifdef MM_STATS
+			/* The first free after a new peak: snapshot the heap */
+			if (peak_pending)
+			{
+				mm_get_stats(&util_stats);
+				peak_pending = 0;
+			}
+#endif
+
+			if (arena_group > 0)
+				arena_free(trace, index);
+			else
+				mm_free(p);
+
+			/* Keep track of current total size
+			 * of all allocated blocks */
+			total_size -= size;
+
+			break;
+
+		default:
+			app_error("Nonexistent request type in eval_mm_util");
+		}
+	}
+	if (timeline_fp != NULL)
+		sample_timeline(trace->num_ops, total_size);
+	if (next_dump < num_dumps) /* ops past the end dump the final heap */
+		dump_snapshot(trace->num_ops, total_size);
+
+#ifdef MM_STATS
+	/* Counters cover the whole run, live/free bytes come from the peak */
+	if (peak_pending)
+		mm_get_stats(&util_stats);
+	mm_get_stats(&end);
+	memcpy(end.live_bytes, util_stats.live_bytes, sizeof(end.live_bytes));
+	memcpy(end.free_bytes, util_stats.free_bytes, sizeof(end.free_bytes));
+	util_stats = end;
+#endif
+
+	return ((double)max_total_size / (double)mem_heapsize());
+}
+
+/*
+ * output_path - Name an output file of a trace:
+ *     <timeline_dir>/<trace name without .rep><suffix>
+ */
+static void output_path(char *path, int len, char *tracefile, char *suffix)
+{
+	char *name, *dot;
+
+	name = strrchr(tracefile, '/');
+	name = (name != NULL) ? name + 1 : tracefile;
+	snprintf(path, len, "%s/%s", timeline_dir, name);
+	if ((dot = strrchr(path, '.')) != NULL && strcmp(dot, ".rep") == 0)
+		*dot = '\0';
+	strncat(path, suffix, len - strlen(path) - 1);
+}
+
+/*
+ * open_timeline - Create the fragmentation timeline file of a trace,
+ *     <timeline_dir>/<trace>.timeline.csv
+ */
+static FILE *open_timeline(char *tracefile)
+{
+	char path[MAXLINE / 2]; /* leaves room for it in msg */
+	FILE *fp;
+
+	output_path(path, sizeof(path), tracefile, ".timeline.csv");
+	if ((fp = fopen(path, "w")) == NULL)
+	{
+		sprintf(msg, "Could not open %s in open_timeline", path);
+		unix_error(msg);
+	}
+	fprintf(fp, "op,live_bytes,heap_bytes,alloc_bytes,free_bytes,free_blocks,"
+				"largest_free,ext_frag,int_frag_bytes,int_frag,util\n");
+	if (verbose > 1)
+		printf("writing timeline %s, ", path);
+	return fp;
+}
+
+/*
+ * sample_timeline - Walk the heap after op ops, with live bytes of
+ *     payload requested, and write one line of the timeline.
+ *
+ *     ext_frag is 1 - largest free block / free bytes: 0 when all free
+ *     space is one block, close to 1 when it is scattered in small
+ *     pieces. Internal fragmentation is what the allocated blocks hold
+ *     beyond the requested payload (headers, footers, alignment and
+ *     unsplit tails); int_frag is its share of the allocated bytes.
+ */
+static void sample_timeline(int op, size_t live)
+{
+	void *cursor = NULL;
+	mm_block_t blk;
+	size_t alloc_bytes = 0, free_bytes = 0, largest = 0, heap = mem_heapsize();
+	long internal;
+	int nfree = 0;
+
+	while (mm_heap_walk(&cursor, &blk))
+	{
+		if (blk.alloc)
+			alloc_bytes += blk.size;
+		else
+		{
+			free_bytes += blk.size;
+			nfree++;
+			if (blk.size > largest)
+				largest = blk.size;
+		}
+	}
+	internal = (long)alloc_bytes - (long)live;
+
+	fprintf(timeline_fp, "%d,%lu,%lu,%lu,%lu,%d,%lu,%.4f,%ld,%.4f,%.4f\n",
+			op, (unsigned long)live, (unsigned long)heap, (unsigned long)alloc_bytes,
+			(unsigned long)free_bytes, nfree, (unsigned long)largest,
+			free_bytes ? 1.0 - (double)largest / free_bytes : 0.0,
+			internal, alloc_bytes ? (double)internal / alloc_bytes : 0.0,
+			heap ? (double)live / heap : 0.0);
+}
+
+static int cmp_int(const void *a, const void *b)
+{
+	return *(const int *)a - *(const int *)b;
+}
+
+/*
+ * parse_dumps - Parse the -d list of op numbers, e.g. 1000,5000,20000
+ */
+static void parse_dumps(char *list)
+{
+	char *tok, *end;
+
+	for (tok = strtok(list, ","); tok != NULL; tok = strtok(NULL, ","))
+	{
+		if (num_dumps == MAX_DUMPS)
+			app_error("Too many -d ops");
+		dump_ops[num_dumps] = strtol(tok, &end, 10);
+		if (*end != '\0' || dump_ops[num_dumps] < 0)
+		{
+			usage();
+			exit(1);
+		}
+		num_dumps++;
+	}
+	qsort(dump_ops, num_dumps, sizeof(int), cmp_int);
+}
+
+/*
+ * dump_snapshot - Write the heap layout after op ops, with live bytes
+ *     of payload requested, to <timeline_dir>/<trace>.<op>.snap
+ */
+static void dump_snapshot(int op, size_t live)
+{
+	char path[MAXLINE / 2], suffix[32];
+	void *cursor = NULL;
+	mm_block_t blk;
+	heapsnap_t *s;
+	uint64_t n = 0;
+
+	while (mm_heap_walk(&cursor, &blk))
+		n++;
+	if ((s = heapsnap_new(n)) == NULL)
+		unix_error("heapsnap_new failed in dump_snapshot");
+	s->hdr.op = op;
+	s->hdr.heap_size = mem_heapsize();
+	s->hdr.live_bytes = live;
+
+	n = 0;
+	cursor = NULL;
+	while (mm_heap_walk(&cursor, &blk))
+	{
+		if (n == 0)
+			s->hdr.first = (char *)blk.addr - WSIZE - (char *)mem_heap_lo();
+		s->size[n] = blk.size | (blk.alloc ? 1 : 0);
+		s->bin[n] = blk.bin;
+		n++;
+	}
+
+	sprintf(suffix, ".%d.snap", op);
+	output_path(path, sizeof(path), util_tracefile, suffix);
+	if (heapsnap_write(path, s) < 0)
+	{
+		sprintf(msg, "Could not write %s in dump_snapshot", path);
+		unix_error(msg);
+	}
+	if (verbose > 1)
+		printf("wrote snapshot %s, ", path);
+	heapsnap_free(s);
+}
+
+/*
+ * eval_mm_speed - This is the function that is used by fcyc()
+ *    to measure the running time of the mm malloc package.
+ */
+static void eval_mm_speed(void *ptr)
+{
+	int i, index;
+	size_t size, newsize;
+	char *p, *newp, *oldp, *block;
+	trace_t *trace = ((speed_t *)ptr)->trace;
+
+	/* Reset the heap and initialize the mm package */
+	mem_reset_brk();
+	if (mm_init() < 0)
+		app_error("mm_init failed in eval_mm_speed");
+	if (arena_group > 0)
+		reset_arenas(trace);
+
+	/* Interpret each trace request */
+	for (i = 0; i < trace->num_ops; i++)
+		switch (trace->ops[i].type)
+		{
+
+		case ALLOC: /* mm_malloc */
+			index = trace->ops[i].index;
+			size = trace->ops[i].size;
+			if (arena_group > 0)
+				p = arena_malloc(trace, index, size);
+			else if (hint_window > 0)
+				p = mm_malloc_hint(size, trace->ops[i].hint);
+			else
+				p = mm_malloc(size);
+			if (p == NULL)
+				app_error("mm_malloc error in eval_mm_speed");
+			trace->blocks[index] = p;
+			break;
+
+		case REALLOC: /* mm_realloc */
+			index = trace->ops[i].index;
+			newsize = trace->ops[i].size;
+			oldp = trace->blocks[index];
+			if (arena_group > 0)
+				newp = arena_realloc(trace, index, newsize);
+			else
+				newp = mm_realloc(oldp, newsize);
+			if (newp == NULL)
+				app_error("mm_realloc error in eval_mm_speed");
+			trace->blocks[index] = newp;
+			break;
+
+		case FREE: /* mm_free */
+			index = trace->ops[i].index;
+			block = trace->blocks[index];
+			if (arena_group > 0)
+				arena_free(trace, index);
+			else
+				mm_free(block);
+			break;
+
+		default:
+			app_error("Nonexistent request type in eval_mm_valid");
+		}
+}
+
+/*
+ * eval_null_speed - Replay the trace without calling the allocator:
+ *    the same loop, switch and trace loads as eval_mm_speed, with a
+ *    dummy pointer stored in place of each result. Its running time is
+ *    the interpreter overhead that benchmark mode subtracts.
+ */
+static void eval_null_speed(void *ptr)
+{
+	int i, index;
+	trace_t *trace = ((speed_t *)ptr)->trace;
+
+	mem_reset_brk();
+
+	for (i = 0; i < trace->num_ops; i++)
+		switch (trace->ops[i].type)
+		{
+		case ALLOC:
+		case REALLOC:
+			index = trace->ops[i].index;
+			trace->blocks[index] = (char *)trace->blocks + trace->ops[i].size;
+			break;
+
+		case FREE:
+			index = trace->ops[i].index;
+			trace->blocks[index] = NULL;
+			break;
+
+		default:
+			app_error("Nonexistent request type in eval_null_speed");
+		}
+}
+
+/*
+ * eval_mm_stream - Replay a trace through mm malloc as it is read (-R).
+ *    A reader thread decodes the ops in chunks while we replay the
+ *    previous chunk, and blocks are found through a hash map that only
+ *    holds the live ids, so the memory used besides the simulated heap
+ *    depends on the live set, not on the length of the trace. There is
+ *    no payload checking; the time covers the whole replay, including
+ *    any time spent waiting for the reader.
+ */
+static void eval_mm_stream(char *path, int tracenum, stream_stats_t *st)
+{
+	tracestream_t *s;
+	traceio_op_t *ops, *op;
+	idmap_t *map;
+	idmap_entry_t *e, old;
+	unsigned long long opnum = 0, live_bytes = 0;
+	struct timespec t0, t1;
+	long i, n;
+	char *p;
+
+	memset(st, 0, sizeof(stream_stats_t));
+	if ((s = tracestream_open(path, TRACESTREAM_CHUNK)) == NULL)
+	{
+		sprintf(msg, "Could not open %s in eval_mm_stream", path);
+		unix_error(msg);
+	}
+	if ((map = idmap_new()) == NULL)
+		unix_error("idmap_new failed in eval_mm_stream");
+
+	mem_reset_brk();
+	if (mm_init() < 0)
+	{
+		stream_error(tracenum, 0, "mm_init failed.");
+		goto out;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	while ((n = tracestream_next(s, &ops)) > 0)
+	{
+		for (i = 0; i < n; i++, opnum++)
+		{
+			op = &ops[i];
+			switch (op->type)
+			{
+			case TRACEIO_ALLOC: /* mm_malloc */
+				if ((p = mm_malloc(op->size)) == NULL)
+				{
+					stream_error(tracenum, opnum, "mm_malloc failed.");
+					goto out;
+				}
+				if ((e = idmap_put(map, op->id)) == NULL)
+					unix_error("idmap_put failed in eval_mm_stream");
+				if (e->ptr != NULL)
+				{
+					stream_error(tracenum, opnum, "Id allocated while still live.");
+					goto out;
+				}
+				e->ptr = p;
+				e->size = op->size;
+				live_bytes += op->size;
+				break;
+
+			case TRACEIO_REALLOC: /* mm_realloc */
+				e = idmap_get(map, op->id);
+				if ((p = mm_realloc(e != NULL ? e->ptr : NULL, op->size)) == NULL)
+				{
+					stream_error(tracenum, opnum, "mm_realloc failed.");
+					goto out;
+				}
+				if (e == NULL && (e = idmap_put(map, op->id)) == NULL)
+					unix_error("idmap_put failed in eval_mm_stream");
+				live_bytes = live_bytes - e->size + op->size;
+				e->ptr = p;
+				e->size = op->size;
+				break;
+
+			default: /* mm_free */
+				if (!idmap_remove(map, op->id, &old))
+				{
+					stream_error(tracenum, opnum, "Free of an id that is not live.");
+					goto out;
+				}
+				mm_free(old.ptr);
+				live_bytes -= old.size;
+				continue;
+			}
+
+			if ((uintptr_t)p % ALIGNMENT != 0)
+			{
+				stream_error(tracenum, opnum, "Payload address not aligned.");
+				goto out;
+			}
+			if (map->count > st->peak_ids)
+				st->peak_ids = map->count;
+			if (live_bytes > st->peak_bytes)
+				st->peak_bytes = live_bytes;
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	if (n < 0)
+	{
+		sprintf(msg, "Bad trace: %s", s->error);
+		stream_error(tracenum, opnum, msg);
+		goto out;
+	}
+	st->valid = 1;
+	st->secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+out:
+	st->ops = opnum;
+	st->stall = s->stall_secs;
+	st->heapsize = mem_heapsize();
+	st->harness = map->peak_cap * sizeof(idmap_entry_t) + 2 * TRACESTREAM_CHUNK * sizeof(traceio_op_t);
+	idmap_free(map);
+	tracestream_close(s);
+}
+
+/*
+ * bench_mm_speed - Benchmark mode (-r). After bench_warmups untimed
+ *    runs, time bench_reps separate runs of eval_mm_speed, interleaved
+ *    with runs of the empty replay loop so both see the same machine
+ *    conditions. The median null time is subtracted from every sample
+ *    before the samples are summarized, and the net median becomes the
+ *    trace's secs.
+ */
+static void bench_mm_speed(speed_t *params, stats_t *stats)
+{
+	int r;
+	double *mm_secs, *null_secs;
+	benchstat_t null_stat;
+
+	if ((mm_secs = (double *)malloc(bench_reps * sizeof(double))) == NULL ||
+		(null_secs = (double *)malloc(bench_reps * sizeof(double))) == NULL)
+		unix_error("malloc failed in bench_mm_speed");
 
-			/* Keep track of current total size
-			 * of all allocated blocks */
-			total_size -= size;
+	for (r = 0; r < bench_warmups; r++)
+	{
+		eval_null_speed(params);
+		eval_mm_speed(params);
+	}
+	for (r = 0; r < bench_reps; r++)
+	{
+		null_secs[r] = fsecs_once(eval_null_speed, params);
+		mm_secs[r] = fsecs_once(eval_mm_speed, params);
+	}
 
-			break;
+	benchstat(null_secs, bench_reps, &null_stat);
+	for (r = 0; r < bench_reps; r++)
+		mm_secs[r] = (mm_secs[r] > null_stat.median) ? mm_secs[r] - null_stat.median : 0;
+	benchstat(mm_secs, bench_reps, &stats->bench);
 
-		default:
-			app_error("Nonexistent request type in eval_mm_util");
-		}
-	}
+	stats->null_secs = null_stat.median;
+	stats->secs = stats->bench.median;
+	if (stats->secs <= 0) /* keep the throughput finite */
+		stats->secs = DBL_MIN;
 
-	return ((double)max_total_size / (double)mem_heapsize());
+	free(mm_secs);
+	free(null_secs);
 }
 
 /*
- * eval_mm_speed - This is the function that is used by fcyc()
- *    to measure the running time of the mm malloc package.
+ * eval_mm_latency - Replay the trace once more, timing every request
+ *    on its own with the cycle counter. The times go into one
+ *    histogram per request type, and the lat_slowest slowest requests
+ *    are kept so they can be traced back to their trace lines. The
+ *    replay itself only stores one timestamp difference per request;
+ *    the histograms are filled in afterwards.
  */
-static void eval_mm_speed(void *ptr)
+static void eval_mm_latency(trace_t *trace, latency_t *lat)
 {
-	int i, index, size, newsize;
+	int i, j, index;
+	size_t size, newsize;
 	char *p, *newp, *oldp, *block;
-	trace_t *trace = ((speed_t *)ptr)->trace;
+	unsigned long long start, *cycles;
+
+	if ((cycles = (unsigned long long *)malloc(trace->num_ops * sizeof(unsigned long long))) == NULL ||
+		(lat->slowest = (slowop_t *)malloc(lat_slowest * sizeof(slowop_t))) == NULL)
+		unix_error("malloc failed in eval_mm_latency");
 
 	/* Reset the heap and initialize the mm package */
 	mem_reset_brk();
 	if (mm_init() < 0)
-		app_error("mm_init failed in eval_mm_speed");
+		app_error("mm_init failed in eval_mm_latency");
+	if (arena_group > 0)
+		reset_arenas(trace);
 
-	/* Interpret each trace request */
+	/* Interpret and time each trace request */
 	for (i = 0; i < trace->num_ops; i++)
 		switch (trace->ops[i].type)
 		{
@@ -845,8 +2311,16 @@ static void eval_mm_speed(void *ptr)
 		case ALLOC: /* mm_malloc */
 			index = trace->ops[i].index;
 			size = trace->ops[i].size;
-			if ((p = mm_malloc(size)) == NULL)
-				app_error("mm_malloc error in eval_mm_speed");
+			start = read_cycles();
+			if (arena_group > 0)
+				p = arena_malloc(trace, index, size);
+			else if (hint_window > 0)
+				p = mm_malloc_hint(size, trace->ops[i].hint);
+			else
+				p = mm_malloc(size);
+			cycles[i] = read_cycles() - start;
+			if (p == NULL)
+				app_error("mm_malloc error in eval_mm_latency");
 			trace->blocks[index] = p;
 			break;
 
@@ -854,20 +2328,51 @@ static void eval_mm_speed(void *ptr)
 			index = trace->ops[i].index;
 			newsize = trace->ops[i].size;
 			oldp = trace->blocks[index];
-			if ((newp = mm_realloc(oldp, newsize)) == NULL)
-				app_error("mm_realloc error in eval_mm_speed");
+			start = read_cycles();
+			if (arena_group > 0)
+				newp = arena_realloc(trace, index, newsize);
+			else
+				newp = mm_realloc(oldp, newsize);
+			cycles[i] = read_cycles() - start;
+			if (newp == NULL)
+				app_error("mm_realloc error in eval_mm_latency");
 			trace->blocks[index] = newp;
 			break;
 
 		case FREE: /* mm_free */
 			index = trace->ops[i].index;
 			block = trace->blocks[index];
-			mm_free(block);
+			start = read_cycles();
+			if (arena_group > 0)
+				arena_free(trace, index);
+			else
+				mm_free(block);
+			cycles[i] = read_cycles() - start;
 			break;
 
 		default:
-			app_error("Nonexistent request type in eval_mm_valid");
+			app_error("Nonexistent request type in eval_mm_latency");
 		}
+
+	/* Fill in the histograms and keep the slowest requests, slowest first */
+	for (i = 0; i < 3; i++)
+		hist_reset(&lat->hist[i]);
+	lat->nslow = 0;
+	for (i = 0; i < trace->num_ops; i++)
+	{
+		hist_record(&lat->hist[trace->ops[i].type], cycles[i]);
+
+		if (lat->nslow == lat_slowest &&
+			cycles[i] <= lat->slowest[lat->nslow - 1].cycles)
+			continue;
+		if (lat->nslow < lat_slowest)
+			lat->nslow++;
+		for (j = lat->nslow - 1; j > 0 && lat->slowest[j - 1].cycles < cycles[i]; j--)
+			lat->slowest[j] = lat->slowest[j - 1];
+		lat->slowest[j].cycles = cycles[i];
+		lat->slowest[j].opnum = i;
+	}
+	free(cycles);
 }
 
 /*
@@ -878,7 +2383,8 @@ static void eval_mm_speed(void *ptr)
  */
 static int eval_libc_valid(trace_t *trace, int tracenum)
 {
-	int i, newsize;
+	int i;
+	size_t newsize;
 	char *p, *newp, *oldp;
 
 	for (i = 0; i < trace->num_ops; i++)
@@ -926,7 +2432,8 @@ static int eval_libc_valid(trace_t *trace, int tracenum)
 static void eval_libc_speed(void *ptr)
 {
 	int i;
-	int index, size, newsize;
+	int index;
+	size_t size, newsize;
 	char *p, *newp, *oldp, *block;
 	trace_t *trace = ((speed_t *)ptr)->trace;
 
@@ -971,6 +2478,7 @@ static void eval_libc_speed(void *ptr)
 static void printresults(int n, stats_t *stats)
 {
 	int i;
+	int nvalid = 0;
 	double secs = 0;
 	double ops = 0;
 	double util = 0;
@@ -992,12 +2500,13 @@ static void printresults(int n, stats_t *stats)
 			secs += stats[i].secs;
 			ops += stats[i].ops;
 			util += stats[i].util;
+			nvalid++;
 		}
 		else
 		{
 			printf("%2d%10s%6s%8s%10s%6s\n",
 				   i,
-				   "no",
+				   stats[i].skipped ? "skipped" : "no",
 				   "-",
 				   "-",
 				   "-",
@@ -1005,12 +2514,13 @@ static void printresults(int n, stats_t *stats)
 		}
 	}
 
-	/* Print the aggregate results for the set of traces */
-	if (errors == 0)
+	/* Print the aggregate results for the set of traces (skipped ones
+	   don't count) */
+	if (errors == 0 && nvalid > 0)
 	{
 		printf("%12s%5.0f%%%8.0f%10.6f%6.0f\n",
 			   "Total       ",
-			   (util / n) * 100.0,
+			   (util / nvalid) * 100.0,
 			   ops,
 			   secs,
 			   (ops / 1e3) / secs);
@@ -1026,6 +2536,675 @@ static void printresults(int n, stats_t *stats)
 	}
 }
 
+/*
+ * printheap - prints the number of mem_sbrk calls and the final heap
+ *     size of each trace, as measured during the util run
+ */
+static void printheap(int n, stats_t *stats)
+{
+	int i;
+
+	printf("%5s%8s%10s\n", "trace", "sbrks", "heap(KB)");
+	for (i = 0; i < n; i++)
+	{
+		if (stats[i].valid)
+			printf("%2d%11d%10.0f\n", i, stats[i].sbrks, stats[i].heapsize / 1024);
+		else
+			printf("%2d%11s%10s\n", i, "-", "-");
+	}
+}
+
+/*
+ * printstream - prints the results of the streaming replay: requests,
+ *     peak live ids and bytes, heap size and the utilization they give,
+ *     replay rate, time spent waiting for the reader, and the memory
+ *     the driver itself needed
+ */
+static void printstream(int n, stream_stats_t *st)
+{
+	int i;
+
+	printf("%5s%6s%12s%10s%11s%11s%6s%9s%9s%8s%10s\n", "trace", "valid", "ops",
+		   "peak ids", "peak(KB)", "heap(KB)", "util", "secs", "Kops", "stall", "drv(KB)");
+	for (i = 0; i < n; i++)
+	{
+		if (!st[i].valid)
+		{
+			printf("%2d%9s%12llu\n", i, "no", st[i].ops);
+			continue;
+		}
+		printf("%2d%9s%12llu%10llu%11.0f%11.0f%5.0f%%%9.3f%9.0f%7.1f%%%10.0f\n",
+			   i, "yes", st[i].ops, st[i].peak_ids, st[i].peak_bytes / 1024.0,
+			   st[i].heapsize / 1024, 100 * st[i].peak_bytes / st[i].heapsize, st[i].secs,
+			   st[i].secs > 0 ? st[i].ops / 1e3 / st[i].secs : 0,
+			   st[i].secs > 0 ? 100 * st[i].stall / st[i].secs : 0, st[i].harness / 1024.0);
+	}
+}
+
+/*
+ * printbench - prints the benchmark mode statistics of each trace:
+ *     net median, MAD, the 95% confidence interval of the median and
+ *     its half-width relative to the median, and the null loop time
+ *     that was subtracted
+ */
+static void printbench(int n, stats_t *stats)
+{
+	int i;
+	benchstat_t *b;
+
+	printf("%5s%10s%9s%10s%10s%7s%9s%8s\n",
+		   "trace", "median", "MAD", "CI lo", "CI hi", "+/-%", "null", "Kops");
+	for (i = 0; i < n; i++)
+	{
+		b = &stats[i].bench;
+		if (!stats[i].valid)
+		{
+			printf("%2d%13s\n", i, "-");
+			continue;
+		}
+		printf("%2d%13.2f%9.2f%10.2f%10.2f%7.1f%9.2f%8.0f\n",
+			   i, b->median * 1e6, b->mad * 1e6, b->lo * 1e6, b->hi * 1e6,
+			   (b->median > 0) ? 100 * (b->hi - b->lo) / 2 / b->median : 0,
+			   stats[i].null_secs * 1e6,
+			   (stats[i].ops / 1e3) / stats[i].secs);
+	}
+}
+
+/*
+ * printcounters - prints the hardware events of each trace divided by
+ *     the number of requests, and the instructions per cycle. Counters
+ *     the kernel wouldn't give us are shown as "-".
+ */
+static void printcounters(int n, stats_t *stats)
+{
+	int i, c;
+	double *v;
+	char *heads[PERFCTR_NUM] = {"cycles", "instrs", "L1D", "LLC", "dTLB", "br", "faults"};
+
+	printf("%5s", "trace");
+	for (c = 0; c < PERFCTR_NUM; c++)
+		printf("%9s", heads[c]);
+	printf("%7s\n", "IPC");
+
+	for (i = 0; i < n; i++)
+	{
+		v = stats[i].counters;
+		if (!stats[i].valid)
+		{
+			printf("%2d%12s\n", i, "-");
+			continue;
+		}
+		printf("%2d   ", i);
+		for (c = 0; c < PERFCTR_NUM; c++)
+		{
+			if (perfctr_available(c))
+				printf("%9.2f", v[c] / stats[i].ops);
+			else
+				printf("%9s", "-");
+		}
+		if (perfctr_available(PERFCTR_CYCLES) && perfctr_available(PERFCTR_INSTRUCTIONS) &&
+			v[PERFCTR_CYCLES] > 0)
+			printf("%7.2f\n", v[PERFCTR_INSTRUCTIONS] / v[PERFCTR_CYCLES]);
+		else
+			printf("%7s\n", "-");
+	}
+}
+
+#ifdef MM_STATS
+/*
+ * printmmstats - prints the allocator's own counters for each trace,
+ *     and in verbose mode the per size class hits, misses and live/free
+ *     bytes at the peak of the trace
+ */
+static void printmmstats(int n, stats_t *stats)
+{
+	int i, c;
+	mm_stats_t *m;
+	char label[32];
+
+	printf("%5s%9s%8s%6s%8s%8s%8s%8s%8s%6s%9s%7s%7s%11s\n",
+		   "trace", "fits", "visits", "max", "splits", "coal1", "coal2",
+		   "coal3", "coal4", "ext", "ext(KB)", "r-in", "r-mv", "r-copy(KB)");
+	for (i = 0; i < n; i++)
+	{
+		m = &stats[i].mm;
+		if (!stats[i].valid)
+		{
+			printf("%2d%12s\n", i, "-");
+			continue;
+		}
+		printf("%2d%12lu%8.1f%6lu%8lu%8lu%8lu%8lu%8lu%6lu%9.0f%7lu%7lu%11.0f\n",
+			   i, m->fit_calls,
+			   m->fit_calls ? (double)m->fit_visits / m->fit_calls : 0.0,
+			   m->fit_visits_max, m->splits,
+			   m->coalesce[0], m->coalesce[1], m->coalesce[2], m->coalesce[3],
+			   m->extend_calls, m->extend_bytes / 1024.0,
+			   m->realloc_inplace, m->realloc_moved, m->realloc_copied / 1024.0);
+	}
+
+	if (!verbose)
+		return;
+
+	for (i = 0; i < n; i++)
+	{
+		m = &stats[i].mm;
+		if (!stats[i].valid)
+			continue;
+		printf("\nTrace %d by size class (live/free bytes at peak):\n", i);
+		printf("%10s%9s%9s%11s%11s\n", "class", "hits", "misses", "live", "free");
+		for (c = 0; c < m->nclasses; c++)
+		{
+			if (!m->bin_hits[c] && !m->bin_misses[c] && !m->live_bytes[c] && !m->free_bytes[c])
+				continue;
+			if (m->class_max[c] > 0)
+				sprintf(label, "<=%lu", (unsigned long)m->class_max[c]);
+			else
+				sprintf(label, ">%lu", (unsigned long)m->class_max[c - 1]);
+			printf("%10s%9lu%9lu%11lu%11lu\n", label, m->bin_hits[c], m->bin_misses[c],
+				   (unsigned long)m->live_bytes[c], (unsigned long)m->free_bytes[c]);
+		}
+	}
+}
+#endif
+
+#ifdef MM_PROFILE
+/*
+ * printprofile - prints, for each trace, the calls and cycles of every
+ *     instrumented allocator function, the biggest self time first
+ */
+static void printprofile(int n, stats_t *stats)
+{
+	int i, j, k, f, order[MM_PROF_MAX];
+	unsigned long long sum;
+	mm_profile_t *p;
+
+	for (i = 0; i < n; i++)
+	{
+		p = &stats[i].prof;
+		if (!stats[i].valid)
+			continue;
+
+		/* Sort the functions by self cycles (insertion sort, few of them) */
+		sum = 0;
+		for (j = 0; j < p->nfuncs; j++)
+		{
+			sum += p->self[j];
+			for (k = j; k > 0 && p->self[order[k - 1]] < p->self[j]; k--)
+				order[k] = order[k - 1];
+			order[k] = j;
+		}
+
+		printf("%sTrace %d: %.0f cycles/op in the allocator\n", i ? "\n" : "",
+			   i, stats[i].ops ? (double)sum / stats[i].ops : 0.0);
+		printf("%20s%10s%14s%7s%11s%12s\n",
+			   "function", "calls", "self cycles", "self%", "self/call", "total/call");
+		for (j = 0; j < p->nfuncs; j++)
+		{
+			f = order[j];
+			if (p->calls[f] == 0)
+				continue;
+			printf("%20s%10lu%14llu%6.1f%%%11.1f%12.1f\n", p->name[f], p->calls[f],
+				   p->self[f], sum ? 100.0 * p->self[f] / sum : 0.0,
+				   (double)p->self[f] / p->calls[f],
+				   (double)p->total[f] / p->calls[f]);
+		}
+	}
+}
+#endif
+
+/*
+ * printlatency - prints latency percentiles for each request type of
+ *     each trace, followed by the slowest requests and the trace lines
+ *     they came from
+ */
+static void printlatency(int n, stats_t *stats, latency_t *lat)
+{
+	int i, j, t;
+	hist_t all;
+	traceop_t *op;
+	char *names[] = {"malloc", "free", "realloc"};
+
+	printf("%5s%9s%8s%8s%8s%8s%8s%9s\n",
+		   "trace", "op", "count", "p50", "p90", "p99", "p99.9", "max");
+	for (i = 0; i < n; i++)
+	{
+		if (!stats[i].valid)
+		{
+			printf("%2d%12s\n", i, "-");
+			continue;
+		}
+		hist_reset(&all);
+		for (t = 0; t < 3; t++)
+		{
+			if (lat[i].hist[t].count == 0)
+				continue;
+			hist_merge(&all, &lat[i].hist[t]);
+			printf("%2d%12s%8llu%8llu%8llu%8llu%8llu%9llu\n",
+				   i, names[t], lat[i].hist[t].count,
+				   hist_percentile(&lat[i].hist[t], 50),
+				   hist_percentile(&lat[i].hist[t], 90),
+				   hist_percentile(&lat[i].hist[t], 99),
+				   hist_percentile(&lat[i].hist[t], 99.9),
+				   lat[i].hist[t].max);
+		}
+		printf("%2d%12s%8llu%8llu%8llu%8llu%8llu%9llu\n",
+			   i, "all", all.count,
+			   hist_percentile(&all, 50),
+			   hist_percentile(&all, 90),
+			   hist_percentile(&all, 99),
+			   hist_percentile(&all, 99.9),
+			   all.max);
+	}
+
+	printf("\nSlowest requests:\n");
+	printf("%5s%7s%9s%8s%10s\n", "trace", "line", "op", "size", "cycles");
+	for (i = 0; i < n; i++)
+	{
+		if (!stats[i].valid)
+			continue;
+		for (j = 0; j < lat[i].nslow; j++)
+		{
+			op = &lat[i].ops[lat[i].slowest[j].opnum];
+			if (op->type == FREE)
+				printf("%2d%10d%9s%8s%10llu\n", i, LINENUM(lat[i].slowest[j].opnum),
+					   names[op->type], "-", lat[i].slowest[j].cycles);
+			else
+				printf("%2d%10d%9s%8lu%10llu\n", i, LINENUM(lat[i].slowest[j].opnum),
+					   names[op->type], (unsigned long)op->size, lat[i].slowest[j].cycles);
+		}
+	}
+}
+
+/*****************************************************************
+ * The following routines write the results to a JSON or CSV file
+ * for dashboards, and compare the results against the file written
+ * by an earlier run. A file is CSV if its name ends in .csv and JSON
+ * otherwise. The JSON writer puts each trace on a line of its own,
+ * which is what the baseline reader relies on.
+ ****************************************************************/
+
+static char *op_names[] = {"malloc", "free", "realloc"};
+
+/* is_csv - Should this results file be CSV rather than JSON? */
+static int is_csv(char *path)
+{
+	size_t len = strlen(path);
+
+	return len >= 4 && !strcmp(path + len - 4, ".csv");
+}
+
+/* timer_name - The timer package selected in config.h */
+static char *timer_name(void)
+{
+	return USE_FCYC ? "fcyc" : USE_ITIMER ? "itimer" : "gettod";
+}
+
+/* counter_key - Name of hardware counter i as a JSON key or CSV column */
+static char *counter_key(int i)
+{
+	static char key[MAXLINE];
+	char *p;
+
+	strcpy(key, perfctr_name(i));
+	for (p = key; *p; p++)
+		if (*p == ' ')
+			*p = '_';
+	return key;
+}
+
+/* write_json_hist - Write one latency histogram as a JSON object */
+static void write_json_hist(FILE *fp, char *name, hist_t *h)
+{
+	int b, first = 1;
+
+	fprintf(fp, "\"%s\": {\"count\": %llu, \"p50\": %llu, \"p90\": %llu, "
+				"\"p99\": %llu, \"p999\": %llu, \"max\": %llu, \"buckets\": [",
+			name, h->count, hist_percentile(h, 50), hist_percentile(h, 90),
+			hist_percentile(h, 99), hist_percentile(h, 99.9), h->max);
+	for (b = 0; b < HIST_BUCKETS; b++)
+	{
+		if (h->buckets[b] == 0)
+			continue;
+		fprintf(fp, "%s[%llu, %llu]", first ? "" : ", ", hist_bucket_top(b), h->buckets[b]);
+		first = 0;
+	}
+	fprintf(fp, "]}");
+}
+
+/* write_json - Write the results as one JSON object */
+static void write_json(FILE *fp, int n, char **names, stats_t *stats,
+					   latency_t *lat, double perfindex)
+{
+	int i, t, c;
+	double secs = 0, ops = 0, util = 0;
+
+	for (i = 0; i < n; i++)
+	{
+		secs += stats[i].secs;
+		ops += stats[i].ops;
+		util += stats[i].util;
+	}
+
+	fprintf(fp, "{\n");
+	fprintf(fp, "  \"timer\": \"%s\",\n", timer_name());
+	fprintf(fp, "  \"bench_runs\": %d,\n", bench_reps);
+	fprintf(fp, "  \"perfindex\": %.2f,\n", perfindex);
+	fprintf(fp, "  \"util\": %.6f,\n", util / n);
+	fprintf(fp, "  \"kops\": %.3f,\n", (secs > 0) ? (ops / 1e3) / secs : 0);
+	fprintf(fp, "  \"traces\": [\n");
+	for (i = 0; i < n; i++)
+	{
+		fprintf(fp, "    {\"name\": \"%s\", \"valid\": %d, \"ops\": %.0f, "
+					"\"secs\": %.9g, \"util\": %.6f, \"kops\": %.3f, "
+					"\"sbrks\": %d, \"heap_bytes\": %.0f",
+				names[i], stats[i].valid, stats[i].ops,
+				stats[i].secs, stats[i].util,
+				(stats[i].secs > 0) ? (stats[i].ops / 1e3) / stats[i].secs : 0,
+				stats[i].sbrks, stats[i].heapsize);
+		if (bench_reps > 0)
+			fprintf(fp, ", \"bench\": {\"runs\": %d, \"median\": %.9g, \"mad\": %.9g, "
+						"\"ci_lo\": %.9g, \"ci_hi\": %.9g, \"null_secs\": %.9g}",
+					stats[i].bench.n, stats[i].bench.median, stats[i].bench.mad,
+					stats[i].bench.lo, stats[i].bench.hi, stats[i].null_secs);
+#ifdef MM_STATS
+		fprintf(fp, ", \"mm_stats\": {\"fit_calls\": %lu, \"fit_visits\": %lu, "
+					"\"fit_visits_max\": %lu, \"splits\": %lu, "
+					"\"coalesce\": [%lu, %lu, %lu, %lu], \"extend_calls\": %lu, "
+					"\"extend_bytes\": %lu, \"realloc_inplace\": %lu, "
+					"\"realloc_moved\": %lu, \"realloc_copied\": %lu}",
+				stats[i].mm.fit_calls, stats[i].mm.fit_visits, stats[i].mm.fit_visits_max,
+				stats[i].mm.splits, stats[i].mm.coalesce[0], stats[i].mm.coalesce[1],
+				stats[i].mm.coalesce[2], stats[i].mm.coalesce[3], stats[i].mm.extend_calls,
+				stats[i].mm.extend_bytes, stats[i].mm.realloc_inplace,
+				stats[i].mm.realloc_moved, stats[i].mm.realloc_copied);
+#endif
+		if (count_events)
+		{
+			fprintf(fp, ", \"counters\": {");
+			for (t = 0, c = 0; t < PERFCTR_NUM; t++)
+				if (perfctr_available(t))
+					fprintf(fp, "%s\"%s\": %.0f", c++ ? ", " : "",
+							counter_key(t), stats[i].counters[t]);
+			fprintf(fp, "}");
+		}
+		if (lat != NULL && stats[i].valid)
+		{
+			fprintf(fp, ", \"latency\": {");
+			for (t = 0; t < 3; t++)
+			{
+				if (t > 0)
+					fprintf(fp, ", ");
+				write_json_hist(fp, op_names[t], &lat[i].hist[t]);
+			}
+			fprintf(fp, "}");
+		}
+		fprintf(fp, "}%s\n", (i < n - 1) ? "," : "");
+	}
+	fprintf(fp, "  ]\n}\n");
+}
+
+/* write_csv - Write the results as one CSV row per trace */
+static void write_csv(FILE *fp, int n, char **names, stats_t *stats,
+					  latency_t *lat)
+{
+	int i, t;
+	hist_t *h;
+
+	fprintf(fp, "trace,name,valid,ops,secs,util,kops,sbrks,heap_bytes");
+	if (bench_reps > 0)
+		fprintf(fp, ",bench_runs,median,mad,ci_lo,ci_hi,null_secs");
+#ifdef MM_STATS
+	fprintf(fp, ",fit_calls,fit_visits,fit_visits_max,splits,coalesce1,coalesce2,"
+				"coalesce3,coalesce4,extend_calls,extend_bytes,realloc_inplace,"
+				"realloc_moved,realloc_copied");
+#endif
+	if (count_events)
+		for (t = 0; t < PERFCTR_NUM; t++)
+			if (perfctr_available(t))
+				fprintf(fp, ",%s", counter_key(t));
+	if (lat != NULL)
+		for (t = 0; t < 3; t++)
+			fprintf(fp, ",%s_count,%s_p50,%s_p90,%s_p99,%s_p999,%s_max",
+					op_names[t], op_names[t], op_names[t],
+					op_names[t], op_names[t], op_names[t]);
+	fprintf(fp, "\n");
+
+	for (i = 0; i < n; i++)
+	{
+		fprintf(fp, "%d,%s,%d,%.0f,%.9g,%.6f,%.3f,%d,%.0f",
+				i, names[i], stats[i].valid, stats[i].ops,
+				stats[i].secs, stats[i].util,
+				(stats[i].secs > 0) ? (stats[i].ops / 1e3) / stats[i].secs : 0,
+				stats[i].sbrks, stats[i].heapsize);
+		if (bench_reps > 0)
+			fprintf(fp, ",%d,%.9g,%.9g,%.9g,%.9g,%.9g",
+					stats[i].bench.n, stats[i].bench.median, stats[i].bench.mad,
+					stats[i].bench.lo, stats[i].bench.hi, stats[i].null_secs);
+#ifdef MM_STATS
+		fprintf(fp, ",%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu",
+				stats[i].mm.fit_calls, stats[i].mm.fit_visits, stats[i].mm.fit_visits_max,
+				stats[i].mm.splits, stats[i].mm.coalesce[0], stats[i].mm.coalesce[1],
+				stats[i].mm.coalesce[2], stats[i].mm.coalesce[3], stats[i].mm.extend_calls,
+				stats[i].mm.extend_bytes, stats[i].mm.realloc_inplace,
+				stats[i].mm.realloc_moved, stats[i].mm.realloc_copied);
+#endif
+		if (count_events)
+			for (t = 0; t < PERFCTR_NUM; t++)
+				if (perfctr_available(t))
+					fprintf(fp, ",%.0f", stats[i].counters[t]);
+		if (lat != NULL)
+			for (t = 0; t < 3; t++)
+			{
+				h = &lat[i].hist[t];
+				fprintf(fp, ",%llu,%llu,%llu,%llu,%llu,%llu",
+						h->count, hist_percentile(h, 50), hist_percentile(h, 90),
+						hist_percentile(h, 99), hist_percentile(h, 99.9), h->max);
+			}
+		fprintf(fp, "\n");
+	}
+}
+
+/*
+ * write_results - Write the results of the mm malloc package to path,
+ *     as CSV or JSON depending on its name
+ */
+static void write_results(char *path, int n, char **names, stats_t *stats,
+						  latency_t *lat, double perfindex)
+{
+	FILE *fp;
+
+	if ((fp = fopen(path, "w")) == NULL)
+	{
+		sprintf(msg, "Could not open %s in write_results", path);
+		unix_error(msg);
+	}
+	if (is_csv(path))
+		write_csv(fp, n, names, stats, lat);
+	else
+		write_json(fp, n, names, stats, lat, perfindex);
+	fclose(fp);
+
+	if (verbose)
+		printf("Wrote results to %s\n", path);
+}
+
+/* find_trace - Index of the trace with this name, or -1 */
+static int find_trace(int n, char **names, char *name)
+{
+	int i;
+
+	for (i = 0; i < n; i++)
+		if (!strcmp(names[i], name))
+			return i;
+	return -1;
+}
+
+/* json_number - Find "key": <number> in a JSON line, 0 if it's not there */
+static int json_number(char *line, char *key, double *v)
+{
+	char pat[MAXLINE];
+	char *p;
+
+	sprintf(pat, "\"%s\":", key);
+	if ((p = strstr(line, pat)) == NULL)
+		return 0;
+	*v = strtod(p + strlen(pat), NULL);
+	return 1;
+}
+
+/* read_baseline_json - Read the trace lines of a JSON results file */
+static void read_baseline_json(FILE *fp, int n, char **names, baseline_t *base)
+{
+	char line[1 << 16];
+	char name[MAXLINE];
+	char *p;
+	double v;
+	int i;
+
+	while (fgets(line, sizeof(line), fp) != NULL)
+	{
+		if ((p = strstr(line, "\"name\": \"")) == NULL ||
+			sscanf(p + strlen("\"name\": \""), "%1023[^\"]", name) != 1 ||
+			(i = find_trace(n, names, name)) < 0)
+			continue;
+		base[i].found = 1;
+		if (json_number(line, "valid", &v))
+			base[i].valid = (int)v;
+		json_number(line, "secs", &base[i].secs);
+		json_number(line, "util", &base[i].util);
+		if (json_number(line, "runs", &v))
+			base[i].bench_n = (int)v;
+		json_number(line, "ci_lo", &base[i].lo);
+		json_number(line, "ci_hi", &base[i].hi);
+	}
+}
+
+/* read_baseline_csv - Read the rows of a CSV results file */
+static void read_baseline_csv(FILE *fp, int n, char **names, baseline_t *base)
+{
+	char line[1 << 16];
+	char *cols[256], *vals[256], *tok;
+	int ncols = 0, nvals, c, i;
+	char header[1 << 16];
+
+	if (fgets(header, sizeof(header), fp) == NULL)
+		return;
+	for (tok = strtok(header, ",\n"); tok != NULL && ncols < 256; tok = strtok(NULL, ",\n"))
+		cols[ncols++] = tok;
+
+	while (fgets(line, sizeof(line), fp) != NULL)
+	{
+		nvals = 0;
+		for (tok = strtok(line, ",\n"); tok != NULL && nvals < 256; tok = strtok(NULL, ",\n"))
+			vals[nvals++] = tok;
+
+		for (i = -1, c = 0; c < ncols && c < nvals; c++)
+			if (!strcmp(cols[c], "name"))
+				i = find_trace(n, names, vals[c]);
+		if (i < 0)
+			continue;
+
+		base[i].found = 1;
+		for (c = 0; c < ncols && c < nvals; c++)
+		{
+			if (!strcmp(cols[c], "valid"))
+				base[i].valid = atoi(vals[c]);
+			else if (!strcmp(cols[c], "secs"))
+				base[i].secs = atof(vals[c]);
+			else if (!strcmp(cols[c], "util"))
+				base[i].util = atof(vals[c]);
+			else if (!strcmp(cols[c], "bench_runs"))
+				base[i].bench_n = atoi(vals[c]);
+			else if (!strcmp(cols[c], "ci_lo"))
+				base[i].lo = atof(vals[c]);
+			else if (!strcmp(cols[c], "ci_hi"))
+				base[i].hi = atof(vals[c]);
+		}
+	}
+}
+
+/*
+ * read_baseline - Read the results file of an earlier run and fill in
+ *     base[i] for every trace of this run that it mentions
+ */
+static void read_baseline(char *path, int n, char **names, baseline_t *base)
+{
+	FILE *fp;
+
+	if ((fp = fopen(path, "r")) == NULL)
+	{
+		sprintf(msg, "Could not open %s in read_baseline", path);
+		unix_error(msg);
+	}
+	if (is_csv(path))
+		read_baseline_csv(fp, n, names, base);
+	else
+		read_baseline_json(fp, n, names, base);
+	fclose(fp);
+}
+
+/*
+ * compare_baseline - Print this run against the baseline and return
+ *     the number of traces that regressed. A trace regresses if it
+ *     became invalid, if its utilization dropped by more than
+ *     UTIL_EPSILON, or if it got more than tolerance percent slower.
+ *     When both runs come from benchmark mode, a slowdown also has to
+ *     be significant: the confidence intervals of the two medians must
+ *     not overlap.
+ */
+static int compare_baseline(int n, char **names, stats_t *stats, baseline_t *base)
+{
+	int i, regressions = 0;
+	int slower, worse_util, significant;
+	double change;
+	char *verdict;
+
+	printf("%5s%11s%9s%9s%10s%7s  %s\n",
+		   "trace", "base Kops", "Kops", "change", "base util", "util", "verdict");
+	for (i = 0; i < n; i++)
+	{
+		if (!base[i].found)
+		{
+			printf("%2d%50s  %s\n", i, "", "not in baseline");
+			continue;
+		}
+		if (!stats[i].valid || !base[i].valid)
+		{
+			verdict = (base[i].valid && !stats[i].valid) ? "REGRESSION (invalid)" : "ok";
+			if (base[i].valid && !stats[i].valid)
+				regressions++;
+			printf("%2d%50s  %s\n", i, "", verdict);
+			continue;
+		}
+
+		change = (base[i].secs > 0) ? 100 * (stats[i].secs - base[i].secs) / base[i].secs : 0;
+		significant = (bench_reps > 0 && base[i].bench_n > 0) ? stats[i].bench.lo > base[i].hi : 1;
+		slower = significant && change > tolerance;
+		worse_util = stats[i].util < base[i].util - UTIL_EPSILON;
+
+		if (slower && worse_util)
+			verdict = "REGRESSION (thru, util)";
+		else if (slower)
+			verdict = "REGRESSION (thru)";
+		else if (worse_util)
+			verdict = "REGRESSION (util)";
+		else
+			verdict = "ok";
+		if (slower || worse_util)
+			regressions++;
+
+		printf("%2d%14.0f%9.0f%8.1f%%%9.1f%%%6.1f%%  %s\n",
+			   i,
+			   (base[i].secs > 0) ? (stats[i].ops / 1e3) / base[i].secs : 0,
+			   (stats[i].ops / 1e3) / stats[i].secs,
+			   -change,
+			   base[i].util * 100.0,
+			   stats[i].util * 100.0,
+			   verdict);
+	}
+	return regressions;
+}
+
 /*
  * app_error - Report an arbitrary application error
  */
@@ -1053,19 +3232,51 @@ void malloc_error(int tracenum, int opnum, char *msg)
 	printf("ERROR [trace %d, line %d]: %s\n", tracenum, LINENUM(opnum), msg);
 }
 
+/*
+ * stream_error - Report an error in a streamed trace, where op numbers
+ *     can be too big for an int
+ */
+void stream_error(int tracenum, unsigned long long opnum, char *msg)
+{
+	errors++;
+	printf("ERROR [trace %d, op %llu]: %s\n", tracenum, opnum, msg);
+}
+
 /*
  * usage - Explain the command line arguments
  */
 static void usage(void)
 {
-	fprintf(stderr, "Usage: mdriver [-hvVal] [-f <file>] [-t <dir>]\n");
+	fprintf(stderr, "Usage: mdriver [-hvVale] [-f <file>] [-t <dir>] [-H <n>] [-A <n>] [-L <n>]\n"
+					"               [-r <n> [-w <n>] [-c <cpu>]] [-o <file>] [-B <file> [-T <pct>]]\n"
+					"               [-k <n>] [-d <op,...>] [-D <dir>] [-S <n>] [-R]\n");
 	fprintf(stderr, "Options\n");
 	fprintf(stderr, "\t-a         Don't check the team structure.\n");
+	fprintf(stderr, "\t-c <cpu>   Pin the driver to cpu <cpu>.\n");
+	fprintf(stderr, "\t-A <n>     Replay each group of <n> ids in its own arena.\n");
+	fprintf(stderr, "\t-B <file>  (--baseline) Compare against results file <file>,\n"
+					"\t           exit with status 2 on regressions.\n");
+	fprintf(stderr, "\t-d <ops>   (--dump) Dump heap snapshots before these ops, e.g. 1000,5000\n"
+					"\t           into <trace>.<op>.snap (see heapview).\n");
+	fprintf(stderr, "\t-D <dir>   (--timeline-dir) Write the -k and -d files into <dir>.\n");
+	fprintf(stderr, "\t-e         Count hardware events (perf_event_open) per trace.\n");
 	fprintf(stderr, "\t-f <file>  Use <file> as the trace file.\n");
 	fprintf(stderr, "\t-g         Generate summary info for autograder.\n");
 	fprintf(stderr, "\t-h         Print this message.\n");
+	fprintf(stderr, "\t-H <n>     Hint ids freed within <n> ops as short-lived.\n");
+	fprintf(stderr, "\t-k <n>     (--timeline) Sample fragmentation every <n> ops into\n"
+					"\t           <trace>.timeline.csv.\n");
 	fprintf(stderr, "\t-l         Run libc malloc as well.\n");
+	fprintf(stderr, "\t-r <n>     Benchmark mode: time <n> runs, report median and CI.\n");
+	fprintf(stderr, "\t-L <n>     Time every request, report the <n> slowest.\n");
+	fprintf(stderr, "\t-o <file>  (--output) Write results to <file> (.csv or JSON).\n");
+	fprintf(stderr, "\t-R         (--stream) Stream each trace through mm malloc in one pass\n"
+					"\t           with bounded memory; no checking or other runs.\n");
+	fprintf(stderr, "\t-S <n>     (--verify-lines) Fill and check only <n> %d-byte lines of\n"
+					"\t           each payload instead of all of it.\n", VERIFY_LINE);
 	fprintf(stderr, "\t-t <dir>   Directory to find default traces.\n");
+	fprintf(stderr, "\t-T <pct>   (--tolerance) Slowdown allowed against the baseline (default 3).\n");
 	fprintf(stderr, "\t-v         Print per-trace performance breakdowns.\n");
 	fprintf(stderr, "\t-V         Print additional debug info.\n");
+	fprintf(stderr, "\t-w <n>     Untimed warmup runs in benchmark mode (default 2).\n");
 }
@@ -18,6 +18,7 @@
 static char *mem_start_brk;  /* points to first byte of heap */
 static char *mem_brk;        /* points to last byte of heap */
 static char *mem_max_addr;   /* largest legal heap address */ 
+static int mem_sbrk_count;   /* number of successful mem_sbrk calls */
 
 /* 
  * mem_init - initialize the memory system model
@@ -32,6 +33,7 @@ void mem_init(void)
 
     mem_max_addr = mem_start_brk + MAX_HEAP;  /* max legal heap address */
     mem_brk = mem_start_brk;                  /* heap is empty initially */
+    mem_sbrk_count = 0;
 }
 
 /* 
@@ -48,6 +50,7 @@ void mem_deinit(void)
 void mem_reset_brk()
 {
     mem_brk = mem_start_brk;
+    mem_sbrk_count = 0;
 }
 
 /* 
@@ -65,9 +68,19 @@ void *mem_sbrk(int incr)
 	return (void *)-1;
     }
     mem_brk += incr;
+    mem_sbrk_count++;
     return (void *)old_brk;
 }
 
+/*
+ * mem_sbrk_calls - returns the number of successful mem_sbrk calls
+ *    since the heap was last reset
+ */
+int mem_sbrk_calls()
+{
+    return mem_sbrk_count;
+}
+
 /*
  * mem_heap_lo - return address of the first heap byte
  */
@@ -92,6 +105,15 @@ size_t mem_heapsize()
     return (size_t)(mem_brk - mem_start_brk);
 }
 
+/*
+ * mem_maxheap() - returns the largest heap size in bytes (MAX_HEAP as
+ *    this file was built with)
+ */
+size_t mem_maxheap()
+{
+    return (size_t)MAX_HEAP;
+}
+
 /*
  * mem_pagesize() - returns the page size of the system
  */
@@ -3,9 +3,11 @@
 void mem_init(void);               
 void mem_deinit(void);
 void *mem_sbrk(int incr);
+int mem_sbrk_calls(void);
 void mem_reset_brk(void); 
 void *mem_heap_lo(void);
 void *mem_heap_hi(void);
 size_t mem_heapsize(void);
+size_t mem_maxheap(void);
 size_t mem_pagesize(void);
 
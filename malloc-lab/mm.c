@@ -51,6 +51,14 @@ static void *extend_heap(size_t words);
 static void *coalesce(void *bp);
 static void *find_fit(size_t asize);
 static void place(void *bp, size_t asize);
+
+#ifdef MM_STATS
+#define STAT_CLASSES 13       // 통계용 크기 클래스 수: 32B ~ 64KB 12개 + 그 이상
+static mm_stats_t stats;      // mm_get_stats가 돌려줄 카운터 (mm_init에서 0으로)
+static size_t fit_visits_cur; // 이번 find_fit 호출이 본 블록 수
+static int stat_class(size_t size);
+static void stat_fit(size_t asize, void *bp);
+#endif
 /////////////////////////////////
 
 /*
@@ -70,6 +78,7 @@ int mm_init(void)
     PUT(heap_listp + (1*WSIZE), PACK(DSIZE, 1)); // 프롤로그 헤더
     PUT(heap_listp + (2*WSIZE), PACK(DSIZE, 1)); // 프롤로그 푸터
     PUT(heap_listp + (3*WSIZE), PACK(0, 1));     // 에필로그 헤더
+    MM_STAT(memset(&stats, 0, sizeof(stats)));
 
     // heap_listp += (WSIZE); -> 이건 프롤로그푸터를 가리켜서 그 다음 주소가 첫 가용 블록의 헤더임
     heap_listp += (2*WSIZE); // heap_listp를 첫 가용 블록의 payload 주소로 이동(보통 payload 기준으로 블록포인터 잡음)
@@ -91,6 +100,8 @@ static void *extend_heap(size_t words)
     // 항상 8바이트 단위로 정렬, 짝수 워드 할당
     size = (words % 2) ? (words + 1) * WSIZE : words * WSIZE;
     if ((long)(bp = mem_sbrk(size)) == -1) return NULL;
+    MM_STAT(stats.extend_calls++);
+    MM_STAT(stats.extend_bytes += size);
     
     // 새 가용 블록의 헤더/푸터, 새로운 에필로그 헤더 초기화
     PUT(HDRP(bp), PACK(size, 0));         // 헤더: 크기, free
@@ -127,7 +138,9 @@ void *mm_malloc(size_t size)
     }
 
     // 2. 가용 리스트에서 asize만큼 맞는 블록 탐색
-    if ((bp = find_fit(asize)) != NULL)
+    bp = find_fit(asize);
+    MM_STAT(stat_fit(asize, bp));
+    if (bp != NULL)
     {
         place(bp, asize);    // 찾으면 그 블록에 asize만큼 할당
         return bp;           // payload 주소 리턴
@@ -141,6 +154,14 @@ void *mm_malloc(size_t size)
     return bp;
 }
 
+/*
+ * mm_malloc_hint - 수명 힌트는 쓰지 않음, mm_malloc과 동일
+ */
+void *mm_malloc_hint(size_t size, int hint)
+{
+    return mm_malloc(size);
+}
+
 /*
  * find_fit - asize 크기 이상의 가용 블록을 찾아서 payload 포인터 반환
  */
@@ -148,8 +169,10 @@ static void *find_fit(size_t asize)
 {
     // 전체 순회 
     char *bp = heap_listp;
+    MM_STAT(fit_visits_cur = 0);
     while (GET_SIZE(HDRP(bp)) > 0) // 에필로그 블록이 크기가 0이니까
     {
+        MM_STAT(fit_visits_cur++);
         if (!GET_ALLOC(HDRP(bp)) && (GET_SIZE(HDRP(bp)) >= asize))
         {
             return bp;
@@ -170,6 +193,7 @@ static void place(void *bp, size_t asize)
     if ((totalsize - asize) >= (2 * DSIZE))
     {
         // 블록 분할
+        MM_STAT(stats.splits++);
         PUT(HDRP(bp), PACK(asize, 1));
         PUT(FTRP(bp), PACK(asize, 1));
 
@@ -198,12 +222,14 @@ static void *coalesce(void *bp)
     // Case 1: 이전/다음 모두 할당됨
     if (prev_alloc && next_alloc)
     {
+        MM_STAT(stats.coalesce[0]++);
         return bp;
     }
 
     // Case 2: 이전 할당, 다음 free
     else if (prev_alloc && !next_alloc)
     {
+        MM_STAT(stats.coalesce[1]++);
         size += GET_SIZE(HDRP(NEXT_BLKP(bp)));
         PUT(HDRP(bp), PACK(size, 0));
         PUT(FTRP(bp), PACK(size, 0));
@@ -212,6 +238,7 @@ static void *coalesce(void *bp)
     // Case 3: 이전 free, 다음 할당
     else if (!prev_alloc && next_alloc)
     {
+        MM_STAT(stats.coalesce[2]++);
         size += GET_SIZE(HDRP(PREV_BLKP(bp)));
         bp = PREV_BLKP(bp);
         PUT(HDRP(bp), PACK(size, 0));
@@ -221,6 +248,7 @@ static void *coalesce(void *bp)
     // Case 4: 이전/다음 모두 free
     else
     {
+        MM_STAT(stats.coalesce[3]++);
         size += ( GET_SIZE(HDRP(PREV_BLKP(bp))) + GET_SIZE(HDRP(NEXT_BLKP(bp))) );
         bp = PREV_BLKP(bp);
         PUT(HDRP(bp), PACK(size, 0));
@@ -260,7 +288,89 @@ void *mm_realloc(void *ptr, size_t size)
 
     size_t copySize = (size < old_size) ? size : old_size;
     memcpy(newptr, ptr, copySize); // memcpy : 메모리 영역을 "복사"하는 함수 memcpy(목적지_주소, 원본_주소, 복사_크기);
+    MM_STAT(stats.realloc_moved++);
+    MM_STAT(stats.realloc_copied += copySize);
     
     mm_free(ptr);
     return newptr;
-}
\ No newline at end of file
+}
+
+/*
+ * mm_heap_walk - 힙의 블록을 주소 순서로 하나씩 돌려줌
+ *     *cursor가 NULL이면 첫 블록부터 시작, 에필로그에 닿으면 0을 리턴
+ */
+int mm_heap_walk(void **cursor, mm_block_t *blk)
+{
+    char *bp = (*cursor == NULL) ? NEXT_BLKP(heap_listp) : NEXT_BLKP(*cursor);
+
+    if (GET_SIZE(HDRP(bp)) == 0) return 0; // 에필로그
+
+    blk->addr = bp;
+    blk->size = GET_SIZE(HDRP(bp));
+    blk->alloc = GET_ALLOC(HDRP(bp));
+    blk->bin = -1; // implicit list라 free list가 따로 없음
+    *cursor = bp;
+    return 1;
+}
+
+#ifdef MM_STATS
+/*
+ * stat_class - 통계용 크기 클래스: bin이 없으니 2의 거듭제곱 구간 (<=32, <=64, ..., 그 이상)
+ */
+static int stat_class(size_t size)
+{
+    int cls = 0;
+    size_t max = 2 * DSIZE;
+
+    while (size > max && cls < STAT_CLASSES - 1)
+    {
+        max <<= 1;
+        cls++;
+    }
+    return cls;
+}
+
+/*
+ * stat_fit - find_fit 한 번의 탐색 노드 수와 hit/miss 기록
+ * 가용 리스트가 하나뿐이라 어떤 블록이든 찾으면 hit, 못 찾아서 힙을 늘리면 miss
+ */
+static void stat_fit(size_t asize, void *bp)
+{
+    int cls = stat_class(asize);
+
+    stats.fit_calls++;
+    stats.fit_visits += fit_visits_cur;
+    if (fit_visits_cur > stats.fit_visits_max) stats.fit_visits_max = fit_visits_cur;
+
+    if (bp != NULL) stats.bin_hits[cls]++;
+    else stats.bin_misses[cls]++;
+}
+
+/*
+ * mm_get_stats - 카운터 복사 + 힙 전체를 훑어서 클래스별 live/free 바이트 계산
+ */
+void mm_get_stats(mm_stats_t *out)
+{
+    char *bp;
+    int i, cls;
+
+    *out = stats;
+
+    out->nclasses = STAT_CLASSES;
+    for (i = 0; i < STAT_CLASSES - 1; i++) out->class_max[i] = (size_t)(2 * DSIZE) << i;
+    out->class_max[STAT_CLASSES - 1] = 0;
+
+    for (i = 0; i < MM_STAT_CLASSES; i++)
+    {
+        out->live_bytes[i] = 0;
+        out->free_bytes[i] = 0;
+    }
+
+    for (bp = NEXT_BLKP(heap_listp); GET_SIZE(HDRP(bp)) > 0; bp = NEXT_BLKP(bp))
+    {
+        cls = stat_class(GET_SIZE(HDRP(bp)));
+        if (GET_ALLOC(HDRP(bp))) out->live_bytes[cls] += GET_SIZE(HDRP(bp));
+        else out->free_bytes[cls] += GET_SIZE(HDRP(bp));
+    }
+}
+#endif
@@ -31,8 +31,38 @@
 #define BIN_COUNT      32                  // bin 개수
 #define BIN_MIN_SIZE   16                  // 최소 bin size
 #define BIN_MAX_SIZE   512                 // 최대 bin size (마지막 bin 크기, 실제 bin_sizes 배열에서 확인)
+// mm_3.c의 bin_sizes[] 초기값 (traceanalyze도 같이 씀), 0이 아닌 앞쪽 항목들이 bin
+#define BIN_SIZES { \
+    16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 208, \
+    224, 240, 256, 288, 320, 352, 384, 416, 448, 480, 512, \
+}
 #define MIN_BLOCK_SIZE (WSIZE + WSIZE + WSIZE + WSIZE) // 헤더 + pred + succ + 푸터 = 4*WSIZE
 
+// -------- Large exact-size 캐시 전용 매크로 --------
+#define EXACT_SLOTS    64                  // 정확한 크기 -> free large 블록 리스트 해시 테이블 슬롯 수 (2의 거듭제곱)
+#define EXACT_HASH(sz) ((((sz) >> 3) ^ ((sz) >> 9)) & (EXACT_SLOTS - 1))
+#define EXACT_BIT      0x4                 // 헤더 bit2: exact 캐시 리스트에도 들어있는 free large 블록 표시
+#define EPRED(bp) (*(void **)((char *)(bp) + 2*WSIZE)) // 같은 크기 리스트의 pred (large 블록은 payload가 충분히 큼)
+#define ESUCC(bp) (*(void **)((char *)(bp) + 3*WSIZE)) // 같은 크기 리스트의 succ
+
+// -------- 힙 확장 정책 매크로 --------
+#define GROW_MIN    (1<<9)                 // 확장 크기 하한: 확장이 뜸하면 부족분에 가깝게만 늘림
+#define GROW_MAX    (1<<16)                // 확장 크기 상한 64KB (더 크면 피크 뒤 남는 꼬리 때문에 util 손해)
+#define GROW_WINDOW 256                     // 직전 확장 이후 malloc 호출이 이 이하면 빠르게 자라는 중 -> 확장 크기 2배
+
+// -------- Nursery(수명 힌트) 전용 매크로 --------
+#define NURSERY_BIT     0x2                // 헤더 bit1: nursery 안에서 bump 할당된 블록 표시 (alloc bit과 같이 씀)
+#define NURSERY_SIZE    (1<<14)            // nursery 영역 하나의 크기 16KB (main heap에서 블록 하나로 받아옴)
+#define NURSERY_MAX_REQ 512                // asize가 이보다 크면 SHORT 힌트여도 main heap에서 할당
+#define IS_NURSERY(bp)  (GET(HDRP(bp)) & NURSERY_BIT)
+
+// -------- 통계(MM_STATS 빌드) 전용 매크로 --------
+#ifdef MM_STATS
+#define MM_STAT(x)  x                      // -DMM_STATS로 빌드할 때만 카운터 코드가 들어감
+#else
+#define MM_STAT(x)                         // 기본 빌드에서는 통째로 사라짐 (비용 0)
+#endif
+
 // -----------------------------------------
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -44,6 +74,106 @@ extern void *mm_malloc (size_t size);
 extern void mm_free (void *ptr);
 extern void *mm_realloc(void *ptr, size_t size);
 
+/* 
+ * Heap walking, for tools that look at the layout. mm_heap_walk returns
+ * the blocks of the heap in address order: start with *cursor == NULL,
+ * and it returns 1 and fills in blk for each block, 0 past the last.
+ * The heap must not change during a walk.
+ */
+typedef struct {
+    void *addr;   /* payload address */
+    size_t size;  /* whole block, header and footer included */
+    int alloc;    /* 1 if allocated */
+    int bin;      /* free list the block is on (allocator specific), -1 for none */
+} mm_block_t;
+extern int mm_heap_walk(void **cursor, mm_block_t *blk);
+
+/* 
+ * Lifetime hints for mm_malloc_hint. A SHORT block is expected to be
+ * freed soon after it is allocated; allocators that don't separate
+ * lifetimes simply treat every request as LONG.
+ */
+#define MM_HINT_LONG  0
+#define MM_HINT_SHORT 1
+extern void *mm_malloc_hint(size_t size, int hint);
+
+/* 
+ * Region (arena) allocation on top of mm_malloc (mm_arena.c). Objects
+ * are bump-allocated from chunks obtained from the main allocator and
+ * released all at once by mm_arena_reset, which hands every chunk back.
+ * mm_arena_realloc grows a block in place when it is the last one
+ * bump-allocated or has a chunk of its own; oldsize is the size the
+ * block was allocated or last grown to.
+ */
+typedef struct mm_arena mm_arena_t;
+extern mm_arena_t *mm_arena_create(size_t chunk_size);
+extern void *mm_arena_alloc(mm_arena_t *arena, size_t size);
+extern void *mm_arena_realloc(mm_arena_t *arena, void *ptr, size_t oldsize, size_t size);
+extern void mm_arena_reset(mm_arena_t *arena);
+extern void mm_arena_destroy(mm_arena_t *arena);
+
+/* 
+ * Fixed-size object pools on top of mm_malloc (mm_pool.c). Each pool
+ * carves objects of one size out of slabs taken from the main heap and
+ * recycles them through an intrusive free list: no searching and no
+ * coalescing. Build with -DMM_POOL_TCACHE for per-thread caches.
+ */
+typedef struct mm_pool mm_pool_t;
+extern mm_pool_t *mm_pool_create(size_t obj_size, size_t align);
+extern void *mm_pool_alloc(mm_pool_t *pool);
+extern void mm_pool_free(mm_pool_t *pool, void *ptr);
+extern void mm_pool_destroy(mm_pool_t *pool);
+
+#ifdef MM_STATS
+/* 
+ * Allocator statistics, compiled in only with -DMM_STATS. Counters
+ * accumulate from mm_init; the live/free byte counts are taken from a
+ * walk of the heap at the time of the call. Each allocator defines its
+ * own size classes (class_max[i] is the largest block size in class i,
+ * 0 for the open-ended last class); a bin "hit" means find_fit found a
+ * block in the request's own class, a "miss" that it had to look in a
+ * bigger class or extend the heap.
+ */
+#define MM_STAT_CLASSES 40
+typedef struct {
+    unsigned long fit_calls;       /* find_fit calls */
+    unsigned long fit_visits;      /* free list nodes (blocks) examined, total... */
+    unsigned long fit_visits_max;  /* ... and in the worst single call */
+    unsigned long splits;          /* blocks split by place or realloc */
+    unsigned long coalesce[4];     /* coalesce calls by case 1-4 */
+    unsigned long extend_calls;    /* extend_heap calls... */
+    unsigned long extend_bytes;    /* ... and the bytes they added */
+    unsigned long realloc_inplace; /* reallocs that kept or merged into the old block */
+    unsigned long realloc_moved;   /* reallocs that moved to a new block */
+    unsigned long realloc_copied;  /* payload bytes copied by realloc */
+    int nclasses;                             /* number of size classes */
+    size_t class_max[MM_STAT_CLASSES];        /* largest block size of each class */
+    unsigned long bin_hits[MM_STAT_CLASSES];  /* by class of the request */
+    unsigned long bin_misses[MM_STAT_CLASSES];
+    size_t live_bytes[MM_STAT_CLASSES];       /* allocated block bytes by class */
+    size_t free_bytes[MM_STAT_CLASSES];       /* free block bytes by class */
+} mm_stats_t;
+extern void mm_get_stats(mm_stats_t *stats);
+#endif
+
+#ifdef MM_PROFILE
+/*
+ * Per-function cycle counts, compiled in only with -DMM_PROFILE (mm_3
+ * only). Counts accumulate from mm_init. "self" excludes the cycles
+ * spent in the instrumented functions it calls, "total" includes them,
+ * so the self column adds up to the allocator's whole time.
+ */
+#define MM_PROF_MAX 16
+typedef struct {
+    int nfuncs;                            /* number of instrumented functions */
+    const char *name[MM_PROF_MAX];
+    unsigned long calls[MM_PROF_MAX];
+    unsigned long long self[MM_PROF_MAX];  /* cycles in the function itself */
+    unsigned long long total[MM_PROF_MAX]; /* cycles including its callees */
+} mm_profile_t;
+extern void mm_get_profile(mm_profile_t *prof);
+#endif
+
 /* 
  * Students work in teams of one or two.  Teams enter their team name, 
  * personal names and login IDs in a struct of this
@@ -55,6 +55,14 @@ static void *find_fit(size_t asize);
 static void place(void *bp, size_t asize);
 static void insert_free_block(void *bp);   
 static void delete_free_block(void *bp); 
+
+#ifdef MM_STATS
+#define STAT_CLASSES 13       // 통계용 크기 클래스 수: 32B ~ 64KB 12개 + 그 이상
+static mm_stats_t stats;      // mm_get_stats가 돌려줄 카운터 (mm_init에서 0으로)
+static size_t fit_visits_cur; // 이번 find_fit 호출이 본 블록 수
+static int stat_class(size_t size);
+static void stat_fit(size_t asize, void *bp);
+#endif
 /////////////////////////////////
 
 
@@ -152,6 +160,7 @@ int mm_init(void)
     PUT(heap_listp + (1*WSIZE), PACK(DSIZE, 1)); // 프롤로그 헤더
     PUT(heap_listp + (2*WSIZE), PACK(DSIZE, 1)); // 프롤로그 푸터
     PUT(heap_listp + (3*WSIZE), PACK(0, 1));     // 에필로그 헤더
+    MM_STAT(memset(&stats, 0, sizeof(stats)));
 
     
     heap_listp += (2*WSIZE); // heap_listp를 첫 가용 블록의 payload 주소로 이동(보통 payload 기준으로 블록포인터 잡음)
@@ -174,6 +183,8 @@ static void *extend_heap(size_t words)
     // 항상 8바이트 단위로 정렬, 짝수 워드 할당
     size = (words % 2) ? (words + 1) * WSIZE : words * WSIZE;
     if ((long)(bp = mem_sbrk(size)) == -1) return NULL;
+    MM_STAT(stats.extend_calls++);
+    MM_STAT(stats.extend_bytes += size);
     
     // 새 가용 블록의 헤더/푸터, 새로운 에필로그 헤더 초기화
     PUT(HDRP(bp), PACK(size, 0));         // 헤더: 크기, free
@@ -208,7 +219,9 @@ void *mm_malloc(size_t size)
     }
 
     // 2. 가용 리스트에서 asize만큼 맞는 블록 탐색
-    if ((bp = find_fit(asize)) != NULL)
+    bp = find_fit(asize);
+    MM_STAT(stat_fit(asize, bp));
+    if (bp != NULL)
     {
         place(bp, asize);    // 찾으면 그 블록에 asize만큼 할당
         return bp;           // payload 주소 리턴
@@ -222,6 +235,14 @@ void *mm_malloc(size_t size)
     return bp;
 }
 
+/*
+ * mm_malloc_hint - 수명 힌트는 쓰지 않음, mm_malloc과 동일
+ */
+void *mm_malloc_hint(size_t size, int hint)
+{
+    return mm_malloc(size);
+}
+
 /*
  * find_fit - asize 크기 이상의 가용 블록을 찾아서 payload 포인터 반환
  */
@@ -232,8 +253,10 @@ void *mm_malloc(size_t size)
      char *best = NULL;
      size_t min_size = (size_t)-1;
 
+     MM_STAT(fit_visits_cur = 0);
      while (bp) 
      {
+         MM_STAT(fit_visits_cur++);
          size_t curr_size = GET_SIZE(HDRP(bp));
          if (curr_size >= asize && curr_size < min_size) 
          {
@@ -260,6 +283,7 @@ static void place(void *bp, size_t asize)
     if ((totalsize - asize) >= (2 * DSIZE))
     {
         // 블록 분할
+        MM_STAT(stats.splits++);
         PUT(HDRP(bp), PACK(asize, 1));
         PUT(FTRP(bp), PACK(asize, 1));
 
@@ -293,6 +317,7 @@ static void *coalesce(void *bp)
     // Case 1: 이전/다음 모두 할당됨
     if (prev_alloc && next_alloc)
     {
+        MM_STAT(stats.coalesce[0]++);
         insert_free_block(bp); // 새로운 free 블록 리스트에 추가
         return bp;
     }
@@ -300,6 +325,7 @@ static void *coalesce(void *bp)
     // Case 2: 이전 할당, 다음 free
     else if (prev_alloc && !next_alloc)
     {
+        MM_STAT(stats.coalesce[1]++);
         size += GET_SIZE(HDRP(NEXT_BLKP(bp)));
         delete_free_block(NEXT_BLKP(bp)); // 다음블록은 이제 없는거
 
@@ -311,6 +337,7 @@ static void *coalesce(void *bp)
     // Case 3: 이전 free, 다음 할당
     else if (!prev_alloc && next_alloc)
     {
+        MM_STAT(stats.coalesce[2]++);
         size += GET_SIZE(HDRP(PREV_BLKP(bp)));
         bp = PREV_BLKP(bp);
         delete_free_block(bp);
@@ -323,6 +350,7 @@ static void *coalesce(void *bp)
     // Case 4: 이전/다음 모두 free
     else
     {
+        MM_STAT(stats.coalesce[3]++);
         size += ( GET_SIZE(HDRP(PREV_BLKP(bp))) + GET_SIZE(HDRP(NEXT_BLKP(bp))) );
         delete_free_block(NEXT_BLKP(bp));
         bp = PREV_BLKP(bp);
@@ -368,6 +396,8 @@ void *mm_realloc(void *ptr, size_t size)
     // 축소
     if (asize < old_size && (old_size - asize) >= (2 * DSIZE)) 
     {
+        MM_STAT(stats.realloc_inplace++);
+        MM_STAT(stats.splits++);
         // 앞부분은 asize만큼 할당
         PUT(HDRP(ptr), PACK(asize, 1));
         PUT(FTRP(ptr), PACK(asize, 1));
@@ -395,12 +425,14 @@ void *mm_realloc(void *ptr, size_t size)
     // 1. next block만으로 확장
     if (!next_alloc && (old_size + next_size) >= asize) 
     {
+        MM_STAT(stats.realloc_inplace++);
         delete_free_block(next_blk);
         size_t combined_size = old_size + next_size;
 
         // 분할 가능하면 분할
         if ((combined_size - asize) >= (2 * DSIZE)) 
         {
+            MM_STAT(stats.splits++);
             PUT(HDRP(ptr), PACK(asize, 1));
             PUT(FTRP(ptr), PACK(asize, 1));
             char *next_new_blk = NEXT_BLKP(ptr);
@@ -424,10 +456,13 @@ void *mm_realloc(void *ptr, size_t size)
 
         // 데이터 이동 (payload 복사)
         memmove(prev_blk, ptr, (old_size - DSIZE < size) ? (old_size - DSIZE) : size);
+        MM_STAT(stats.realloc_inplace++);
+        MM_STAT(stats.realloc_copied += (old_size - DSIZE < size) ? (old_size - DSIZE) : size);
 
         // 분할 가능하면 분할
         if ((combined_size - asize) >= (2 * DSIZE)) 
         {
+            MM_STAT(stats.splits++);
             PUT(HDRP(prev_blk), PACK(asize, 1));
             PUT(FTRP(prev_blk), PACK(asize, 1));
             char *next_new_blk = NEXT_BLKP(prev_blk);
@@ -451,10 +486,13 @@ void *mm_realloc(void *ptr, size_t size)
 
         // 데이터 이동
         memmove(prev_blk, ptr, (old_size - DSIZE < size) ? (old_size - DSIZE) : size);
+        MM_STAT(stats.realloc_inplace++);
+        MM_STAT(stats.realloc_copied += (old_size - DSIZE < size) ? (old_size - DSIZE) : size);
 
         // 분할 가능하면 분할
         if ((combined_size - asize) >= (2 * DSIZE)) 
         {
+            MM_STAT(stats.splits++);
             PUT(HDRP(prev_blk), PACK(asize, 1));
             PUT(FTRP(prev_blk), PACK(asize, 1));
             char *next_new_blk = NEXT_BLKP(prev_blk);
@@ -477,7 +515,89 @@ void *mm_realloc(void *ptr, size_t size)
 
     size_t copySize = (old_size - DSIZE < size) ? (old_size - DSIZE) : size;
     memcpy(newptr, ptr, copySize);
+    MM_STAT(stats.realloc_moved++);
+    MM_STAT(stats.realloc_copied += copySize);
     mm_free(ptr);
 
     return newptr;
-}
\ No newline at end of file
+}
+
+/*
+ * mm_heap_walk - 힙의 블록을 주소 순서로 하나씩 돌려줌
+ *     *cursor가 NULL이면 첫 블록부터 시작, 에필로그에 닿으면 0을 리턴
+ */
+int mm_heap_walk(void **cursor, mm_block_t *blk)
+{
+    char *bp = (*cursor == NULL) ? NEXT_BLKP(heap_listp) : NEXT_BLKP(*cursor);
+
+    if (GET_SIZE(HDRP(bp)) == 0) return 0; // 에필로그
+
+    blk->addr = bp;
+    blk->size = GET_SIZE(HDRP(bp));
+    blk->alloc = GET_ALLOC(HDRP(bp));
+    blk->bin = blk->alloc ? -1 : 0; // free list는 하나뿐
+    *cursor = bp;
+    return 1;
+}
+
+#ifdef MM_STATS
+/*
+ * stat_class - 통계용 크기 클래스: bin이 없으니 2의 거듭제곱 구간 (<=32, <=64, ..., 그 이상)
+ */
+static int stat_class(size_t size)
+{
+    int cls = 0;
+    size_t max = 2 * DSIZE;
+
+    while (size > max && cls < STAT_CLASSES - 1)
+    {
+        max <<= 1;
+        cls++;
+    }
+    return cls;
+}
+
+/*
+ * stat_fit - find_fit 한 번의 탐색 노드 수와 hit/miss 기록
+ * 가용 리스트가 하나뿐이라 어떤 블록이든 찾으면 hit, 못 찾아서 힙을 늘리면 miss
+ */
+static void stat_fit(size_t asize, void *bp)
+{
+    int cls = stat_class(asize);
+
+    stats.fit_calls++;
+    stats.fit_visits += fit_visits_cur;
+    if (fit_visits_cur > stats.fit_visits_max) stats.fit_visits_max = fit_visits_cur;
+
+    if (bp != NULL) stats.bin_hits[cls]++;
+    else stats.bin_misses[cls]++;
+}
+
+/*
+ * mm_get_stats - 카운터 복사 + 힙 전체를 훑어서 클래스별 live/free 바이트 계산
+ */
+void mm_get_stats(mm_stats_t *out)
+{
+    char *bp;
+    int i, cls;
+
+    *out = stats;
+
+    out->nclasses = STAT_CLASSES;
+    for (i = 0; i < STAT_CLASSES - 1; i++) out->class_max[i] = (size_t)(2 * DSIZE) << i;
+    out->class_max[STAT_CLASSES - 1] = 0;
+
+    for (i = 0; i < MM_STAT_CLASSES; i++)
+    {
+        out->live_bytes[i] = 0;
+        out->free_bytes[i] = 0;
+    }
+
+    for (bp = NEXT_BLKP(heap_listp); GET_SIZE(HDRP(bp)) > 0; bp = NEXT_BLKP(bp))
+    {
+        cls = stat_class(GET_SIZE(HDRP(bp)));
+        if (GET_ALLOC(HDRP(bp))) out->live_bytes[cls] += GET_SIZE(HDRP(bp));
+        else out->free_bytes[cls] += GET_SIZE(HDRP(bp));
+    }
+}
+#endif
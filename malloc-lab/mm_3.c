@@ -21,7 +21,7 @@
  * ├─────────────────────────────┼─────────────────────────────────────────────┼────────────────────────────────────────────────────────────────────────────┤
  * │ 병합 정책(coalesce)          │ 즉시 병합                                     │ 인접 free 블록과 즉시 병합 후 bin/large list에 재삽입.                         │
  * ├─────────────────────────────┼─────────────────────────────────────────────┼────────────────────────────────────────────────────────────────────────────┤
- * │ 힙 확장                      │ mem_sbrk()                                  │ fit 실패 시 CHUNKSIZE 또는 요청 크기만큼 확장.                                 │
+ * │ 힙 확장                      │ mem_sbrk() + 적응형 확장 크기                  │ 최근 확장 빈도에 따라 확장 크기를 2배/감쇠, 힙 끝 free 블록은 부족분만 확장.       │
  * ├─────────────────────────────┼─────────────────────────────────────────────┼────────────────────────────────────────────────────────────────────────────┤
  * │ 블록 구조                    │ Header + Footer + Payload (+ pred/succ)     │ free 블록은 pred/succ 포인터 포함, 모든 블록 8바이트 정렬.                       │
  * ├─────────────────────────────┼─────────────────────────────────────────────┼────────────────────────────────────────────────────────────────────────────┤
@@ -33,6 +33,10 @@
  * - first-fit(빠른 탐색, 실 Unreal 스타일)과 best-fit(대형 블록 효율) 동시 적용.
  * - 모든 free 블록은 이중 연결 리스트로 관리, coalesce와 분할 효율적.
  * - realloc/병합/분할/확장 모두 bin/large 관리 정책에 따라 동작.
+ * - large 블록은 정확한 크기별 해시 캐시(exact_cache)를 large_listp와 같이 유지 -> 같은 크기 반복 요청은 탐색/분할 없이 O(1).
+ * - 수명 힌트(mm_malloc_hint): SHORT 블록은 main heap과 분리된 nursery에 bump 할당, nursery의 블록이 모두 free되면 통째로 재활용.
+ * - -DMM_PROFILE로 빌드하면 주요 함수마다 호출 수와 사이클(self/total)을 쌓아 mm_get_profile로 볼 수 있음 (기본 빌드에서는 매크로가 사라짐).
+ * - -DMM_STATS로 빌드하면 mm_get_stats로 find_fit 탐색 수, bin hit/miss, 분할/병합/확장/realloc 카운터를 볼 수 있음 (기본 빌드에서는 코드 자체가 없음).
  * - 멀티스레드 Thread Local Cache(TLS), OS 페이지 캐시, PoolInfo, hash mapping, 실시간 bin 튜닝, debug/profiler 기능 등은 미구현
  */
 
@@ -67,19 +71,45 @@ typedef struct
 } Bin;
 
 // Unreal 스타일 bin
-static size_t bin_sizes[BIN_COUNT] = 
-{
-    16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 208,
-    224, 240, 256, 288, 320, 352, 384, 416, 448, 480, 512,
-};
+static size_t bin_sizes[BIN_COUNT] = BIN_SIZES;
 
 static Bin bins[BIN_COUNT];
 
 // Large Block List (BIN_MAX_SIZE 초과 블록용 별도 free list)
 static void *large_listp = NULL; 
 
+// Large exact-size 캐시: 슬롯 하나가 한 가지 크기의 free large 블록 리스트(LIFO)를 가짐
+// 슬롯을 다른 크기가 쓰고 있으면 그 블록은 캐시하지 않고 large_listp에만 둠 (헤더 EXACT_BIT로 구분)
+typedef struct
+{
+    size_t size; // 이 슬롯이 맡은 블록 크기
+    void *head;  // 그 크기의 free 블록 리스트
+} ExactSlot;
+
+static ExactSlot exact_cache[EXACT_SLOTS];
+
+// Nursery: 수명이 짧은 블록만 bump 방식으로 몰아 넣는 영역 (main heap에서 받은 allocated 블록 하나)
+// nursery 블록 구조: [헤더: asize | NURSERY_BIT | 1][payload][푸터 자리: 소속 Nursery 포인터]
+typedef struct Nursery
+{
+    char *bump;  // 다음 블록의 헤더가 들어갈 위치
+    char *end;   // nursery 영역의 끝 (main heap 블록의 payload 끝)
+    size_t live; // 아직 free되지 않은 블록 수, 0이 되면 bump를 처음으로 되돌림
+} Nursery;
+
+#define NURSERY_START(n) ((char *)(n) + sizeof(Nursery)) // 첫 블록의 헤더 위치
+#define NURSERY_OWNER(bp) (*(Nursery **)FTRP(bp))        // nursery 블록이 속한 Nursery
+
+static Nursery *nursery_cur = NULL; // 현재 bump 할당 중인 nursery (다 찬 nursery는 은퇴, 마지막 free 때 반환)
+
+// 적응형 힙 확장: 자주 확장하면 grow_size를 2배씩(GROW_MAX까지), 뜸하면 GROW_WINDOW마다 절반씩(GROW_MIN까지)
+static size_t grow_size = CHUNKSIZE; // 다음 확장 때 최소로 늘릴 크기
+static size_t op_clock = 0;          // mm_malloc 호출 수 (성장률 측정용 시계)
+static size_t last_grow_clock = 0;   // 직전 확장 시점의 op_clock
+
 static char *heap_listp = NULL; 
 static void *extend_heap(size_t words);
+static void *grow_heap(size_t asize);
 static void *coalesce(void *bp);
 static void *find_fit(size_t asize);
 static void place(void *bp, size_t asize);
@@ -89,6 +119,106 @@ static void delete_free_block(void *bp);
 static int find_bin(size_t size);
 static void insert_large_block(void *bp);
 static void delete_large_block(void *bp);
+static void insert_exact_block(void *bp, size_t size);
+static void delete_exact_block(void *bp);
+
+static void *nursery_alloc(size_t asize);
+static void nursery_free(void *bp);
+
+// -------- 함수별 사이클 측정(MM_PROFILE 빌드) --------
+// PROF_SCOPE(f)를 함수 첫 줄에 두면 함수를 빠져나갈 때(return 어디서든) cleanup 속성으로 시간이 쌓임.
+// 호출 중인 함수들을 prof_top 스택으로 연결해서, 자식 함수 시간은 부모의 self에서 빠짐.
+#ifdef MM_PROFILE
+#include "clock.h"
+
+enum
+{
+    PROF_MM_MALLOC,
+    PROF_MM_FREE,
+    PROF_MM_REALLOC,
+    PROF_FIND_BIN,
+    PROF_FIND_FIT,
+    PROF_PLACE,
+    PROF_COALESCE,
+    PROF_EXTEND_HEAP,
+    PROF_GROW_HEAP,
+    PROF_INSERT_FREE_BLOCK,
+    PROF_DELETE_FREE_BLOCK,
+    PROF_NURSERY_ALLOC,
+    PROF_NURSERY_FREE,
+    PROF_NFUNCS
+};
+
+static const char *prof_names[PROF_NFUNCS] = {
+    "mm_malloc", "mm_free", "mm_realloc", "find_bin", "find_fit", "place", "coalesce", "extend_heap", "grow_heap", "insert_free_block", "delete_free_block", "nursery_alloc", "nursery_free"
+};
+
+typedef struct prof_frame
+{
+    int id;
+    unsigned long long start;   // 진입 시각
+    unsigned long long child;   // 이 호출 안에서 자식 함수들이 쓴 사이클
+    struct prof_frame *parent;
+} prof_frame_t;
+
+static mm_profile_t prof;            // mm_get_profile이 돌려줄 누적값 (mm_init에서 0으로)
+static prof_frame_t *prof_top = NULL; // 현재 실행 중인 가장 안쪽 함수
+static unsigned long long prof_ovhd = 0; // 빈 함수에서도 재지는 read_cycles 두 번 사이 사이클 (매 호출에서 뺌)
+
+static inline void prof_enter(prof_frame_t *fr, int id)
+{
+    fr->id = id;
+    fr->child = 0;
+    fr->parent = prof_top;
+    prof_top = fr;
+    fr->start = read_cycles();
+}
+
+static inline void prof_leave(prof_frame_t *fr)
+{
+    unsigned long long t = read_cycles() - fr->start;
+
+    t = (t > prof_ovhd) ? t - prof_ovhd : 0;
+    prof.calls[fr->id]++;
+    prof.total[fr->id] += t;
+    prof.self[fr->id] += t - fr->child;
+    prof_top = fr->parent;
+    if (prof_top != NULL)
+    {
+        prof_top->child += t;
+    }
+}
+
+// read_cycles를 연달아 읽은 최솟값 = 측정 구간에 항상 끼는 타이머 비용
+static void prof_calibrate(void)
+{
+    unsigned long long t0, t1, best = ~0ULL;
+
+    for (int i = 0; i < 1000; i++)
+    {
+        t0 = read_cycles();
+        t1 = read_cycles();
+        if (t1 - t0 < best)
+        {
+            best = t1 - t0;
+        }
+    }
+    prof_ovhd = best;
+}
+
+#define PROF_SCOPE(f) \
+    prof_frame_t prof_frame_ __attribute__((cleanup(prof_leave))); \
+    prof_enter(&prof_frame_, PROF_##f)
+#else
+#define PROF_SCOPE(f)
+#endif
+
+#ifdef MM_STATS
+static mm_stats_t stats;      // mm_get_stats가 돌려줄 카운터 (mm_init에서 0으로)
+static size_t fit_visits_cur; // 이번 find_fit 호출이 본 free 블록 수
+static int stat_class(size_t size);
+static void stat_fit(size_t asize, void *bp);
+#endif
 
 // bin sizes초기화 (분포는 배열, 초기화는 free list만)
 static void init_bin_sizes(void) 
@@ -98,11 +228,18 @@ static void init_bin_sizes(void)
         bins[i].free_listp = NULL;
     }
     large_listp = NULL;
+
+    for (int i = 0; i < EXACT_SLOTS; i++) 
+    {
+        exact_cache[i].size = 0;
+        exact_cache[i].head = NULL;
+    }
 }
 
 // size에 맞는 bin index 반환
 static int find_bin(size_t size) 
 {
+    PROF_SCOPE(FIND_BIN);
     for (int i = 0; i < BIN_COUNT; i++) 
     {
         if (size <= bin_sizes[i])
@@ -142,13 +279,19 @@ static void insert_large_block(void *bp)
     {
         large_listp = bp;
     }
-        
+
+    insert_exact_block(bp, GET_SIZE(HDRP(bp)));
 }
 
 
 // Large List에서 free 블록 제거
 static void delete_large_block(void *bp)
 {
+    if (GET(HDRP(bp)) & EXACT_BIT) 
+    {
+        delete_exact_block(bp);
+    }
+
     if (bp == large_listp) 
     {
         large_listp = SUCC(bp);
@@ -172,12 +315,54 @@ static void delete_large_block(void *bp)
     }
 }
 
+// exact 캐시의 크기 슬롯에 free large 블록 추가 (LIFO), 슬롯을 다른 크기가 쓰는 중이면 캐시 안 함
+static void insert_exact_block(void *bp, size_t size)
+{
+    ExactSlot *slot = &exact_cache[EXACT_HASH(size)];
+
+    if (slot->head != NULL && slot->size != size) return;
+
+    slot->size = size;
+    EPRED(bp) = NULL;
+    ESUCC(bp) = slot->head;
+    if (slot->head != NULL) 
+    {
+        EPRED(slot->head) = bp;
+    }
+    slot->head = bp;
+
+    PUT(HDRP(bp), GET(HDRP(bp)) | EXACT_BIT);
+}
+
+// exact 캐시에서 free large 블록 제거
+static void delete_exact_block(void *bp)
+{
+    ExactSlot *slot = &exact_cache[EXACT_HASH(GET_SIZE(HDRP(bp)))];
+
+    if (EPRED(bp)) 
+    {
+        ESUCC(EPRED(bp)) = ESUCC(bp);
+    }
+    else 
+    {
+        slot->head = ESUCC(bp);
+    }
+
+    if (ESUCC(bp)) 
+    {
+        EPRED(ESUCC(bp)) = EPRED(bp);
+    }
+
+    PUT(HDRP(bp), GET(HDRP(bp)) & ~EXACT_BIT);
+}
+
 /*
  *  insert_free_block - free 블록을 해당 bin/large list의 가용 리스트에 추가
  *  + small bin -> LIFO 삽입, large list -> address order
  */
 static void insert_free_block(void *bp)
 {
+    PROF_SCOPE(INSERT_FREE_BLOCK);
     size_t size = GET_SIZE(HDRP(bp));
 
     if (size > BIN_MAX_SIZE) 
@@ -204,6 +389,7 @@ static void insert_free_block(void *bp)
  */
 static void delete_free_block(void *bp)
 {
+    PROF_SCOPE(DELETE_FREE_BLOCK);
     size_t size = GET_SIZE(HDRP(bp));
 
     if (size > BIN_MAX_SIZE) 
@@ -245,6 +431,19 @@ static void delete_free_block(void *bp)
 int mm_init(void)
 {
     init_bin_sizes();
+    nursery_cur = NULL;
+    grow_size = CHUNKSIZE;
+    op_clock = 0;
+    last_grow_clock = 0;
+    MM_STAT(memset(&stats, 0, sizeof(stats)));
+#ifdef MM_PROFILE
+    memset(&prof, 0, sizeof(prof));
+    prof_top = NULL;
+    if (prof_ovhd == 0)
+    {
+        prof_calibrate();
+    }
+#endif
 
     if ((heap_listp = mem_sbrk(4*WSIZE)) == (void*)-1)  return -1;
 
@@ -265,11 +464,14 @@ int mm_init(void)
  */
 static void *extend_heap(size_t words)
 {
+    PROF_SCOPE(EXTEND_HEAP);
     char *bp;
     size_t size;
 
     size = (words % 2) ? (words + 1) * WSIZE : words * WSIZE;
     if ((long)(bp = mem_sbrk(size)) == -1) return NULL;
+    MM_STAT(stats.extend_calls++);
+    MM_STAT(stats.extend_bytes += size);
 
     PUT(HDRP(bp), PACK(size, 0));
     PUT(FTRP(bp), PACK(size, 0));
@@ -278,17 +480,53 @@ static void *extend_heap(size_t words)
     return coalesce(bp);
 }
 
+/*
+ * grow_heap - asize 블록이 들어가도록 힙 확장
+ * 힙 끝 블록이 free면 그만큼은 재사용하고 부족분만 확장 (extend_heap의 coalesce가 합쳐 줌)
+ * 확장 크기는 최근 성장률에 맞춤: 직전 확장 이후 GROW_WINDOW 이내면 2배, 아니면 지난 window 수만큼 절반씩 감쇠
+ */
+static void *grow_heap(size_t asize)
+{
+    PROF_SCOPE(GROW_HEAP);
+    char *epilogue = (char *)mem_heap_hi() + 1 - WSIZE;
+    size_t tail = GET_ALLOC(epilogue - WSIZE) ? 0 : GET_SIZE(epilogue - WSIZE); // 마지막 블록의 푸터
+    size_t need = asize - tail; // find_fit이 실패했으니 tail < asize
+    size_t gap = op_clock - last_grow_clock;
+    size_t extendsize;
+    void *bp;
+
+    if (gap <= GROW_WINDOW)
+    {
+        grow_size = (grow_size >= GROW_MAX / 2) ? GROW_MAX : grow_size * 2;
+    }
+    else
+    {
+        size_t decay = gap / GROW_WINDOW;
+        grow_size = (decay >= 16) ? GROW_MIN : MAX(grow_size >> decay, GROW_MIN);
+    }
+    last_grow_clock = op_clock;
+
+    extendsize = MAX(need, grow_size);
+    if ((bp = extend_heap(extendsize / WSIZE)) == NULL && extendsize > need)
+    {
+        bp = extend_heap(need / WSIZE); // 힙 한도 근처면 부족분만이라도
+    }
+    return bp;
+}
+
 /*
  * mm_malloc - bin/large list별로 asize에 맞는 블록 탐색, 없으면 힙 확장
  */
 void *mm_malloc(size_t size)
 {
+    PROF_SCOPE(MM_MALLOC);
     size_t asize;
-    size_t extendsize;
     char *bp;
 
     if (size == 0) return NULL;
 
+    op_clock++;
+
     if (size <= DSIZE) 
     {
         asize = 2 * DSIZE;
@@ -298,33 +536,113 @@ void *mm_malloc(size_t size)
         asize = ALIGN(size + DSIZE);
     }
 
-    if ((bp = find_fit(asize)) != NULL) 
+    bp = find_fit(asize);
+    MM_STAT(stat_fit(asize, bp));
+    if (bp != NULL) 
     {
         place(bp, asize);
         return bp;
     }
 
-    extendsize = (asize > CHUNKSIZE) ? asize : CHUNKSIZE;
-    if ((bp = extend_heap(extendsize / WSIZE)) == NULL) return NULL;
+    if ((bp = grow_heap(asize)) == NULL) return NULL;
 
     place(bp, asize);
     return bp;
 }
 
+/*
+ * mm_malloc_hint - 수명 힌트를 받아서 SHORT인 작은 요청은 nursery에 bump 할당
+ * LONG이거나 큰 요청은 그냥 mm_malloc과 같음
+ */
+void *mm_malloc_hint(size_t size, int hint)
+{
+    size_t asize;
+    void *bp;
+
+    if (hint != MM_HINT_SHORT || size == 0) return mm_malloc(size);
+
+    asize = (size <= DSIZE) ? 2 * DSIZE : ALIGN(size + DSIZE);
+    if (asize > NURSERY_MAX_REQ) return mm_malloc(size);
+
+    if ((bp = nursery_alloc(asize)) != NULL) return bp;
+
+    return mm_malloc(size); // nursery를 못 받아오면 main heap으로
+}
+
+/*
+ * nursery_alloc - 현재 nursery에서 asize만큼 bump 할당, 다 찼으면 새 nursery를 main heap에서 받아옴
+ * 다 찬 nursery는 은퇴만 시키고, 남은 블록이 전부 free될 때 nursery_free에서 main heap으로 반환
+ */
+static void *nursery_alloc(size_t asize)
+{
+    PROF_SCOPE(NURSERY_ALLOC);
+    Nursery *n = nursery_cur;
+    char *bp;
+
+    if (n == NULL || n->bump + asize > n->end)
+    {
+        if ((n = mm_malloc(NURSERY_SIZE)) == NULL) return NULL;
+
+        n->bump = NURSERY_START(n);
+        n->end = (char *)n + GET_SIZE(HDRP(n)) - DSIZE;
+        n->live = 0;
+        nursery_cur = n;
+    }
+
+    bp = n->bump + WSIZE;
+    PUT(HDRP(bp), PACK(asize, NURSERY_BIT | 1));
+    NURSERY_OWNER(bp) = n;
+
+    n->bump += asize;
+    n->live++;
+    return bp;
+}
+
+/*
+ * nursery_free - nursery 블록 해제, 개별 병합은 없고 live가 0이 되면 nursery 전체를 한 번에 재활용
+ */
+static void nursery_free(void *bp)
+{
+    PROF_SCOPE(NURSERY_FREE);
+    Nursery *n = NURSERY_OWNER(bp);
+
+    if (--n->live > 0) return;
+
+    if (n == nursery_cur)
+    {
+        n->bump = NURSERY_START(n); // 현재 nursery는 처음부터 다시 bump
+    }
+    else
+    {
+        mm_free(n); // 은퇴한 nursery는 통째로 main heap에 반환
+    }
+}
+
 /*
  * find_fit - small bin은 first-fit, large list는 best-fit
  */
 static void *find_fit(size_t asize)
 {
+    PROF_SCOPE(FIND_FIT);
     void *best = NULL;
 
-    // Large: large list, best-fit
+    MM_STAT(fit_visits_cur = 0);
+
+    // Large: 같은 크기가 캐시에 있으면 바로 (분할 없음), 아니면 large list best-fit
     if (asize > BIN_MAX_SIZE) 
     {
+        ExactSlot *slot = &exact_cache[EXACT_HASH(asize)];
+        if (slot->head != NULL && slot->size == asize) 
+        {
+            MM_STAT(fit_visits_cur = 1);
+            return slot->head;
+        }
+
         void *bp = large_listp;
         size_t min_size = (size_t)-1;
         while (bp) 
         {
+            MM_STAT(fit_visits_cur++);
             size_t curr_size = GET_SIZE(HDRP(bp));
             if (curr_size >= asize && curr_size < min_size) 
             {
@@ -347,6 +665,7 @@ static void *find_fit(size_t asize)
         void *bp = bins[i].free_listp;
         while (bp) 
         {
+            MM_STAT(fit_visits_cur++);
             size_t curr_size = GET_SIZE(HDRP(bp));
             if (curr_size >= asize)
             {
@@ -360,6 +679,7 @@ static void *find_fit(size_t asize)
     void *bp = large_listp;
     while (bp) 
     {
+        MM_STAT(fit_visits_cur++);
         size_t curr_size = GET_SIZE(HDRP(bp));
         if (curr_size >= asize)
         {
@@ -373,6 +693,7 @@ static void *find_fit(size_t asize)
 
 static void place(void *bp, size_t asize)
 {
+    PROF_SCOPE(PLACE);
     size_t totalsize = GET_SIZE(HDRP(bp)); // 현재 가용 블록의 전체 크기
 
     delete_free_block(bp); // 현재 속한 리스트(bin 또는 large)에서 제거
@@ -381,6 +702,7 @@ static void place(void *bp, size_t asize)
     if ((totalsize - asize) >= MIN_BLOCK_SIZE)
     {
         // 블록 분할
+        MM_STAT(stats.splits++);
         PUT(HDRP(bp), PACK(asize, 1));
         PUT(FTRP(bp), PACK(asize, 1));
 
@@ -405,17 +727,20 @@ static void place(void *bp, size_t asize)
  */
 static void *coalesce(void *bp)
 {
+    PROF_SCOPE(COALESCE);
     size_t prev_alloc = GET_ALLOC(FTRP(PREV_BLKP(bp))); // 이전 블록 할당 여부
     size_t next_alloc = GET_ALLOC(HDRP(NEXT_BLKP(bp))); // 다음 블록 할당 여부
     size_t size = GET_SIZE(HDRP(bp));                   // 현재 블록 크기
 
     if (prev_alloc && next_alloc)
     {
+        MM_STAT(stats.coalesce[0]++);
         insert_free_block(bp);
         return bp;
     }
     else if (prev_alloc && !next_alloc)
     {
+        MM_STAT(stats.coalesce[1]++);
         size += GET_SIZE(HDRP(NEXT_BLKP(bp)));
         delete_free_block(NEXT_BLKP(bp));
 
@@ -425,6 +750,7 @@ static void *coalesce(void *bp)
     }
     else if (!prev_alloc && next_alloc)
     {
+        MM_STAT(stats.coalesce[2]++);
         size += GET_SIZE(HDRP(PREV_BLKP(bp)));
         bp = PREV_BLKP(bp);
         delete_free_block(bp);
@@ -435,6 +761,7 @@ static void *coalesce(void *bp)
     }
     else
     {
+        MM_STAT(stats.coalesce[3]++);
         size += ( GET_SIZE(HDRP(PREV_BLKP(bp))) + GET_SIZE(HDRP(NEXT_BLKP(bp))) );
         delete_free_block(NEXT_BLKP(bp));
         bp = PREV_BLKP(bp);
@@ -453,6 +780,13 @@ static void *coalesce(void *bp)
  */
 void mm_free(void *bp)
 {
+    PROF_SCOPE(MM_FREE);
+    if (IS_NURSERY(bp))
+    {
+        nursery_free(bp);
+        return;
+    }
+
     size_t size = GET_SIZE(HDRP(bp));
     PUT(HDRP(bp), PACK(size, 0));
     PUT(FTRP(bp), PACK(size, 0));
@@ -465,6 +799,7 @@ void mm_free(void *bp)
  */
 void *mm_realloc(void *ptr, size_t size) 
 {
+    PROF_SCOPE(MM_REALLOC);
     if (ptr == NULL) return mm_malloc(size);
 
     if (size == 0) 
@@ -476,9 +811,30 @@ void *mm_realloc(void *ptr, size_t size)
     size_t old_size = GET_SIZE(HDRP(ptr));
     size_t asize = (size <= DSIZE) ? 2 * DSIZE : ALIGN(size + DSIZE);
 
+    // nursery 블록: 이웃이 nursery 내부라 병합 확장 불가, 들어가면 그대로 아니면 main heap으로 이사
+    if (IS_NURSERY(ptr))
+    {
+        if (asize <= old_size) 
+        {
+            MM_STAT(stats.realloc_inplace++);
+            return ptr;
+        }
+
+        void *newptr = mm_malloc(size);
+        if (newptr == NULL) return NULL;
+
+        MM_STAT(stats.realloc_moved++);
+        MM_STAT(stats.realloc_copied += old_size - DSIZE);
+        memcpy(newptr, ptr, old_size - DSIZE);
+        nursery_free(ptr);
+        return newptr;
+    }
+
     // 축소
     if (asize < old_size && (old_size - asize) >= MIN_BLOCK_SIZE) 
     {
+        MM_STAT(stats.realloc_inplace++);
+        MM_STAT(stats.splits++);
         PUT(HDRP(ptr), PACK(asize, 1));
         PUT(FTRP(ptr), PACK(asize, 1));
 
@@ -498,14 +854,30 @@ void *mm_realloc(void *ptr, size_t size)
     size_t next_alloc = GET_ALLOC(HDRP(next_blk));
     size_t next_size = GET_SIZE(HDRP(next_blk));
 
+    // 0. 힙 끝 블록이고 prev까지 합쳐도 모자라면 부족분만큼 힙을 늘려서 아래 1번(next로 확장)으로 처리
+    bool at_end = (next_size == 0) || (!next_alloc && GET_SIZE(HDRP(NEXT_BLKP(next_blk))) == 0);
+    size_t avail = old_size + (next_alloc ? 0 : next_size) + (prev_alloc ? 0 : prev_size);
+    if (at_end && avail < asize)
+    {
+        op_clock++;
+        if (grow_heap(asize - old_size) != NULL)
+        {
+            next_blk = NEXT_BLKP(ptr);
+            next_alloc = GET_ALLOC(HDRP(next_blk));
+            next_size = GET_SIZE(HDRP(next_blk));
+        }
+    }
+
     // 1. next block만으로 확장
     if (!next_alloc && (old_size + next_size) >= asize) 
     {
+        MM_STAT(stats.realloc_inplace++);
         delete_free_block(next_blk);
         size_t combined_size = old_size + next_size;
 
         if ((combined_size - asize) >= MIN_BLOCK_SIZE) 
         {
+            MM_STAT(stats.splits++);
             PUT(HDRP(ptr), PACK(asize, 1));
             PUT(FTRP(ptr), PACK(asize, 1));
             char *next_new_blk = NEXT_BLKP(ptr);
@@ -530,9 +902,12 @@ void *mm_realloc(void *ptr, size_t size)
         // payload 복사 시 헤더/푸터 제외
         size_t copy_n = (old_size - DSIZE < size) ? (old_size - DSIZE) : size;
         memmove(prev_blk, ptr, copy_n);
+        MM_STAT(stats.realloc_inplace++);
+        MM_STAT(stats.realloc_copied += copy_n);
 
         if ((combined_size - asize) >= MIN_BLOCK_SIZE) 
         {
+            MM_STAT(stats.splits++);
             PUT(HDRP(prev_blk), PACK(asize, 1));
             PUT(FTRP(prev_blk), PACK(asize, 1));
             char *next_new_blk = NEXT_BLKP(prev_blk);
@@ -557,9 +932,12 @@ void *mm_realloc(void *ptr, size_t size)
 
         size_t copy_n = (old_size - DSIZE < size) ? (old_size - DSIZE) : size;
         memmove(prev_blk, ptr, copy_n);
+        MM_STAT(stats.realloc_inplace++);
+        MM_STAT(stats.realloc_copied += copy_n);
 
         if ((combined_size - asize) >= MIN_BLOCK_SIZE) 
         {
+            MM_STAT(stats.splits++);
             PUT(HDRP(prev_blk), PACK(asize, 1));
             PUT(FTRP(prev_blk), PACK(asize, 1));
             char *next_new_blk = NEXT_BLKP(prev_blk);
@@ -582,7 +960,104 @@ void *mm_realloc(void *ptr, size_t size)
 
     size_t copySize = (old_size - DSIZE < size) ? (old_size - DSIZE) : size;
     memcpy(newptr, ptr, copySize);
+    MM_STAT(stats.realloc_moved++);
+    MM_STAT(stats.realloc_copied += copySize);
     mm_free(ptr);
 
     return newptr;
-}
\ No newline at end of file
+}
+
+/*
+ * mm_heap_walk - 힙의 블록을 주소 순서로 하나씩 돌려줌
+ *     *cursor가 NULL이면 첫 블록부터 시작, 에필로그에 닿으면 0을 리턴
+ */
+int mm_heap_walk(void **cursor, mm_block_t *blk)
+{
+    char *bp = (*cursor == NULL) ? NEXT_BLKP(heap_listp) : NEXT_BLKP(*cursor);
+
+    if (GET_SIZE(HDRP(bp)) == 0) return 0; // 에필로그
+
+    blk->addr = bp;
+    blk->size = GET_SIZE(HDRP(bp));
+    blk->alloc = GET_ALLOC(HDRP(bp));
+    if (blk->alloc) blk->bin = -1;
+    else if (blk->size > BIN_MAX_SIZE) blk->bin = BIN_COUNT; // large_listp는 마지막 bin 다음 번호로
+    else blk->bin = find_bin(blk->size);
+    *cursor = bp;
+    return 1;
+}
+
+#ifdef MM_STATS
+/*
+ * stat_class - 통계용 크기 클래스: small은 bin 번호 그대로, large는 마지막 bin 다음 클래스 하나
+ */
+static int stat_class(size_t size)
+{
+    int nsmall = 0;
+
+    if (size <= BIN_MAX_SIZE) return find_bin(size);
+
+    while (nsmall < BIN_COUNT && bin_sizes[nsmall] != 0) nsmall++;
+    return nsmall;
+}
+
+/*
+ * stat_fit - find_fit 한 번의 탐색 노드 수와 bin hit/miss 기록
+ * 요청 크기의 bin(large는 large list)에서 찾았으면 hit, 더 큰 bin으로 넘어갔거나 못 찾았으면 miss
+ */
+static void stat_fit(size_t asize, void *bp)
+{
+    int cls = stat_class(asize);
+
+    stats.fit_calls++;
+    stats.fit_visits += fit_visits_cur;
+    if (fit_visits_cur > stats.fit_visits_max) stats.fit_visits_max = fit_visits_cur;
+
+    if (bp != NULL && stat_class(GET_SIZE(HDRP(bp))) == cls) stats.bin_hits[cls]++;
+    else stats.bin_misses[cls]++;
+}
+
+/*
+ * mm_get_stats - 카운터 복사 + 힙 전체를 훑어서 클래스별 live/free 바이트 계산
+ * nursery는 main heap 입장에서 allocated 블록 하나라서 large 클래스의 live로 잡힘
+ */
+void mm_get_stats(mm_stats_t *out)
+{
+    char *bp;
+    int i, cls;
+
+    *out = stats;
+
+    out->nclasses = stat_class(BIN_MAX_SIZE + 1) + 1;
+    for (i = 0; i < out->nclasses - 1; i++) out->class_max[i] = bin_sizes[i];
+    out->class_max[out->nclasses - 1] = 0;
+
+    for (i = 0; i < MM_STAT_CLASSES; i++)
+    {
+        out->live_bytes[i] = 0;
+        out->free_bytes[i] = 0;
+    }
+
+    for (bp = NEXT_BLKP(heap_listp); GET_SIZE(HDRP(bp)) > 0; bp = NEXT_BLKP(bp))
+    {
+        cls = stat_class(GET_SIZE(HDRP(bp)));
+        if (GET_ALLOC(HDRP(bp))) out->live_bytes[cls] += GET_SIZE(HDRP(bp));
+        else out->free_bytes[cls] += GET_SIZE(HDRP(bp));
+    }
+}
+#endif
+
+#ifdef MM_PROFILE
+/*
+ * mm_get_profile - mm_init 이후 함수별 호출 수와 사이클을 복사해서 돌려줌
+ */
+void mm_get_profile(mm_profile_t *out)
+{
+    *out = prof;
+    out->nfuncs = PROF_NFUNCS;
+    for (int i = 0; i < PROF_NFUNCS; i++)
+    {
+        out->name[i] = prof_names[i];
+    }
+}
+#endif
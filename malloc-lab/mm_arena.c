@@ -0,0 +1,172 @@
+/*
+ * mm_arena.c - Region(arena) 할당기. mm_malloc 위에서 동작함
+ *
+ * - chunk 단위로 main 할당기(mm_malloc)에서 메모리를 받아와서 bump pointer로 잘라 줌
+ * - 개별 free 없음: mm_arena_reset 한 번에 받아온 chunk를 통째로 mm_free로 돌려줌
+ *   -> 객체 수와 상관없이 chunk 수만큼만 비용, 객체별 mm_free + coalesce 비용이 사라짐
+ * - 한 요청(request) 동안 같이 태어나서 같이 죽는 객체들에 적합
+ * - 어떤 mm_*.c와도 같이 링크 가능 (mm_malloc/mm_free만 씀)
+ *
+ * chunk 구조: [다음 chunk 포인터][이전 chunk 포인터][객체][객체]...
+ * chunk_size/4보다 큰 객체는 전용 chunk에 혼자 들어감 -> mm_arena_realloc이 chunk째로 키울 수 있음
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mm.h"
+
+#define ALIGNMENT 8
+#define ALIGN(size) (((size) + (ALIGNMENT - 1)) & ~0x7)
+
+#define ARENA_CHUNK_SIZE (1<<12)               // chunk_size를 0으로 주면 쓰는 기본 chunk 크기
+#define CHUNK_HDR        ALIGN(2 * sizeof(void *)) // chunk 앞의 다음/이전 chunk 포인터 자리
+#define CHUNK_NEXT(c)    (((void **)(c))[0])
+#define CHUNK_PREV(c)    (((void **)(c))[1])
+#define IS_LARGE(arena, asize) ((asize) > (arena)->chunk_size / 4) // 전용 chunk에 들어가는 크기
+
+struct mm_arena
+{
+    char *bump;        // 현재 chunk에서 다음 객체가 들어갈 위치
+    char *end;         // 현재 chunk의 끝
+    void *chunks;      // 받아온 chunk들의 이중 연결 리스트 (reset 때 전부 반환)
+    size_t chunk_size; // 새 chunk에 들어가는 객체 바이트 수
+};
+
+/*
+ * arena_new_chunk - size 바이트 이상 들어가는 chunk를 받아와서 리스트에 연결, 데이터 시작 주소 반환
+ */
+static char *arena_new_chunk(mm_arena_t *arena, size_t size)
+{
+    void *chunk;
+
+    if ((chunk = mm_malloc(CHUNK_HDR + size)) == NULL) return NULL;
+
+    CHUNK_NEXT(chunk) = arena->chunks;
+    CHUNK_PREV(chunk) = NULL;
+    if (arena->chunks != NULL) CHUNK_PREV(arena->chunks) = chunk;
+    arena->chunks = chunk;
+    return (char *)chunk + CHUNK_HDR;
+}
+
+/*
+ * mm_arena_create - 빈 arena 생성, chunk는 첫 할당 때 받아옴
+ * chunk_size는 chunk 하나에 들어갈 객체 바이트 수 (chunk 헤더 제외), 0이면 기본 크기
+ * arena 구조체 자체도 main 할당기에서 받아옴
+ */
+mm_arena_t *mm_arena_create(size_t chunk_size)
+{
+    mm_arena_t *arena;
+
+    if ((arena = mm_malloc(sizeof(mm_arena_t))) == NULL) return NULL;
+
+    arena->bump = NULL;
+    arena->end = NULL;
+    arena->chunks = NULL;
+    arena->chunk_size = (chunk_size > 0) ? ALIGN(chunk_size) : ARENA_CHUNK_SIZE - CHUNK_HDR;
+    return arena;
+}
+
+/*
+ * mm_arena_alloc - bump pointer 할당, 현재 chunk가 모자라면 새 chunk를 받아옴
+ * chunk_size의 1/4보다 큰 요청은 항상 전용 chunk를 따로 받아서 현재 chunk의 남은 공간을 버리지 않음
+ */
+void *mm_arena_alloc(mm_arena_t *arena, size_t size)
+{
+    size_t asize;
+    char *bp;
+
+    if (size == 0) return NULL;
+
+    asize = ALIGN(size);
+
+    // 큰 요청: 전용 chunk
+    if (IS_LARGE(arena, asize))
+    {
+        return arena_new_chunk(arena, asize);
+    }
+
+    if (arena->bump != NULL && arena->bump + asize <= arena->end)
+    {
+        bp = arena->bump;
+        arena->bump += asize;
+        return bp;
+    }
+
+    // 새 chunk로 넘어감 (이전 chunk의 남은 꼬리는 reset까지 그냥 둠)
+    if ((bp = arena_new_chunk(arena, arena->chunk_size)) == NULL) return NULL;
+
+    arena->bump = bp + asize;
+    arena->end = bp + arena->chunk_size;
+    return bp;
+}
+
+/*
+ * mm_arena_realloc - ptr 블록을 size 바이트로 늘림
+ * oldsize는 블록을 할당했거나 마지막으로 늘린 크기 (줄인 크기가 아님)
+ * - 줄이는 건 제자리
+ * - 마지막 bump 할당이고 현재 chunk에 자리가 있으면 bump만 옮김
+ * - 전용 chunk에 혼자 있으면 chunk째로 mm_realloc, main 할당기가 제자리에서 늘릴 수도 있음
+ * - 나머지는 새로 할당해서 복사 (이전 블록은 reset까지 그냥 둠)
+ */
+void *mm_arena_realloc(mm_arena_t *arena, void *ptr, size_t oldsize, size_t size)
+{
+    size_t oldasize = ALIGN(oldsize), asize = ALIGN(size);
+    char *bp = ptr;
+    void *chunk;
+
+    if (ptr == NULL) return mm_arena_alloc(arena, size);
+    if (asize <= oldasize) return ptr;
+
+    // 마지막 bump 할당: 전용 chunk 크기가 되지 않는 한 bump만 옮김
+    if (bp + oldasize == arena->bump && !IS_LARGE(arena, asize) && bp + asize <= arena->end)
+    {
+        arena->bump = bp + asize;
+        return ptr;
+    }
+
+    // 전용 chunk: 옮겨졌으면 리스트의 앞뒤 연결을 고침
+    if (IS_LARGE(arena, oldasize))
+    {
+        if ((chunk = mm_realloc(bp - CHUNK_HDR, CHUNK_HDR + asize)) == NULL) return NULL;
+
+        if (CHUNK_PREV(chunk) != NULL) CHUNK_NEXT(CHUNK_PREV(chunk)) = chunk;
+        else arena->chunks = chunk;
+        if (CHUNK_NEXT(chunk) != NULL) CHUNK_PREV(CHUNK_NEXT(chunk)) = chunk;
+        return (char *)chunk + CHUNK_HDR;
+    }
+
+    if ((bp = mm_arena_alloc(arena, size)) == NULL) return NULL;
+    memcpy(bp, ptr, oldsize);
+    return bp;
+}
+
+/*
+ * mm_arena_reset - arena의 모든 객체를 한 번에 해제, 받아온 chunk를 전부 main 할당기에 반환
+ * arena 자체는 다시 쓸 수 있음
+ */
+void mm_arena_reset(mm_arena_t *arena)
+{
+    void *chunk = arena->chunks;
+
+    while (chunk != NULL)
+    {
+        void *next = CHUNK_NEXT(chunk);
+        mm_free(chunk);
+        chunk = next;
+    }
+
+    arena->chunks = NULL;
+    arena->bump = NULL;
+    arena->end = NULL;
+}
+
+/*
+ * mm_arena_destroy - reset 후 arena 구조체까지 반환
+ */
+void mm_arena_destroy(mm_arena_t *arena)
+{
+    mm_arena_reset(arena);
+    mm_free(arena);
+}
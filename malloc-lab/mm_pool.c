@@ -0,0 +1,297 @@
+/*
+ * mm_pool.c - 고정 크기 객체 풀. mm_malloc 위에서 동작함
+ *
+ * - 풀 하나가 한 가지 크기(obj_size)의 객체만 관리 (connection, request, timer 같은 hot 타입용)
+ * - slab 단위로 main 할당기(mm_malloc)에서 메모리를 받아옴
+ * - free된 객체는 객체 자신의 첫 워드를 next로 쓰는 intrusive free list에 LIFO로 연결
+ * - 할당: free list pop 또는 현재 slab에서 bump -> 탐색 없음, 병합 없음, 항상 O(1)
+ * - MM_POOL_TCACHE로 빌드하면 스레드별 캐시를 먼저 쓰고, 공유 free list/slab은 풀 mutex로 보호
+ *   main heap의 mm_malloc/mm_free는 스레드 안전하지 않고 풀 mutex는 풀마다 따로라서,
+ *   이 파일의 main heap 호출(create, slab, destroy)은 전부 전역 heap_lock 하나로 직렬화
+ *   (lock 순서: epoch_lock -> 풀 mutex -> heap_lock. 다른 코드가 다른 스레드에서 mm_malloc을 직접 부르는 건 못 막음)
+ * - 캐시 슬롯은 풀 포인터가 아니라 재사용되지 않는 풀 id로 확인 (destroy 뒤 같은 주소에 생긴 풀과 헷갈리지 않게)
+ *   destroy는 그 슬롯 번호의 slot_epoch를 올려서 다른 스레드의 캐시를 무효화함. 다른 스레드는 슬롯을 넘겨줄 때
+ *   epoch가 바뀌었으면 이전 풀이 사라졌을 수 있으니 객체를 건드리지 않고 버림
+ *   (같은 슬롯의 살아있는 다른 풀 객체였다면 그 풀의 destroy 때 slab째로 회수됨)
+ *
+ * slab 구조: [다음 slab 포인터][정렬 패딩][객체][객체]...
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#ifdef MM_POOL_TCACHE
+#include <pthread.h>
+#endif
+
+#include "mm.h"
+
+#define ALIGNMENT 8
+#define ALIGN(size) (((size) + (ALIGNMENT - 1)) & ~0x7)
+
+#define POOL_SLAB_SIZE (1<<14)          // slab 하나의 크기 16KB (객체가 크면 최소 POOL_SLAB_MIN_OBJS개 들어가게 키움)
+#define POOL_SLAB_MIN_OBJS 8
+#define SLAB_NEXT(s) (*(void **)(s))
+#define OBJ_NEXT(p)  (*(void **)(p))    // free 객체의 첫 워드 = free list의 다음 객체
+
+#define ALIGN_UP(p, a) ((char *)(((uintptr_t)(p) + ((a) - 1)) & ~(uintptr_t)((a) - 1)))
+
+#ifdef MM_POOL_TCACHE
+#define TCACHE_SLOTS 8   // 스레드마다 캐시할 수 있는 풀 수 (pool id로 직접 매핑)
+#define TCACHE_MAX   64  // 슬롯 하나에 쌓아 둘 최대 객체 수, 넘치면 절반을 풀로 반환
+
+typedef struct
+{
+    mm_pool_t *pool; // 이 슬롯을 쓰는 풀
+    uint64_t id;     // 그 풀의 id, 0이면 빈 슬롯
+    uint64_t epoch;  // 슬롯을 가져올 때의 slot_epoch
+    void *head;      // 스레드 로컬 free list
+    int count;
+} TCache;
+
+static __thread TCache tcache[TCACHE_SLOTS];
+static uint64_t next_pool_id = 1; // 풀 id는 1부터, 재사용 안 함
+
+static uint64_t slot_epoch[TCACHE_SLOTS];                      // 슬롯 번호마다 destroy된 풀 수
+static pthread_mutex_t epoch_lock = PTHREAD_MUTEX_INITIALIZER; // slot_epoch와 슬롯 넘겨주기를 보호
+
+static pthread_mutex_t heap_lock = PTHREAD_MUTEX_INITIALIZER; // main heap 호출 전부를 감쌈
+#define HEAP_LOCK()   pthread_mutex_lock(&heap_lock)
+#define HEAP_UNLOCK() pthread_mutex_unlock(&heap_lock)
+#else
+#define HEAP_LOCK()
+#define HEAP_UNLOCK()
+#endif
+
+struct mm_pool
+{
+    size_t stride;    // 객체 하나가 차지하는 크기 (obj_size를 align 배수로 올림)
+    size_t align;     // 객체 정렬
+    size_t slab_size; // slab 하나를 mm_malloc으로 받을 크기
+    void *free_list;  // free된 객체들 (intrusive, LIFO)
+    char *bump;       // 현재 slab에서 아직 한 번도 안 나간 객체 위치
+    char *end;        // 현재 slab의 끝
+    void *slabs;      // 받아온 slab들의 단일 연결 리스트 (destroy 때 전부 반환)
+#ifdef MM_POOL_TCACHE
+    uint64_t id;
+    pthread_mutex_t lock;
+#endif
+};
+
+/*
+ * pool_new_slab - slab 하나를 받아와서 bump 구간으로 설정
+ */
+static int pool_new_slab(mm_pool_t *pool)
+{
+    void *slab;
+
+    HEAP_LOCK();
+    slab = mm_malloc(pool->slab_size);
+    HEAP_UNLOCK();
+    if (slab == NULL) return 0;
+
+    SLAB_NEXT(slab) = pool->slabs;
+    pool->slabs = slab;
+
+    pool->bump = ALIGN_UP((char *)slab + sizeof(void *), pool->align);
+    pool->end = (char *)slab + pool->slab_size;
+    return 1;
+}
+
+/*
+ * pool_get - 공유 free list pop, 없으면 slab에서 bump, slab도 다 썼으면 새 slab
+ */
+static void *pool_get(mm_pool_t *pool)
+{
+    void *p = pool->free_list;
+
+    if (p != NULL)
+    {
+        pool->free_list = OBJ_NEXT(p);
+        return p;
+    }
+
+    if ((pool->bump == NULL || pool->bump + pool->stride > pool->end) && !pool_new_slab(pool))
+    {
+        return NULL;
+    }
+
+    p = pool->bump;
+    pool->bump += pool->stride;
+    return p;
+}
+
+/*
+ * pool_put - 공유 free list에 LIFO push
+ */
+static void pool_put(mm_pool_t *pool, void *p)
+{
+    OBJ_NEXT(p) = pool->free_list;
+    pool->free_list = p;
+}
+
+#ifdef MM_POOL_TCACHE
+/*
+ * tcache_flush - 슬롯에 남은 객체를 n개까지 원래 풀에 반환
+ */
+static void tcache_flush(TCache *tc, int n)
+{
+    mm_pool_t *pool = tc->pool;
+
+    pthread_mutex_lock(&pool->lock);
+    while (n-- > 0 && tc->head != NULL)
+    {
+        void *p = tc->head;
+        tc->head = OBJ_NEXT(p);
+        tc->count--;
+        pool_put(pool, p);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/*
+ * tcache_evict - 슬롯을 비우고 epoch를 새로 받음
+ * 슬롯을 가져온 뒤로 slot_epoch가 바뀌었으면 슬롯의 풀이 destroy됐을 수 있으니 객체를 그냥 버림
+ * epoch_lock을 잡은 채로 반환하니까 destroy가 그 사이에 끼어들 수 없음
+ */
+static void tcache_evict(TCache *tc, unsigned slot)
+{
+    pthread_mutex_lock(&epoch_lock);
+    if (tc->id != 0 && tc->epoch == slot_epoch[slot]) tcache_flush(tc, tc->count);
+    tc->epoch = slot_epoch[slot];
+    pthread_mutex_unlock(&epoch_lock);
+
+    tc->pool = NULL;
+    tc->id = 0;
+    tc->head = NULL;
+    tc->count = 0;
+}
+#endif
+
+/*
+ * mm_pool_create - obj_size 크기, align 정렬(2의 거듭제곱, 0이면 ALIGNMENT)인 객체 풀 생성
+ * slab은 첫 할당 때 받아옴, 풀 구조체 자체도 main 할당기에서 받아옴
+ */
+mm_pool_t *mm_pool_create(size_t obj_size, size_t align)
+{
+    mm_pool_t *pool;
+
+    if (obj_size == 0) return NULL;
+    if (align < ALIGNMENT) align = ALIGNMENT;
+    if (align & (align - 1)) return NULL;
+
+    HEAP_LOCK();
+    pool = mm_malloc(sizeof(mm_pool_t));
+    HEAP_UNLOCK();
+    if (pool == NULL) return NULL;
+
+    // free 객체는 next 포인터를 담아야 하니까 최소 포인터 크기
+    pool->stride = (obj_size < sizeof(void *)) ? sizeof(void *) : obj_size;
+    pool->stride = (pool->stride + align - 1) & ~(align - 1);
+    pool->align = align;
+
+    pool->slab_size = POOL_SLAB_SIZE;
+    if (pool->slab_size < sizeof(void *) + align + POOL_SLAB_MIN_OBJS * pool->stride)
+    {
+        pool->slab_size = ALIGN(sizeof(void *) + align + POOL_SLAB_MIN_OBJS * pool->stride);
+    }
+
+    pool->free_list = NULL;
+    pool->bump = NULL;
+    pool->end = NULL;
+    pool->slabs = NULL;
+#ifdef MM_POOL_TCACHE
+    pool->id = __sync_fetch_and_add(&next_pool_id, 1);
+    pthread_mutex_init(&pool->lock, NULL);
+#endif
+    return pool;
+}
+
+/*
+ * mm_pool_alloc - 객체 하나 할당 (스레드 캐시 -> 공유 free list -> slab bump 순서)
+ */
+void *mm_pool_alloc(mm_pool_t *pool)
+{
+#ifdef MM_POOL_TCACHE
+    TCache *tc = &tcache[pool->id % TCACHE_SLOTS];
+    void *p;
+
+    if (tc->id == pool->id && tc->head != NULL)
+    {
+        p = tc->head;
+        tc->head = OBJ_NEXT(p);
+        tc->count--;
+        return p;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    p = pool_get(pool);
+    pthread_mutex_unlock(&pool->lock);
+    return p;
+#else
+    return pool_get(pool);
+#endif
+}
+
+/*
+ * mm_pool_free - 객체 하나 반환, 병합 없이 free list에 push만 함
+ */
+void mm_pool_free(mm_pool_t *pool, void *ptr)
+{
+    if (ptr == NULL) return;
+
+#ifdef MM_POOL_TCACHE
+    TCache *tc = &tcache[pool->id % TCACHE_SLOTS];
+
+    // 슬롯을 다른 풀이 쓰고 있었으면 그 풀 객체를 돌려주고 (살아있을 때만) 슬롯을 가져옴
+    if (tc->id != pool->id)
+    {
+        tcache_evict(tc, pool->id % TCACHE_SLOTS);
+        tc->pool = pool;
+        tc->id = pool->id;
+    }
+
+    OBJ_NEXT(ptr) = tc->head;
+    tc->head = ptr;
+    if (++tc->count > TCACHE_MAX) tcache_flush(tc, TCACHE_MAX / 2);
+#else
+    pool_put(pool, ptr);
+#endif
+}
+
+/*
+ * mm_pool_destroy - 풀의 slab을 전부 main 할당기에 반환하고 풀 구조체도 반환
+ * 살아있는 객체가 있어도 같이 사라짐 (다른 스레드는 이 풀을 더 쓰면 안 됨)
+ * 다른 스레드 캐시에 남은 이 풀의 객체는 slot_epoch로 무효화되어 그 스레드가 버림
+ */
+void mm_pool_destroy(mm_pool_t *pool)
+{
+    void *slab = pool->slabs;
+
+#ifdef MM_POOL_TCACHE
+    TCache *tc = &tcache[pool->id % TCACHE_SLOTS];
+    if (tc->id == pool->id)
+    {
+        tc->pool = NULL;
+        tc->id = 0;
+        tc->head = NULL;
+        tc->count = 0;
+    }
+
+    pthread_mutex_lock(&epoch_lock);
+    slot_epoch[pool->id % TCACHE_SLOTS]++;
+    pthread_mutex_unlock(&epoch_lock);
+    pthread_mutex_destroy(&pool->lock);
+#endif
+
+    HEAP_LOCK();
+    while (slab != NULL)
+    {
+        void *next = SLAB_NEXT(slab);
+        mm_free(slab);
+        slab = next;
+    }
+    mm_free(pool);
+    HEAP_UNLOCK();
+}
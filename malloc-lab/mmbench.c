@@ -0,0 +1,137 @@
+/*
+ * mmbench.c - Microbenchmarks for the mm allocator extensions
+ *
+ * Compares fixed-size object pools (mm_pool.c) against plain
+ * mm_malloc/mm_free at the same request sizes. Each size is run with
+ * two access patterns:
+ *
+ *   pair   allocate one object and free it right away
+ *   batch  allocate BATCH objects, then free them all (LIFO order)
+ *
+ * Times come from the same timing package that mdriver uses (fsecs),
+ * and are reported as nanoseconds per alloc/free pair.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+
+#include "mm.h"
+#include "memlib.h"
+#include "fsecs.h"
+#include "config.h"
+
+/* Misc */
+#define PAIRS 100000 /* alloc/free pairs per timed run */
+#define BATCH 1000	 /* objects live at once in the batch pattern */
+
+int verbose = 0; /* needed by fsecs.c */
+
+/* The object sizes to compare, e.g. timer, request, connection objects */
+static size_t sizes[] = {16, 24, 48, 64, 112, 200, 256, 448};
+
+/* Parameters passed to the timed functions through fsecs */
+typedef struct
+{
+	size_t size;  /* object size */
+	int batch;	  /* objects allocated before they are freed */
+	void **slots; /* the live objects of the current batch */
+} bench_t;
+
+static void app_error(char *msg);
+
+/*
+ * bench_mm - alloc/free pairs through mm_malloc and mm_free
+ */
+static void bench_mm(void *ptr)
+{
+	bench_t *b = (bench_t *)ptr;
+	int i, j;
+
+	mem_reset_brk();
+	if (mm_init() < 0)
+		app_error("mm_init failed in bench_mm");
+
+	for (i = 0; i < PAIRS; i += b->batch)
+	{
+		for (j = 0; j < b->batch; j++)
+			if ((b->slots[j] = mm_malloc(b->size)) == NULL)
+				app_error("mm_malloc failed in bench_mm");
+		for (j = b->batch - 1; j >= 0; j--)
+			mm_free(b->slots[j]);
+	}
+}
+
+/*
+ * bench_pool - the same pairs through mm_pool_alloc and mm_pool_free
+ */
+static void bench_pool(void *ptr)
+{
+	bench_t *b = (bench_t *)ptr;
+	mm_pool_t *pool;
+	int i, j;
+
+	mem_reset_brk();
+	if (mm_init() < 0)
+		app_error("mm_init failed in bench_pool");
+	if ((pool = mm_pool_create(b->size, 0)) == NULL)
+		app_error("mm_pool_create failed in bench_pool");
+
+	for (i = 0; i < PAIRS; i += b->batch)
+	{
+		for (j = 0; j < b->batch; j++)
+			if ((b->slots[j] = mm_pool_alloc(pool)) == NULL)
+				app_error("mm_pool_alloc failed in bench_pool");
+		for (j = b->batch - 1; j >= 0; j--)
+			mm_pool_free(pool, b->slots[j]);
+	}
+	mm_pool_destroy(pool);
+}
+
+int main(int argc, char **argv)
+{
+	bench_t b;
+	int i, k;
+	int batches[] = {1, BATCH};
+	char *names[] = {"pair", "batch"};
+	double mm_ns, pool_ns;
+
+	if (argc > 1)
+	{
+		fprintf(stderr, "Usage: %s\n", argv[0]);
+		exit(1);
+	}
+
+	if ((b.slots = (void **)malloc(BATCH * sizeof(void *))) == NULL)
+		app_error("malloc failed in main");
+
+	mem_init();
+	init_fsecs();
+
+	printf("%6s%8s%14s%14s%9s\n", "size", "pattern", "mm ns/pair", "pool ns/pair", "speedup");
+	for (i = 0; i < (int)(sizeof(sizes) / sizeof(sizes[0])); i++)
+	{
+		for (k = 0; k < 2; k++)
+		{
+			b.size = sizes[i];
+			b.batch = batches[k];
+			mm_ns = fsecs(bench_mm, &b) * 1e9 / PAIRS;
+			pool_ns = fsecs(bench_pool, &b) * 1e9 / PAIRS;
+			printf("%6lu%8s%14.2f%14.2f%8.2fx\n",
+				   (unsigned long)b.size, names[k], mm_ns, pool_ns, mm_ns / pool_ns);
+		}
+	}
+
+	mem_deinit();
+	free(b.slots);
+	exit(0);
+}
+
+/*
+ * app_error - Report an arbitrary application error
+ */
+static void app_error(char *msg)
+{
+	printf("%s\n", msg);
+	exit(1);
+}
@@ -0,0 +1,119 @@
+/****************************
+ * Time the mm allocator on a trace, streamed
+ ****************************/
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "tracestream.h"
+#include "idmap.h"
+#include "mm.h"
+#include "memlib.h"
+#include "mmreplay.h"
+
+/*
+ * replay_once - One pass of the trace at path; return the seconds it
+ *     took, or -1 with r->error set
+ */
+static double replay_once(char *path, mmreplay_t *r)
+{
+    tracestream_t *s;
+    traceio_op_t *ops, *op;
+    idmap_t *map = NULL;
+    idmap_entry_t *e, old;
+    uint64_t opnum = 0, live = 0, peak = 0;
+    struct timespec t0, t1;
+    double secs = -1;
+    long i, n = 0;
+    void *ptr;
+
+    if ((s = tracestream_open(path, TRACESTREAM_CHUNK)) == NULL) {
+	snprintf(r->error, sizeof(r->error), "%s", strerror(errno));
+	return -1;
+    }
+    if ((map = idmap_new()) == NULL) {
+	strcpy(r->error, "out of memory");
+	goto out;
+    }
+
+    mem_reset_brk();
+    if (mm_init() < 0) {
+	strcpy(r->error, "mm_init failed");
+	goto out;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    while ((n = tracestream_next(s, &ops)) > 0)
+	for (i = 0; i < n; i++, opnum++) {
+	    op = &ops[i];
+	    switch (op->type) {
+	    case TRACEIO_ALLOC:
+		if ((ptr = mm_malloc(op->size)) == NULL || (e = idmap_put(map, op->id)) == NULL) {
+		    sprintf(r->error, "mm_malloc failed at op %llu", (unsigned long long) opnum);
+		    goto out;
+		}
+		e->ptr = ptr;
+		e->size = op->size;
+		live += op->size;
+		break;
+
+	    case TRACEIO_REALLOC:
+		e = idmap_get(map, op->id);
+		if (e == NULL || (ptr = mm_realloc(e->ptr, op->size)) == NULL) {
+		    sprintf(r->error, "mm_realloc failed at op %llu", (unsigned long long) opnum);
+		    goto out;
+		}
+		live += op->size - e->size;
+		e->ptr = ptr;
+		e->size = op->size;
+		break;
+
+	    default:
+		if (idmap_remove(map, op->id, &old)) {
+		    mm_free(old.ptr);
+		    live -= old.size;
+		}
+		continue;
+	    }
+	    if (live > peak)
+		peak = live;
+	}
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    if (n < 0) {
+	snprintf(r->error, sizeof(r->error), "%s", s->error);
+	goto out;
+    }
+    secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+    r->ops = opnum;
+    r->ids = s->num_ids;
+    r->peak_bytes = peak;
+    r->heap = mem_heapsize();
+    r->util = r->heap > 0 ? (double) peak / r->heap : 0;
+
+out:
+    tracestream_close(s);
+    if (map != NULL)
+	idmap_free(map);
+    return secs;
+}
+
+/*
+ * mmreplay - Replay the trace at path runs times, keeping the best time
+ */
+int mmreplay(char *path, int runs, mmreplay_t *r)
+{
+    double secs, best = -1;
+    int i;
+
+    memset(r, 0, sizeof(mmreplay_t));
+    for (i = 0; i < runs; i++) {
+	if ((secs = replay_once(path, r)) < 0)
+	    return -1;
+	if (best < 0 || secs < best)
+	    best = secs;
+    }
+    r->valid = 1;
+    r->secs = best;
+    r->kops = best > 0 ? r->ops / best / 1e3 : 0;
+    return 0;
+}
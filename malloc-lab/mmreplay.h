@@ -0,0 +1,28 @@
+/*
+ * mmreplay.h - Time the mm allocator on a trace, streamed
+ *
+ * One streaming pass (tracestream.h) of a trace through mm_malloc,
+ * mm_realloc and mm_free on a fresh heap, with no checking of the
+ * payloads: what tracemin and tracemix use to compare traces. mdriver
+ * is still the place to check an allocator for correctness.
+ */
+#ifndef __MMREPLAY_H_
+#define __MMREPLAY_H_
+
+#include <stdint.h>
+
+typedef struct {
+    int valid;               /* did the allocator get through the trace? */
+    char error[128];         /* if not, why */
+    uint64_t ops, ids;       /* of the trace */
+    uint64_t peak_bytes;     /* most payload bytes live */
+    uint64_t heap;           /* heap size at the end */
+    double util;             /* peak_bytes / heap */
+    double secs, kops;       /* best of the runs */
+} mmreplay_t;
+
+/* Replay the trace at path runs times (mem_init must have been called)
+   and fill in r; return 0, or -1 with r->error set */
+int mmreplay(char *path, int runs, mmreplay_t *r);
+
+#endif /* __MMREPLAY_H_ */
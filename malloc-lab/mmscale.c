@@ -0,0 +1,358 @@
+/*
+ * mmscale.c - How the cost of an allocator grows with the live set
+ *
+ * The traces keep at most a few thousand blocks live, where a linear
+ * walk of a free list costs next to nothing. mmscale sweeps the live
+ * set from -m to -n blocks (1, 3, 10, 30, ... per decade) with the same
+ * size mix at every point, and times the allocator at each:
+ *
+ *   fill   allocate n blocks;
+ *   warm   free a random live block and allocate a new one in its
+ *          place, min(n, WARM_MAX) times, so the heap has the holes of
+ *          a long-running program (untimed);
+ *   timed  -q more such pairs.
+ *
+ * It prints ns per op (a free or a malloc) and Kops/sec for every
+ * live-set size, a bar chart of ns/op, and the exponent k of the
+ * fitted ns/op ~ n^k: about 0 for an allocator whose ops don't depend
+ * on the live set, 1 for a linear walk. -x fails the run if k is
+ * bigger, so a complexity regression is caught. -o appends the points
+ * to a CSV file, so that the runs of several allocators can be plotted
+ * together.
+ *
+ * Every phase of a point gets -t seconds. A timed phase that runs out
+ * of time is reported with the pairs it did, and the sweep stops there
+ * since the bigger sizes would be slower still.
+ *
+ * The allocator is the mm*.c that mmscale is linked with (make scale
+ * builds one mmscale-<allocator> per SCALE_ALLOCS), with a memlib that
+ * has room for SCALE_HEAP MB.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+
+#include "mm.h"
+#include "memlib.h"
+
+/* Misc */
+#define MAXLINE 1024	 /* max length of a message */
+#define MAX_POINTS 32	 /* live-set sizes in a sweep */
+#define WARM_MAX 1000000 /* most pairs in the warm phase */
+#define CHECK_EVERY 1024 /* ops between looks at the clock */
+#define BAR_WIDTH 40	 /* of the largest ns/op in the chart */
+
+/* The size mix: a class is picked by weight, then a size uniformly in
+   [lo, hi]. Mostly small blocks, as in the traces, and a few above
+   BIN_MAX_SIZE for mm_3's large list. */
+typedef struct
+{
+	int weight;
+	size_t lo, hi;
+} size_class_t;
+
+static size_class_t mix[] = {
+	{60, 8, 64},
+	{25, 65, 256},
+	{13, 257, 512},
+	{2, 513, 2048},
+};
+
+#define NUM_CLASSES (sizeof(mix) / sizeof(mix[0]))
+
+/* One live-set size */
+typedef struct
+{
+	uint64_t live;	 /* blocks */
+	uint64_t pairs;	 /* timed pairs done */
+	double ns;		 /* per op */
+	double kops;
+	size_t heap;	 /* bytes at the end */
+	int out_of_time; /* the timed phase was cut off */
+} point_t;
+
+static uint64_t rng_state;
+static void **slots = NULL; /* the live blocks */
+
+static void app_error(char *msg);
+static void usage(char *prog);
+
+/*
+ * splitmix64 - A small generator that is plenty for sizes and victims
+ */
+static uint64_t splitmix64(uint64_t *x)
+{
+	uint64_t z = (*x += 0x9e3779b97f4a7c15ULL);
+
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+static size_t next_size(void)
+{
+	uint64_t r = splitmix64(&rng_state);
+	int total = 0, k, w;
+
+	for (k = 0; k < (int)NUM_CLASSES; k++)
+		total += mix[k].weight;
+	w = (r >> 32) % total;
+	for (k = 0; w >= mix[k].weight; k++)
+		w -= mix[k].weight;
+	return mix[k].lo + (uint32_t)r % (mix[k].hi - mix[k].lo + 1);
+}
+
+static double now(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static void *alloc(void)
+{
+	void *p;
+
+	if ((p = mm_malloc(next_size())) == NULL)
+		app_error("mmscale: mm_malloc failed, out of heap? (make SCALE_HEAP=<MB>)");
+	return p;
+}
+
+/*
+ * churn - Up to pairs times, free a random one of the n live blocks
+ *     and allocate another in its place, stopping after budget
+ *     seconds; return the pairs done
+ */
+static uint64_t churn(uint64_t n, uint64_t pairs, double budget)
+{
+	double deadline = now() + budget;
+	uint64_t i, k;
+
+	for (i = 0; i < pairs; i++)
+	{
+		if (i % CHECK_EVERY == 0 && i > 0 && now() > deadline)
+			break;
+		k = splitmix64(&rng_state) % n;
+		mm_free(slots[k]);
+		slots[k] = alloc();
+	}
+	return i;
+}
+
+/*
+ * run_point - Fill, warm and time the allocator with n live blocks;
+ *     return 0 if the fill ran out of time
+ */
+static int run_point(uint64_t n, uint64_t pairs, double budget, point_t *p)
+{
+	double t0, deadline;
+	uint64_t i;
+
+	memset(p, 0, sizeof(point_t));
+	p->live = n;
+	mem_reset_brk();
+	if (mm_init() < 0)
+		app_error("mmscale: mm_init failed");
+
+	deadline = now() + budget;
+	for (i = 0; i < n; i++)
+	{
+		if (i % CHECK_EVERY == 0 && i > 0 && now() > deadline)
+			return 0;
+		slots[i] = alloc();
+	}
+	churn(n, n < WARM_MAX ? n : WARM_MAX, budget);
+
+	t0 = now();
+	p->pairs = churn(n, pairs, budget);
+	p->ns = (now() - t0) * 1e9 / (2 * p->pairs);
+	p->kops = 1e6 / p->ns;
+	p->heap = mem_heapsize();
+	p->out_of_time = p->pairs < pairs;
+	return 1;
+}
+
+/*
+ * fit_exponent - Least-squares slope of log(ns) against log(live)
+ */
+static double fit_exponent(point_t *pts, int n)
+{
+	double sx = 0, sy = 0, sxx = 0, sxy = 0, x, y;
+	int i;
+
+	for (i = 0; i < n; i++)
+	{
+		x = log((double)pts[i].live);
+		y = log(pts[i].ns);
+		sx += x;
+		sy += y;
+		sxx += x * x;
+		sxy += x * y;
+	}
+	return (n * sxy - sx * sy) / (n * sxx - sx * sx);
+}
+
+static void print_chart(point_t *pts, int n)
+{
+	double max = 0;
+	int i, k, w;
+
+	for (i = 0; i < n; i++)
+		if (pts[i].ns > max)
+			max = pts[i].ns;
+	printf("\nns/op\n");
+	for (i = 0; i < n; i++)
+	{
+		w = max > 0 ? (int)(pts[i].ns / max * BAR_WIDTH + 0.5) : 0;
+		printf("%10llu |", (unsigned long long)pts[i].live);
+		for (k = 0; k < w; k++)
+			putchar('#');
+		printf(" %.1f\n", pts[i].ns);
+	}
+}
+
+static void write_csv(char *path, char *name, point_t *pts, int n)
+{
+	char msg[2 * MAXLINE];
+	FILE *fp;
+	int i;
+
+	if ((fp = fopen(path, "a")) == NULL)
+	{
+		sprintf(msg, "mmscale: %s: can't open", path);
+		app_error(msg);
+	}
+	fseek(fp, 0, SEEK_END);
+	if (ftell(fp) == 0)
+		fprintf(fp, "allocator,live,pairs,ns_per_op,kops,heap\n");
+	for (i = 0; i < n; i++)
+		fprintf(fp, "%s,%llu,%llu,%.2f,%.1f,%lu\n", name, (unsigned long long)pts[i].live,
+				(unsigned long long)pts[i].pairs, pts[i].ns, pts[i].kops,
+				(unsigned long)pts[i].heap);
+	fclose(fp);
+}
+
+int main(int argc, char **argv)
+{
+	point_t pts[MAX_POINTS];
+	uint64_t min_live = 1000, max_live = 10000000, pairs = 200000, seed = 1, n, decade;
+	double budget = 2, max_exp = -1, k;
+	char *csv = NULL, *name;
+	int num_points = 0, c;
+
+	while ((c = getopt(argc, argv, "m:n:q:t:o:x:S:h")) != EOF)
+	{
+		switch (c)
+		{
+		case 'm': /* Smallest live set */
+			min_live = strtoull(optarg, NULL, 0);
+			break;
+		case 'n': /* Largest live set */
+			max_live = strtoull(optarg, NULL, 0);
+			break;
+		case 'q': /* Timed pairs per point */
+			pairs = strtoull(optarg, NULL, 0);
+			break;
+		case 't': /* Seconds per phase of a point */
+			budget = atof(optarg);
+			break;
+		case 'o': /* Append the points to a CSV file */
+			csv = optarg;
+			break;
+		case 'x': /* Fail if ns/op grows faster than live^<exp> */
+			max_exp = atof(optarg);
+			break;
+		case 'S': /* Seed of the sizes and victims */
+			seed = strtoull(optarg, NULL, 0);
+			break;
+		case 'h':
+			usage(argv[0]);
+			exit(0);
+		default:
+			usage(argv[0]);
+			exit(1);
+		}
+	}
+	if (optind != argc || min_live == 0 || max_live < min_live || pairs == 0 || budget <= 0)
+	{
+		usage(argv[0]);
+		exit(1);
+	}
+	name = (name = strrchr(argv[0], '-')) != NULL ? name + 1 : argv[0];
+
+	if ((slots = malloc(max_live * sizeof(void *))) == NULL)
+		app_error("mmscale: out of memory");
+	mem_init();
+
+	printf("%s: %llu timed pairs per point, %.0f s per phase, heap up to %lu MB\n", name,
+		   (unsigned long long)pairs, budget, (unsigned long)(mem_maxheap() >> 20));
+	printf("%10s %10s %10s %10s %10s\n", "live", "pairs", "ns/op", "Kops", "heap(MB)");
+	for (decade = 1; decade <= max_live && num_points < MAX_POINTS; decade *= 10)
+		for (c = 0; c < 2 && num_points < MAX_POINTS; c++)
+		{
+			n = c == 0 ? decade : 3 * decade;
+			if (n < min_live || n > max_live)
+				continue;
+			rng_state = seed;
+			if (!run_point(n, pairs, budget, &pts[num_points]))
+			{
+				printf("%10llu  filling took over %.0f s, stopping\n", (unsigned long long)n, budget);
+				goto done;
+			}
+			printf("%10llu %10llu %10.1f %10.0f %10.1f%s\n", (unsigned long long)n,
+				   (unsigned long long)pts[num_points].pairs, pts[num_points].ns,
+				   pts[num_points].kops, pts[num_points].heap / (1024.0 * 1024.0),
+				   pts[num_points].out_of_time ? "  out of time, stopping" : "");
+			if (pts[num_points++].out_of_time)
+				goto done;
+		}
+done:
+	mem_deinit();
+	free(slots);
+
+	print_chart(pts, num_points);
+	if (csv != NULL)
+		write_csv(csv, name, pts, num_points);
+	if (num_points < 2)
+	{
+		printf("\n%s: too few points to fit\n", name);
+		exit(0);
+	}
+	k = fit_exponent(pts, num_points);
+	printf("\n%s: ns/op grows like live^%.2f\n", name, k);
+	if (max_exp >= 0 && k > max_exp)
+	{
+		printf("%s: over the limit of live^%.2f\n", name, max_exp);
+		exit(1);
+	}
+	exit(0);
+}
+
+static void usage(char *prog)
+{
+	fprintf(stderr, "Usage: %s [-h] [-m <min>] [-n <max>] [-q <pairs>] [-t <secs>] [-o <csv>]\n"
+					"       [-x <exp>] [-S <seed>]\n", prog);
+	fprintf(stderr, "Options\n");
+	fprintf(stderr, "\t-h          Print this message.\n");
+	fprintf(stderr, "\t-m <min>    Smallest live set in blocks (default 1000).\n");
+	fprintf(stderr, "\t-n <max>    Largest live set in blocks (default 10000000).\n");
+	fprintf(stderr, "\t-o <csv>    Append the points to a CSV file.\n");
+	fprintf(stderr, "\t-q <pairs>  Timed free/malloc pairs per point (default 200000).\n");
+	fprintf(stderr, "\t-S <seed>   Seed of the sizes and victims (default 1).\n");
+	fprintf(stderr, "\t-t <secs>   Time limit of each phase of a point (default 2).\n");
+	fprintf(stderr, "\t-x <exp>    Fail if ns/op grows faster than live^<exp>.\n");
+}
+
+/*
+ * app_error - Report an arbitrary application error
+ */
+static void app_error(char *msg)
+{
+	printf("%s\n", msg);
+	exit(1);
+}
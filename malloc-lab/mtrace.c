@@ -0,0 +1,347 @@
+/*
+ * mtrace.c - Record a program's calls to the C allocator
+ *
+ * Built as libmtrace.so and preloaded into a program:
+ *
+ *     MTRACE_FILE=out.%p LD_PRELOAD=./libmtrace.so <program>
+ *
+ * It interposes malloc, calloc, realloc, free, posix_memalign,
+ * aligned_alloc and memalign, calls glibc's own allocator for the
+ * work (the __libc_* entry points), and appends one mtrace_rec_t per
+ * call to a buffer of the calling thread. The only shared write on
+ * that path is an atomic add to the sequence counter; a thread writes
+ * its buffer to the file with one write() when it is full, when the
+ * thread exits and when the program exits. The file is MTRACE_FILE,
+ * with %p replaced by the pid (default mtrace.%p.out); mtrace2rep
+ * turns it into a trace.
+ *
+ * Calls the allocator makes on our behalf (mmap of a buffer, pthread
+ * keys) are passed through unrecorded, as is everything before the
+ * constructor and after the destructor has run. Records of threads
+ * still running when the program exits are cut off there. A forked
+ * child stops recording until it execs; use %p so that the programs it
+ * runs get files of their own.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sched.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include "mtrace.h"
+
+/* Misc */
+#define MAXLINE 1024	/* max length of the file name */
+#define BUF_RECS 8192	/* records per thread buffer (320 KB) */
+
+#define TLS __attribute__((tls_model("initial-exec")))
+
+/* glibc's allocator */
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+extern void *__libc_memalign(size_t align, size_t size);
+
+/* A thread's buffer. Buffers are never unmapped: the buffer of a
+   thread that has exited is taken over by the next new thread. */
+typedef struct mtrace_buf
+{
+	struct mtrace_buf *next; /* all buffers, newest first */
+	atomic_int owned;		 /* a thread has it */
+	atomic_int busy;		 /* its thread is appending to it */
+	uint32_t tid;
+	size_t n;
+	mtrace_rec_t rec[BUF_RECS];
+} mtrace_buf_t;
+
+static int fd = -1;
+static atomic_int recording;
+static atomic_uint_fast64_t seq;
+static _Atomic(mtrace_buf_t *) bufs;
+static pthread_key_t key;
+
+static __thread mtrace_buf_t *my_buf TLS;
+static __thread int in_hook TLS;
+
+/*
+ * flush - Write out the records in b. On a write error recording stops.
+ */
+static void flush(mtrace_buf_t *b)
+{
+	char *p = (char *)b->rec;
+	size_t left = b->n * sizeof(mtrace_rec_t);
+	ssize_t rc;
+
+	while (fd >= 0 && left > 0)
+	{
+		if ((rc = write(fd, p, left)) < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			atomic_store(&recording, 0);
+			break;
+		}
+		p += rc;
+		left -= rc;
+	}
+	b->n = 0;
+}
+
+/*
+ * get_buf - Return the calling thread's buffer, taking over a free one
+ *     or mapping a new one the first time; NULL if out of memory
+ */
+static mtrace_buf_t *get_buf(void)
+{
+	mtrace_buf_t *b;
+	int zero;
+
+	if (my_buf != NULL)
+		return my_buf;
+
+	for (b = atomic_load(&bufs); b != NULL; b = b->next)
+	{
+		zero = 0;
+		if (atomic_compare_exchange_strong(&b->owned, &zero, 1))
+			break;
+	}
+	if (b == NULL)
+	{
+		b = mmap(NULL, sizeof(mtrace_buf_t), PROT_READ | PROT_WRITE,
+				 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (b == MAP_FAILED)
+			return NULL;
+		atomic_store(&b->owned, 1);
+		b->next = atomic_load(&bufs);
+		while (!atomic_compare_exchange_weak(&bufs, &b->next, b))
+			;
+	}
+	b->tid = syscall(SYS_gettid);
+	my_buf = b;
+	pthread_setspecific(key, b);
+	return b;
+}
+
+/*
+ * record - Append a record with sequence number s to the thread's buffer
+ */
+static void record(uint64_t s, uint32_t type, void *ptr, void *old, size_t size)
+{
+	mtrace_buf_t *b;
+	mtrace_rec_t *r;
+	int saved = errno;
+
+	in_hook = 1;
+	if ((b = get_buf()) != NULL)
+	{
+		/* Either the destructor sees busy and waits, or we see that
+		   recording has stopped and leave the buffer alone */
+		atomic_store(&b->busy, 1);
+		if (atomic_load(&recording))
+		{
+			r = &b->rec[b->n++];
+			r->seq = s;
+			r->tid = b->tid;
+			r->type = type;
+			r->ptr = (uintptr_t)ptr;
+			r->old = (uintptr_t)old;
+			r->size = size;
+			if (b->n == BUF_RECS)
+				flush(b);
+		}
+		atomic_store_explicit(&b->busy, 0, memory_order_release);
+	}
+	in_hook = 0;
+	errno = saved;
+}
+
+static inline uint64_t next_seq(void)
+{
+	return atomic_fetch_add_explicit(&seq, 1, memory_order_relaxed);
+}
+
+static inline int hooked(void)
+{
+	return atomic_load_explicit(&recording, memory_order_relaxed) && !in_hook;
+}
+
+/*
+ * thread_exit - pthread key destructor: write out the buffer of an
+ *     exiting thread and give it up
+ */
+static void thread_exit(void *arg)
+{
+	mtrace_buf_t *b = arg;
+
+	atomic_store(&b->busy, 1);
+	if (atomic_load(&recording))
+		flush(b);
+	atomic_store(&b->busy, 0);
+	my_buf = NULL;
+	atomic_store(&b->owned, 0);
+}
+
+/*
+ * fork_child - The child has a copy of the parent's unwritten records
+ *     and shares its file: drop both
+ */
+static void fork_child(void)
+{
+	mtrace_buf_t *b;
+
+	atomic_store(&recording, 0);
+	for (b = atomic_load(&bufs); b != NULL; b = b->next)
+		b->n = 0;
+	close(fd);
+	fd = -1;
+}
+
+__attribute__((constructor)) static void mtrace_init(void)
+{
+	char path[MAXLINE], *name, *p;
+	mtrace_hdr_t hdr;
+	size_t len = 0;
+
+	if ((name = getenv("MTRACE_FILE")) == NULL)
+		name = "mtrace.%p.out";
+	for (p = name; *p != '\0' && len < sizeof(path) - 32; p++)
+	{
+		if (p[0] == '%' && p[1] == 'p')
+		{
+			len += sprintf(path + len, "%d", (int)getpid());
+			p++;
+		}
+		else
+			path[len++] = *p;
+	}
+	path[len] = '\0';
+
+	if ((fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644)) < 0)
+	{
+		fprintf(stderr, "mtrace: %s: %s\n", path, strerror(errno));
+		return;
+	}
+	memset(&hdr, 0, sizeof(hdr));
+	memcpy(hdr.magic, MTRACE_MAGIC, sizeof(hdr.magic));
+	hdr.version = MTRACE_VERSION;
+	hdr.rec_size = sizeof(mtrace_rec_t);
+	hdr.pid = getpid();
+	if (write(fd, &hdr, sizeof(hdr)) != sizeof(hdr) ||
+		pthread_key_create(&key, thread_exit) != 0)
+	{
+		fprintf(stderr, "mtrace: %s: %s\n", path, strerror(errno));
+		close(fd);
+		fd = -1;
+		return;
+	}
+	pthread_atfork(NULL, NULL, fork_child);
+	atomic_store(&recording, 1);
+}
+
+__attribute__((destructor)) static void mtrace_fini(void)
+{
+	mtrace_buf_t *b;
+
+	if (!atomic_load(&recording))
+		return;
+	atomic_store(&recording, 0);
+	for (b = atomic_load(&bufs); b != NULL; b = b->next)
+	{
+		while (atomic_load(&b->busy))
+			sched_yield();
+		flush(b);
+	}
+	close(fd);
+	fd = -1;
+}
+
+/*******************
+ * The interposition
+ *******************/
+
+void *malloc(size_t size)
+{
+	void *p = __libc_malloc(size);
+
+	if (p != NULL && hooked())
+		record(next_seq(), MTRACE_ALLOC, p, NULL, size);
+	return p;
+}
+
+void *calloc(size_t n, size_t size)
+{
+	void *p = __libc_calloc(n, size);
+
+	if (p != NULL && hooked())
+		record(next_seq(), MTRACE_ALLOC, p, NULL, n * size);
+	return p;
+}
+
+void free(void *ptr)
+{
+	uint64_t s;
+
+	if (ptr == NULL || !hooked())
+	{
+		__libc_free(ptr);
+		return;
+	}
+	s = next_seq();
+	__libc_free(ptr);
+	record(s, MTRACE_FREE, ptr, NULL, 0);
+}
+
+void *realloc(void *old, size_t size)
+{
+	void *p;
+
+	if (!hooked())
+		return __libc_realloc(old, size);
+	if (old == NULL)
+		return malloc(size);
+
+	record(next_seq(), MTRACE_RBEGIN, NULL, old, 0);
+	p = __libc_realloc(old, size);
+	if (p != NULL)
+		record(next_seq(), MTRACE_REALLOC, p, old, size);
+	else if (size == 0) /* glibc frees the block */
+		record(next_seq(), MTRACE_REALLOC, NULL, old, 0);
+	else
+		record(next_seq(), MTRACE_REALLOC, old, old, 0);
+	return p;
+}
+
+void *memalign(size_t align, size_t size)
+{
+	void *p = __libc_memalign(align, size);
+
+	if (p != NULL && hooked())
+		record(next_seq(), MTRACE_ALLOC, p, NULL, size);
+	return p;
+}
+
+void *aligned_alloc(size_t align, size_t size)
+{
+	return memalign(align, size);
+}
+
+int posix_memalign(void **memptr, size_t align, size_t size)
+{
+	void *p;
+
+	if (align % sizeof(void *) != 0 || (align & (align - 1)) != 0)
+		return EINVAL;
+	if ((p = memalign(align, size)) == NULL)
+		return ENOMEM;
+	*memptr = p;
+	return 0;
+}
@@ -0,0 +1,53 @@
+/*
+ * mtrace.h - Raw allocation records written by libmtrace.so
+ *
+ * libmtrace.so (mtrace.c) is preloaded into a program to record its
+ * calls to the C allocator; mtrace2rep turns the records into a trace.
+ * The file is a header followed by fixed-size records in no particular
+ * order: every thread writes its own buffer out when it fills up. The
+ * seq field, from one process-wide counter, puts them back in order.
+ *
+ * A free takes its seq before the block is released and an allocation
+ * after it has its block, so when two threads hand the same address
+ * back and forth the seqs are in the order the allocator saw. A
+ * realloc that moves a block releases the old one in the middle of
+ * the call, so it writes two records: MTRACE_RBEGIN with a seq taken
+ * before the call, and MTRACE_REALLOC with one taken after.
+ */
+#ifndef __MTRACE_H_
+#define __MTRACE_H_
+
+#include <stdint.h>
+
+#define MTRACE_MAGIC   "MTRACE1"    /* 8 bytes with the terminating 0 */
+#define MTRACE_VERSION 1
+
+/* Record types */
+#define MTRACE_ALLOC   1    /* malloc, calloc, memalign & co: ptr, size */
+#define MTRACE_FREE    2    /* free: ptr */
+#define MTRACE_RBEGIN  3    /* realloc of old starts */
+#define MTRACE_REALLOC 4    /* ... and returns ptr, see below */
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t rec_size;       /* sizeof(mtrace_rec_t) */
+    uint64_t pid;
+} mtrace_hdr_t;
+
+/*
+ * MTRACE_REALLOC with ptr != 0 is a resize of old to size bytes at
+ * ptr; with ptr == 0 and size == 0, realloc(old, 0) freed old; with
+ * ptr == old and size == 0, the realloc failed and old is unchanged.
+ * realloc(NULL, size) is recorded as an MTRACE_ALLOC.
+ */
+typedef struct {
+    uint64_t seq;
+    uint32_t tid;            /* kernel thread id */
+    uint32_t type;
+    uint64_t ptr;
+    uint64_t old;
+    uint64_t size;
+} mtrace_rec_t;
+
+#endif /* __MTRACE_H_ */
@@ -0,0 +1,370 @@
+/*
+ * mtrace2rep.c - Turn the records of libmtrace.so into a trace
+ *
+ * Sorts the records (mtrace.h) by sequence number and replays them on a
+ * map from addresses to ids: every allocation gets the next id, a
+ * realloc keeps the id of its block, a free ends it. Like
+ * traces/checktrace.pl, the trace is balanced by freeing the blocks
+ * still live at the end. What the recorder could not see is patched
+ * up on the way:
+ *
+ *   - a free (or realloc) of an address we never saw allocated, from
+ *     before recording started or from an allocator entry point the
+ *     recorder does not interpose, is dropped (a realloc becomes an
+ *     alloc);
+ *   - an allocation at an address that is still live means its free
+ *     was missed, so the old block is freed first;
+ *   - malloc(0) and calloc(n, 0) become 1-byte allocations, since the
+ *     drivers take mm_malloc(0) == NULL for a failed request.
+ *
+ * With -t each op of a text trace ends with t<n>, the thread that made
+ * it, numbered from 0 in the order the threads first appear (the
+ * frees added at the end are t0). mdriver and the other tools skip
+ * anything after the numbers of an op.
+ *
+ * usage: mtrace2rep [-btv] <records> <out>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <getopt.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "mtrace.h"
+#include "traceio.h"
+#include "idmap.h"
+
+/* Misc */
+#define MAXLINE 1024 /* max length of a message */
+
+/* The output trace, text or binary */
+static traceio_writer_t *out = NULL;
+static int tags = 0;
+
+/* Counts for -v */
+static uint64_t ops = 0, unknown = 0, missed = 0, balanced = 0, zero = 0;
+
+static void usage(void);
+static void app_error(char *msg);
+
+static int cmp_seq(const void *a, const void *b)
+{
+	uint64_t x = ((const mtrace_rec_t *)a)->seq, y = ((const mtrace_rec_t *)b)->seq;
+
+	return (x > y) - (x < y);
+}
+
+/*
+ * load - Read the records at path into *recs, sorted by sequence
+ *     number; return how many there are
+ */
+static size_t load(char *path, mtrace_rec_t **recs)
+{
+	char msg[2 * MAXLINE];
+	mtrace_hdr_t *hdr;
+	struct stat st;
+	void *map;
+	size_t n;
+	int fd;
+
+	if ((fd = open(path, O_RDONLY)) < 0 || fstat(fd, &st) < 0)
+	{
+		sprintf(msg, "mtrace2rep: %s: %s", path, strerror(errno));
+		app_error(msg);
+	}
+	if ((size_t)st.st_size < sizeof(mtrace_hdr_t) ||
+		(map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED)
+	{
+		sprintf(msg, "mtrace2rep: %s: not a libmtrace file", path);
+		app_error(msg);
+	}
+	close(fd);
+
+	hdr = map;
+	if (memcmp(hdr->magic, MTRACE_MAGIC, sizeof(hdr->magic)) != 0 ||
+		hdr->version != MTRACE_VERSION || hdr->rec_size != sizeof(mtrace_rec_t))
+	{
+		sprintf(msg, "mtrace2rep: %s: not a libmtrace file, or another version", path);
+		app_error(msg);
+	}
+
+	/* A partial record at the end is from a program killed mid-write */
+	n = (st.st_size - sizeof(mtrace_hdr_t)) / sizeof(mtrace_rec_t);
+	if ((*recs = malloc(n * sizeof(mtrace_rec_t) + 1)) == NULL)
+		app_error("mtrace2rep: out of memory");
+	memcpy(*recs, (char *)map + sizeof(mtrace_hdr_t), n * sizeof(mtrace_rec_t));
+	munmap(map, st.st_size);
+	qsort(*recs, n, sizeof(mtrace_rec_t), cmp_seq);
+	return n;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+/********
+ * Output
+ ********/
+
+static void open_output(char *path, int binary)
+{
+	char msg[2 * MAXLINE];
+
+	if ((out = binary ? traceio_create(path, 0, 1) : traceio_create_text(path, 0, 1)) == NULL)
+	{
+		sprintf(msg, "mtrace2rep: %s: %s", path, strerror(errno));
+		app_error(msg);
+	}
+}
+
+static void emit(int type, uint64_t id, uint64_t size, uint64_t thread)
+{
+	traceio_op_t op = {type, id, size};
+	char tag[32];
+
+	ops++;
+	sprintf(tag, "t%llu", (unsigned long long)thread);
+	if (traceio_put_tag(out, &op, tags ? tag : NULL) < 0)
+		app_error("mtrace2rep: write error");
+}
+
+static void close_output(char *path, uint64_t heap)
+{
+	char msg[2 * MAXLINE];
+
+	out->hdr.sugg_heapsize = heap;
+	if (traceio_finish(out) < 0)
+	{
+		sprintf(msg, "mtrace2rep: %s: %s", path, strerror(errno));
+		app_error(msg);
+	}
+}
+
+/************
+ * Conversion
+ ************/
+
+/* The live blocks, keyed by address: tag is the id, size the size */
+static idmap_t *addrs;
+static uint64_t live_bytes = 0, peak_bytes = 0;
+
+/*
+ * set_addr - Make ptr the address of block id, freeing the block that
+ *     was still there if its free was missed
+ */
+static void set_addr(uint64_t ptr, uint64_t id, uint64_t size, uint64_t thread)
+{
+	idmap_entry_t *e, old;
+
+	if (idmap_remove(addrs, ptr, &old))
+	{
+		missed++;
+		live_bytes -= old.size;
+		emit(TRACEIO_FREE, old.tag, 0, thread);
+	}
+	if ((e = idmap_put(addrs, ptr)) == NULL)
+		app_error("mtrace2rep: out of memory");
+	e->tag = id;
+	e->size = size;
+	live_bytes += size;
+	if (live_bytes > peak_bytes)
+		peak_bytes = live_bytes;
+}
+
+/*
+ * convert - Replay the sorted records and write the trace. threads
+ *     maps a kernel thread id to its number (tag); pending holds, by
+ *     thread, the block it is in the middle of realloc'ing.
+ */
+static void convert(mtrace_rec_t *recs, size_t n, char *path)
+{
+	idmap_t *threads, *pending;
+	idmap_entry_t *e, old;
+	uint64_t next_id = 0, nthreads = 0;
+	uint64_t *ids, i, k;
+	mtrace_rec_t *r;
+
+	if ((addrs = idmap_new()) == NULL || (threads = idmap_new()) == NULL ||
+		(pending = idmap_new()) == NULL)
+		app_error("mtrace2rep: out of memory");
+
+	for (r = recs; r < recs + n; r++)
+	{
+		if ((e = idmap_get(threads, r->tid)) == NULL)
+		{
+			if ((e = idmap_put(threads, r->tid)) == NULL)
+				app_error("mtrace2rep: out of memory");
+			e->tag = nthreads++;
+		}
+		k = e->tag;
+
+		switch (r->type)
+		{
+		case MTRACE_ALLOC:
+			if (r->size == 0)
+			{
+				zero++;
+				r->size = 1;
+			}
+			set_addr(r->ptr, next_id, r->size, k);
+			emit(TRACEIO_ALLOC, next_id++, r->size, k);
+			break;
+
+		case MTRACE_FREE:
+			if (!idmap_remove(addrs, r->ptr, &old))
+			{
+				unknown++;
+				break;
+			}
+			live_bytes -= old.size;
+			emit(TRACEIO_FREE, old.tag, 0, k);
+			break;
+
+		case MTRACE_RBEGIN:
+			/* The old block is released until the realloc returns */
+			if (!idmap_remove(addrs, r->old, &old))
+				break;
+			live_bytes -= old.size;
+			if ((e = idmap_put(pending, r->tid)) == NULL)
+				app_error("mtrace2rep: out of memory");
+			e->tag = old.tag;
+			e->size = old.size;
+			break;
+
+		case MTRACE_REALLOC:
+			if (!idmap_remove(pending, r->tid, &old))
+			{
+				/* Of a block we never saw */
+				if (r->ptr != 0 && r->size != 0)
+				{
+					set_addr(r->ptr, next_id, r->size, k);
+					emit(TRACEIO_ALLOC, next_id++, r->size, k);
+				}
+				else
+					unknown++;
+			}
+			else if (r->ptr == 0)
+				emit(TRACEIO_FREE, old.tag, 0, k);
+			else if (r->size == 0) /* failed, the block is unchanged */
+				set_addr(r->ptr, old.tag, old.size, k);
+			else
+			{
+				set_addr(r->ptr, old.tag, r->size, k);
+				emit(TRACEIO_REALLOC, old.tag, r->size, k);
+			}
+			break;
+
+		default:
+			app_error("mtrace2rep: bad record type");
+		}
+	}
+
+	/* Balance the trace, in id order like checktrace.pl */
+	if ((ids = malloc(addrs->count * sizeof(uint64_t) + 1)) == NULL)
+		app_error("mtrace2rep: out of memory");
+	for (i = 0, k = 0; i < addrs->cap; i++)
+		if (addrs->slots[i].id != UINT64_MAX)
+			ids[k++] = addrs->slots[i].tag;
+	qsort(ids, k, sizeof(uint64_t), cmp_u64);
+	for (i = 0; i < k; i++)
+		emit(TRACEIO_FREE, ids[i], 0, 0);
+	balanced = k;
+
+	close_output(path, peak_bytes);
+	free(ids);
+	idmap_free(addrs);
+	idmap_free(threads);
+	idmap_free(pending);
+	printf("%llu threads, %llu ids, %llu ops, peak %.1f KB live\n",
+		   (unsigned long long)nthreads, (unsigned long long)next_id,
+		   (unsigned long long)ops, peak_bytes / 1024.0);
+}
+
+int main(int argc, char **argv)
+{
+	mtrace_rec_t *recs;
+	char *in, *out;
+	uint64_t gaps = 0;
+	size_t n, i;
+	int binary = 0, verbose = 0, c;
+
+	while ((c = getopt(argc, argv, "btvh")) != EOF)
+	{
+		switch (c)
+		{
+		case 'b': /* Write a binary trace */
+			binary = 1;
+			break;
+		case 't': /* Tag ops with their threads */
+			tags = 1;
+			break;
+		case 'v': /* Print what had to be patched up */
+			verbose = 1;
+			break;
+		case 'h':
+			usage();
+			exit(0);
+		default:
+			usage();
+			exit(1);
+		}
+	}
+	if (argc - optind != 2)
+	{
+		usage();
+		exit(1);
+	}
+	in = argv[optind];
+	out = argv[optind + 1];
+	if (strlen(out) > 4 && strcmp(out + strlen(out) - 4, ".mtr") == 0)
+		binary = 1;
+	if (binary && tags)
+		app_error("mtrace2rep: -t needs a text trace");
+
+	n = load(in, &recs);
+	for (i = 1; i < n; i++)
+		gaps += recs[i].seq - recs[i - 1].seq - 1;
+
+	open_output(out, binary);
+	convert(recs, n, out);
+	if (verbose)
+	{
+		printf("%lu records", (unsigned long)n);
+		if (gaps > 0)
+			printf(", %llu missing (threads cut off at exit)", (unsigned long long)gaps);
+		printf("\n%llu frees of blocks never seen dropped, %llu missed frees added, "
+			   "%llu frees added at the end, %llu 0-byte allocs made 1 byte\n",
+			   (unsigned long long)unknown, (unsigned long long)missed,
+			   (unsigned long long)balanced, (unsigned long long)zero);
+	}
+	free(recs);
+	exit(0);
+}
+
+static void usage(void)
+{
+	fprintf(stderr, "Usage: mtrace2rep [-btvh] <records> <out>\n");
+	fprintf(stderr, "\tTurns the records of libmtrace.so into a balanced trace.\n");
+	fprintf(stderr, "Options\n");
+	fprintf(stderr, "\t-b  Write a binary trace (also if <out> ends in .mtr).\n");
+	fprintf(stderr, "\t-h  Print this message.\n");
+	fprintf(stderr, "\t-t  End every op with t<n>, the thread that made it.\n");
+	fprintf(stderr, "\t-v  Print what had to be patched up.\n");
+}
+
+/*
+ * app_error - Report an arbitrary application error
+ */
+static void app_error(char *msg)
+{
+	printf("%s\n", msg);
+	exit(1);
+}
@@ -0,0 +1,185 @@
+/****************************
+ * Hardware performance counters
+ ****************************/
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include "perfctr.h"
+
+static char *names[PERFCTR_NUM] = {
+    "cycles", "instructions", "L1D misses", "LLC misses",
+    "dTLB misses", "branch misses", "page faults"
+};
+
+static int fds[PERFCTR_NUM] = {-1, -1, -1, -1, -1, -1, -1};
+static char errbuf[256];
+static char *err = NULL;
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+/* Cache events are encoded as id | op << 8 | result << 16 */
+#define CACHE_MISS(id) ((id) | (PERF_COUNT_HW_CACHE_OP_READ << 8) | \
+			(PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+static struct { unsigned type; unsigned long long config; } events[PERFCTR_NUM] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HW_CACHE, CACHE_MISS(PERF_COUNT_HW_CACHE_L1D)},
+    {PERF_TYPE_HW_CACHE, CACHE_MISS(PERF_COUNT_HW_CACHE_LL)},
+    {PERF_TYPE_HW_CACHE, CACHE_MISS(PERF_COUNT_HW_CACHE_DTLB)},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+};
+
+/* The paranoia level, for the error message */
+static int paranoid(void)
+{
+    FILE *fp;
+    int level = -99;
+
+    if ((fp = fopen("/proc/sys/kernel/perf_event_paranoid", "r")) != NULL) {
+	if (fscanf(fp, "%d", &level) != 1)
+	    level = -99;
+	fclose(fp);
+    }
+    return level;
+}
+
+/*
+ * perfctr_open - Open all counters; return how many are available
+ */
+int perfctr_open(void)
+{
+    struct perf_event_attr attr;
+    int i, n = 0;
+
+    for (i = 0; i < PERFCTR_NUM; i++) {
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = events[i].type;
+	attr.config = events[i].config;
+	attr.disabled = 1;
+	attr.exclude_kernel = 1;   /* allowed up to perf_event_paranoid 2 */
+	attr.exclude_hv = 1;
+	attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+	    PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+	fds[i] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+	if (fds[i] >= 0) {
+	    n++;
+	} else if (err == NULL) {
+	    sprintf(errbuf, "%s: %s (perf_event_paranoid=%d)",
+		    names[i], strerror(errno), paranoid());
+	    err = errbuf;
+	}
+    }
+    return n;
+}
+
+/*
+ * perfctr_start - Zero and start every available counter
+ */
+void perfctr_start(void)
+{
+    int i;
+
+    for (i = 0; i < PERFCTR_NUM; i++)
+	if (fds[i] >= 0)
+	    ioctl(fds[i], PERF_EVENT_IOC_RESET, 0);
+    for (i = 0; i < PERFCTR_NUM; i++)
+	if (fds[i] >= 0)
+	    ioctl(fds[i], PERF_EVENT_IOC_ENABLE, 0);
+}
+
+/*
+ * perfctr_stop - Stop the counters and read them. If the kernel had to
+ *     multiplex them (more events than hardware counters), a counter
+ *     only ran part of the time and its count is scaled up to the
+ *     whole interval.
+ */
+void perfctr_stop(double *vals)
+{
+    unsigned long long buf[3]; /* value, time enabled, time running */
+    int i;
+
+    for (i = 0; i < PERFCTR_NUM; i++)
+	if (fds[i] >= 0)
+	    ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+
+    for (i = 0; i < PERFCTR_NUM; i++) {
+	vals[i] = 0;
+	if (fds[i] < 0 || read(fds[i], buf, sizeof(buf)) != sizeof(buf))
+	    continue;
+	vals[i] = (double) buf[0];
+	if (buf[2] > 0 && buf[2] < buf[1])
+	    vals[i] *= (double) buf[1] / buf[2];
+    }
+}
+
+/*
+ * perfctr_close - Release the counters
+ */
+void perfctr_close(void)
+{
+    int i;
+
+    for (i = 0; i < PERFCTR_NUM; i++) {
+	if (fds[i] >= 0)
+	    close(fds[i]);
+	fds[i] = -1;
+    }
+}
+
+#else /* !__linux__ */
+
+int perfctr_open(void)
+{
+    err = "perf_event_open is only available on Linux";
+    return 0;
+}
+
+void perfctr_start(void)
+{
+}
+
+void perfctr_stop(double *vals)
+{
+    int i;
+
+    for (i = 0; i < PERFCTR_NUM; i++)
+	vals[i] = 0;
+}
+
+void perfctr_close(void)
+{
+}
+
+#endif /* __linux__ */
+
+/*
+ * perfctr_available - Is counter i available?
+ */
+int perfctr_available(int i)
+{
+    return fds[i] >= 0;
+}
+
+/*
+ * perfctr_name - Short name of counter i
+ */
+char *perfctr_name(int i)
+{
+    return names[i];
+}
+
+/*
+ * perfctr_error - Why the first unavailable counter could not be opened
+ */
+char *perfctr_error(void)
+{
+    return err;
+}
@@ -0,0 +1,46 @@
+/*
+ * perfctr.h - Hardware performance counters around a piece of code
+ *
+ * A thin wrapper around Linux perf_event_open(2) that counts events
+ * of the calling thread in user mode. Each counter is opened on its
+ * own, so if the kernel or the container refuses some of them (a VM
+ * without a PMU, a strict perf_event_paranoid) the others still work
+ * and the missing ones are just reported as unavailable. On other
+ * systems nothing is available.
+ */
+#ifndef __PERFCTR_H_
+#define __PERFCTR_H_
+
+/* The events we count, in the order of the arrays below */
+#define PERFCTR_CYCLES       0
+#define PERFCTR_INSTRUCTIONS 1
+#define PERFCTR_L1D_MISSES   2
+#define PERFCTR_LLC_MISSES   3
+#define PERFCTR_DTLB_MISSES  4
+#define PERFCTR_BR_MISSES    5
+#define PERFCTR_PAGE_FAULTS  6
+#define PERFCTR_NUM          7
+
+/* Open all counters; return how many are available */
+int perfctr_open(void);
+
+/* Is counter i available? */
+int perfctr_available(int i);
+
+/* Short name of counter i, e.g. "cycles" */
+char *perfctr_name(int i);
+
+/* Why the first unavailable counter could not be opened (or NULL) */
+char *perfctr_error(void);
+
+/* Zero and start every available counter */
+void perfctr_start(void);
+
+/* Stop the counters and store their values in vals[PERFCTR_NUM]
+   (scaled up if the kernel had to multiplex them, 0 if unavailable) */
+void perfctr_stop(double *vals);
+
+/* Release the counters */
+void perfctr_close(void);
+
+#endif /* __PERFCTR_H_ */
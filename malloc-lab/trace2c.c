@@ -0,0 +1,259 @@
+/*
+ * trace2c.c - Compile a trace into straight-line C
+ *
+ * mdriver replays a trace by interpreting trace->ops in a switch and
+ * keeping the blocks in trace->blocks. On traces of short requests the
+ * loop, the dispatch and the loads of the ops array are a visible part
+ * of the measured time. trace2c turns the trace into a C file with one
+ * direct mm_malloc/mm_free/mm_realloc call per request on a static
+ * array of pointers, every id and size a constant. Linked with
+ * tracebench.c it gives a benchmark of the allocator alone on that
+ * trace (see "make <trace>.replay" in the Makefile).
+ *
+ * Straight-line code is only fast while it stays in the caches: at
+ * 20 bytes or so per call, a trace of more than a few thousand
+ * requests runs from L2 or further out and is slower than the
+ * interpreter. So periodic runs of requests, where every request in
+ * the period has the same type and an id and size that step by a
+ * constant from one period to the next (most synthetic traces are
+ * made of them), are rerolled into counted loops with the calls in the
+ * loop body. Everything else is emitted one call per request. The code
+ * is split into functions of about FUNC_STMTS calls each, so the
+ * compiler never sees one huge function.
+ *
+ * usage: trace2c <trace> <out.c>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "tracestream.h"
+
+/* Misc */
+#define MAXLINE 1024	/* max length of a message */
+#define FUNC_STMTS 1024 /* calls per generated function */
+#define MAX_PERIOD 8	/* longest period rerolled into a loop... */
+#define MIN_REPS 4		/* ... and the fewest repetitions that are */
+
+/* The output file and where we are in it */
+static FILE *fp;
+static unsigned long long nfuncs = 0; /* functions emitted so far */
+static int stmts = -1;				  /* calls in the current one, -1 if none */
+static unsigned long long func_op = 0; /* the first request in it */
+static int func_fails = 0;			   /* does it have a malloc or realloc? */
+
+static void usage(void);
+static void app_error(char *msg);
+
+/*
+ * count_reps - Return how many times the first p ops of o[0..n) repeat
+ *     with every op's id and size moving by the same step each time
+ */
+static unsigned long count_reps(traceio_op_t *o, unsigned long n, int p)
+{
+	unsigned long reps;
+	traceio_op_t *q;
+	int j;
+
+	for (reps = 1; (reps + 1) * p <= n; reps++)
+		for (j = 0; j < p; j++)
+		{
+			q = &o[reps * p + j];
+			if (q->type != o[j].type ||
+				q->id - o[j].id != reps * (o[p + j].id - o[j].id) ||
+				q->size - o[j].size != reps * (o[p + j].size - o[j].size))
+				return reps;
+		}
+	return reps;
+}
+
+/*
+ * end_func - Finish the current function
+ */
+static void end_func(void)
+{
+	fprintf(fp, "\treturn 0;\n");
+	if (func_fails)
+		fprintf(fp, "fail:\n\treturn %llu;\n", func_op + 1);
+	fprintf(fp, "}\n");
+}
+
+/*
+ * begin_stmts - Make room for n more calls, starting a new function if
+ *     the current one is full. The function returns 0, or the number
+ *     (from 1) of its first request if a request in it failed.
+ */
+static void begin_stmts(int n, unsigned long long opnum)
+{
+	if (stmts >= 0 && stmts + n <= FUNC_STMTS)
+	{
+		stmts += n;
+		return;
+	}
+	if (stmts >= 0)
+		end_func();
+	func_op = opnum;
+	func_fails = 0;
+	fprintf(fp, "\n__attribute__((noinline)) static long r%llu(void)\n{\n", nfuncs++);
+	stmts = n;
+}
+
+/*
+ * affine - Format base + step * k, leaving out a zero step
+ */
+static void affine(char *buf, uint64_t base, uint64_t step)
+{
+	if (step == 0)
+		sprintf(buf, "%llu", (unsigned long long)base);
+	else
+		sprintf(buf, "%llu + %lld * k", (unsigned long long)base, (long long)step);
+}
+
+/*
+ * emit_call - Emit the call for op; in a loop (step != NULL) its id and
+ *     size are the op's plus k times those of step
+ */
+static void emit_call(char *indent, traceio_op_t *op, traceio_op_t *step)
+{
+	char id[64], size[64];
+
+	affine(id, op->id, step != NULL ? step->id - op->id : 0);
+	affine(size, op->size, step != NULL ? step->size - op->size : 0);
+	if (op->type != TRACEIO_FREE)
+		func_fails = 1;
+	switch (op->type)
+	{
+	case TRACEIO_ALLOC:
+		fprintf(fp, "%sif ((b[%s] = mm_malloc(%s)) == NULL)\n%s\tgoto fail;\n", indent, id, size, indent);
+		break;
+	case TRACEIO_REALLOC:
+		fprintf(fp, "%sif ((b[%s] = mm_realloc(b[%s], %s)) == NULL)\n%s\tgoto fail;\n",
+				indent, id, id, size, indent);
+		break;
+	default:
+		fprintf(fp, "%smm_free(b[%s]);\n", indent, id);
+	}
+}
+
+/*
+ * emit_ops - Emit the calls for n ops starting with request opnum,
+ *     rerolling the longest periodic runs into loops
+ */
+static void emit_ops(traceio_op_t *ops, unsigned long n, unsigned long long opnum)
+{
+	unsigned long i = 0, reps, best_reps;
+	int p, best_p, j;
+
+	while (i < n)
+	{
+		best_p = 0;
+		best_reps = 0;
+		for (p = 1; p <= MAX_PERIOD && i + MIN_REPS * p <= n; p++)
+		{
+			reps = count_reps(&ops[i], n - i, p);
+			if (reps >= MIN_REPS && reps * p > best_reps * best_p)
+			{
+				best_p = p;
+				best_reps = reps;
+			}
+		}
+
+		if (best_p == 0)
+		{
+			begin_stmts(1, opnum + i);
+			emit_call("\t", &ops[i], NULL);
+			i++;
+			continue;
+		}
+		begin_stmts(best_p, opnum + i);
+		fprintf(fp, "\tfor (long k = 0; k < %lu; k++)\n\t{\n", best_reps);
+		for (j = 0; j < best_p; j++)
+			emit_call("\t\t", &ops[i + j], &ops[i + best_p + j]);
+		fprintf(fp, "\t}\n");
+		i += best_reps * best_p;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	tracestream_t *s;
+	traceio_op_t *ops;
+	char msg[2 * MAXLINE];
+	unsigned long long opnum = 0, f;
+	long i, n;
+
+	if (argc != 3)
+	{
+		usage();
+		exit(1);
+	}
+
+	if ((s = tracestream_open(argv[1], TRACESTREAM_CHUNK)) == NULL)
+	{
+		sprintf(msg, "trace2c: %s: %s", argv[1], strerror(errno));
+		app_error(msg);
+	}
+	if ((fp = fopen(argv[2], "w")) == NULL)
+	{
+		sprintf(msg, "trace2c: %s: %s", argv[2], strerror(errno));
+		app_error(msg);
+	}
+
+	fprintf(fp, "/* Generated by trace2c from %s; do not edit */\n", argv[1]);
+	fprintf(fp, "#include <stddef.h>\n#include \"mm.h\"\n\n");
+	fprintf(fp, "const char replay_trace[] = \"%s\";\n", argv[1]);
+	fprintf(fp, "static void *b[%llu];\n", (unsigned long long)s->num_ids + 1);
+
+	/* Runs are only looked for within a chunk of the stream */
+	while ((n = tracestream_next(s, &ops)) > 0)
+	{
+		for (i = 0; i < n; i++)
+			if (ops[i].id >= s->num_ids)
+			{
+				sprintf(msg, "trace2c: %s: op %llu: id %llu is not below num_ids (%llu)",
+						argv[1], opnum + i, (unsigned long long)ops[i].id,
+						(unsigned long long)s->num_ids);
+				app_error(msg);
+			}
+		emit_ops(ops, n, opnum);
+		opnum += n;
+	}
+	if (n < 0)
+	{
+		sprintf(msg, "trace2c: %s: %s", argv[1], s->error);
+		app_error(msg);
+	}
+	if (stmts >= 0)
+		end_func();
+
+	fprintf(fp, "\nconst long replay_ops = %llu;\n", opnum);
+	fprintf(fp, "\nlong replay_run(void)\n{\n\tlong rc;\n\n");
+	for (f = 0; f < nfuncs; f++)
+		fprintf(fp, "\tif ((rc = r%llu()) != 0)\n\t\treturn rc;\n", f);
+	fprintf(fp, "\treturn 0;\n}\n");
+
+	tracestream_close(s);
+	if (fclose(fp) != 0)
+	{
+		sprintf(msg, "trace2c: %s: %s", argv[2], strerror(errno));
+		app_error(msg);
+	}
+	exit(0);
+}
+
+static void usage(void)
+{
+	fprintf(stderr, "Usage: trace2c <trace> <out.c>\n");
+	fprintf(stderr, "\tCompiles a text or binary trace into C calls to mm_malloc,\n"
+					"\tmm_free and mm_realloc, to be linked with tracebench.o.\n");
+}
+
+/*
+ * app_error - Report an arbitrary application error
+ */
+static void app_error(char *msg)
+{
+	printf("%s\n", msg);
+	exit(1);
+}
@@ -0,0 +1,628 @@
+/*
+ * traceanalyze.c - Size, lifetime and realloc statistics of traces
+ *
+ * Reads text or binary traces in one streaming pass each (memory
+ * follows the live set, not the length of the trace) and reports:
+ *
+ *   - the request sizes, raw and after ALIGN rounding: percentiles,
+ *     a log2 histogram, the most common sizes and the rounding waste;
+ *   - the peak live set, in blocks and in bytes, and the op where
+ *     it happens;
+ *   - per size class of mm_3.c (the block size asize, as find_bin sees
+ *     it): the share of the ops and the block lifetimes in ops;
+ *   - realloc chains (reallocs per block) and growth factors.
+ *
+ * It then suggests a bin_sizes[] table for mm_3.c fitted to the block
+ * sizes of all the traces given. A class whose free list holds blocks
+ * of several sizes makes find_fit walk past blocks that are too small,
+ * so the table is chosen (by dynamic programming over the 8-byte size
+ * grid) to minimize the mix: the chance that two requests drawn at
+ * random land in the same class with different sizes.
+ * Every size gets a small floor weight so sizes the traces never use
+ * still end up in sensible classes.
+ *
+ * usage: traceanalyze [-k <classes>] [-m <max>] <trace>...
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <getopt.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "tracestream.h"
+#include "idmap.h"
+#include "hist.h"
+#include "mm.h"
+
+/* Misc */
+#define MAXLINE 1024 /* max length of a message */
+#define TOP_SIZES 8	 /* most common sizes shown */
+#define LOG2_ROWS 40 /* rows of the log2 size histogram */
+
+/* Block sizes as mm_3.c computes them */
+#define ALIGNMENT 8
+#define ALIGN(size) (((size) + (ALIGNMENT - 1)) & ~0x7ULL)
+#define ASIZE(size) ((size) <= DSIZE ? 2 * DSIZE : ALIGN((size) + DSIZE))
+
+/* mm_3.c's bin_sizes[]; the classes are its nonzero entries */
+static size_t cur_table[BIN_COUNT] = BIN_SIZES;
+static int cur_classes;
+
+/* Growth factors of reallocs: shrink, same, then up to each limit */
+#define GROWTH_BINS 7
+static const char *growth_names[GROWTH_BINS] =
+	{"shrink", "same", "<=1.25x", "<=1.5x", "<=2x", "<=4x", ">4x"};
+static const double growth_limits[GROWTH_BINS - 3] = {1.25, 1.5, 2, 4};
+
+/* Statistics of one size class */
+typedef struct
+{
+	uint64_t ops;	 /* ops on blocks of the class */
+	uint64_t allocs; /* blocks allocated in it */
+	hist_t life;	 /* lifetimes of its freed blocks, in ops */
+} class_stats_t;
+
+/* Statistics of one trace */
+typedef struct
+{
+	uint64_t ops, allocs, reallocs, frees;
+	idmap_t *raw_count, *aligned_count; /* size -> number of requests (tag) */
+	uint64_t raw_bytes, aligned_bytes;
+	uint64_t log2_raw[LOG2_ROWS], log2_aligned[LOG2_ROWS];
+	uint64_t live_blocks, live_bytes;
+	uint64_t peak_blocks, peak_blocks_op, peak_bytes, peak_bytes_op;
+	class_stats_t cls[BIN_COUNT + 1];
+	hist_t chain; /* reallocs per realloc'd block */
+	uint64_t growth[GROWTH_BINS];
+	double growth_log; /* sum of log2 of the growth factors */
+	uint64_t never_freed;
+} stats_t;
+
+/* Number of requests of every block size up to the top of the table,
+   over all the traces, by size / ALIGNMENT */
+static uint64_t *block_counts;
+static size_t max_small = BIN_MAX_SIZE;
+
+static void usage(void);
+static void app_error(char *msg);
+
+/*
+ * class_of - The class of a block size in cur_table; past the table is
+ *     the large class, cur_classes
+ */
+static int class_of(uint64_t asize)
+{
+	int i;
+
+	for (i = 0; i < cur_classes; i++)
+		if (asize <= cur_table[i])
+			return i;
+	return cur_classes;
+}
+
+static int log2_row(uint64_t v)
+{
+	int r = (v <= 1) ? 0 : 64 - __builtin_clzll(v - 1);
+
+	return r < LOG2_ROWS ? r : LOG2_ROWS - 1;
+}
+
+/*
+ * count_size - Count one request of size in the per-size maps
+ */
+static void count_size(stats_t *st, uint64_t size)
+{
+	idmap_entry_t *e;
+
+	if ((e = idmap_put(st->raw_count, size)) == NULL)
+		app_error("traceanalyze: out of memory");
+	e->tag++;
+	if ((e = idmap_put(st->aligned_count, ALIGN(size))) == NULL)
+		app_error("traceanalyze: out of memory");
+	e->tag++;
+	st->raw_bytes += size;
+	st->aligned_bytes += ALIGN(size);
+	st->log2_raw[log2_row(size)]++;
+	st->log2_aligned[log2_row(ALIGN(size))]++;
+	if (ASIZE(size) <= max_small)
+		block_counts[ASIZE(size) / ALIGNMENT]++;
+}
+
+/*
+ * end_block - Account for a block that is freed at op now, or is still
+ *     live at the end of the trace
+ */
+static void end_block(stats_t *st, idmap_entry_t *e, int freed, uint64_t now)
+{
+	uintptr_t reallocs = (uintptr_t)e->ptr;
+
+	if (freed)
+		hist_record(&st->cls[class_of(ASIZE(e->size))].life, now - e->tag);
+	else
+		st->never_freed++;
+	if (reallocs > 0)
+		hist_record(&st->chain, reallocs);
+}
+
+/*
+ * analyze - Make one pass over the trace at path. Each live id's entry
+ *     holds its size, the op that allocated it (tag) and the number of
+ *     times it was realloc'd (ptr).
+ */
+static void analyze(char *path, stats_t *st)
+{
+	tracestream_t *s;
+	traceio_op_t *ops, *op;
+	idmap_t *live;
+	idmap_entry_t *e, old;
+	char msg[2 * MAXLINE];
+	uint64_t now;
+	double f;
+	long i, n;
+	size_t j;
+	int g;
+
+	if ((s = tracestream_open(path, TRACESTREAM_CHUNK)) == NULL)
+	{
+		sprintf(msg, "traceanalyze: %s: %s", path, strerror(errno));
+		app_error(msg);
+	}
+	if ((live = idmap_new()) == NULL || (st->raw_count = idmap_new()) == NULL ||
+		(st->aligned_count = idmap_new()) == NULL)
+		app_error("traceanalyze: out of memory");
+
+	while ((n = tracestream_next(s, &ops)) > 0)
+		for (i = 0; i < n; i++)
+		{
+			op = &ops[i];
+			now = st->ops++;
+			switch (op->type)
+			{
+			case TRACEIO_ALLOC:
+				if (idmap_get(live, op->id) != NULL)
+				{
+					sprintf(msg, "traceanalyze: %s: op %llu: id %llu is already live",
+							path, (unsigned long long)now, (unsigned long long)op->id);
+					app_error(msg);
+				}
+				if ((e = idmap_put(live, op->id)) == NULL)
+					app_error("traceanalyze: out of memory");
+				e->size = op->size;
+				e->tag = now;
+				st->allocs++;
+				st->cls[class_of(ASIZE(op->size))].allocs++;
+				st->live_blocks++;
+				st->live_bytes += op->size;
+				count_size(st, op->size);
+				break;
+
+			case TRACEIO_REALLOC:
+				if ((e = idmap_get(live, op->id)) == NULL)
+				{
+					sprintf(msg, "traceanalyze: %s: op %llu: realloc of id %llu, which is not live",
+							path, (unsigned long long)now, (unsigned long long)op->id);
+					app_error(msg);
+				}
+				if (op->size < e->size)
+					g = 0;
+				else if (op->size == e->size)
+					g = 1;
+				else
+				{
+					f = (double)op->size / (e->size > 0 ? e->size : 1);
+					for (g = 2; g < GROWTH_BINS - 1 && f > growth_limits[g - 2]; g++)
+						;
+				}
+				st->growth[g]++;
+				if (e->size > 0 && op->size > 0)
+					st->growth_log += log2((double)op->size / e->size);
+				st->reallocs++;
+				st->live_bytes += op->size - e->size;
+				e->size = op->size;
+				e->ptr = (void *)((uintptr_t)e->ptr + 1);
+				count_size(st, op->size);
+				break;
+
+			default:
+				if (!idmap_remove(live, op->id, &old))
+				{
+					sprintf(msg, "traceanalyze: %s: op %llu: free of id %llu, which is not live",
+							path, (unsigned long long)now, (unsigned long long)op->id);
+					app_error(msg);
+				}
+				st->frees++;
+				st->live_blocks--;
+				st->live_bytes -= old.size;
+				st->cls[class_of(ASIZE(old.size))].ops++;
+				end_block(st, &old, 1, now);
+				continue;
+			}
+			st->cls[class_of(ASIZE(op->size))].ops++;
+			if (st->live_blocks > st->peak_blocks)
+			{
+				st->peak_blocks = st->live_blocks;
+				st->peak_blocks_op = now;
+			}
+			if (st->live_bytes > st->peak_bytes)
+			{
+				st->peak_bytes = st->live_bytes;
+				st->peak_bytes_op = now;
+			}
+		}
+	if (n < 0)
+	{
+		sprintf(msg, "traceanalyze: %s: %s", path, s->error);
+		app_error(msg);
+	}
+	tracestream_close(s);
+
+	/* Blocks an unbalanced trace never frees */
+	for (j = 0; j < live->cap; j++)
+		if (live->slots[j].id != UINT64_MAX)
+			end_block(st, &live->slots[j], 0, 0);
+	idmap_free(live);
+}
+
+/**********
+ * Reports
+ **********/
+
+static int cmp_count(const void *a, const void *b)
+{
+	const idmap_entry_t *x = a, *y = b;
+
+	if (x->tag != y->tag)
+		return (x->tag < y->tag) - (x->tag > y->tag);
+	return (x->id > y->id) - (x->id < y->id);
+}
+
+static int cmp_size(const void *a, const void *b)
+{
+	uint64_t x = ((const idmap_entry_t *)a)->id, y = ((const idmap_entry_t *)b)->id;
+
+	return (x > y) - (x < y);
+}
+
+/*
+ * print_percentiles - Print the exact p50, p90, p99 and max of the
+ *     sizes in a size -> count map of total requests
+ */
+static void print_percentiles(char *title, idmap_t *m, uint64_t total)
+{
+	static const int pcts[3] = {50, 90, 99};
+	uint64_t out[3] = {0, 0, 0}, cum = 0;
+	idmap_entry_t *v;
+	size_t i, k = 0;
+	int p = 0;
+
+	if ((v = malloc(m->count * sizeof(idmap_entry_t) + 1)) == NULL)
+		app_error("traceanalyze: out of memory");
+	for (i = 0; i < m->cap; i++)
+		if (m->slots[i].id != UINT64_MAX)
+			v[k++] = m->slots[i];
+	qsort(v, k, sizeof(idmap_entry_t), cmp_size);
+	for (i = 0; i < k && p < 3; i++)
+	{
+		cum += v[i].tag;
+		while (p < 3 && cum * 100 >= pcts[p] * total)
+			out[p++] = v[i].id;
+	}
+	printf("  %-8s %10llu %10llu %10llu %10llu\n", title, (unsigned long long)out[0],
+		   (unsigned long long)out[1], (unsigned long long)out[2],
+		   k > 0 ? (unsigned long long)v[k - 1].id : 0ULL);
+	free(v);
+}
+
+/*
+ * top_sizes - Print the most common sizes in a size -> count map
+ */
+static void top_sizes(char *title, idmap_t *m, uint64_t total)
+{
+	idmap_entry_t *v;
+	size_t i, k = 0;
+
+	if ((v = malloc(m->count * sizeof(idmap_entry_t) + 1)) == NULL)
+		app_error("traceanalyze: out of memory");
+	for (i = 0; i < m->cap; i++)
+		if (m->slots[i].id != UINT64_MAX)
+			v[k++] = m->slots[i];
+	qsort(v, k, sizeof(idmap_entry_t), cmp_count);
+	printf("  %-8s %6lu distinct, top:", title, (unsigned long)k);
+	for (i = 0; i < k && i < TOP_SIZES; i++)
+		printf(" %llu (%.1f%%)", (unsigned long long)v[i].id, 100.0 * v[i].tag / total);
+	printf("\n");
+	free(v);
+}
+
+static void print_sizes(stats_t *st)
+{
+	uint64_t n = st->allocs + st->reallocs, cum_raw = 0, cum_aligned = 0;
+	int r, last = 0;
+
+	printf("Request sizes (%llu allocs and reallocs):\n", (unsigned long long)n);
+	printf("  %-8s %10s %10s %10s %10s\n", "", "p50", "p90", "p99", "max");
+	print_percentiles("raw", st->raw_count, n);
+	print_percentiles("aligned", st->aligned_count, n);
+	top_sizes("raw", st->raw_count, n);
+	top_sizes("aligned", st->aligned_count, n);
+	if (st->raw_bytes > 0)
+		printf("  rounding to %d adds %.1f%% to the requested bytes\n", ALIGNMENT,
+			   100.0 * (st->aligned_bytes - st->raw_bytes) / st->raw_bytes);
+
+	for (r = 0; r < LOG2_ROWS; r++)
+		if (st->log2_raw[r] > 0 || st->log2_aligned[r] > 0)
+			last = r;
+	printf("  %12s %8s %7s %8s %7s\n", "size <=", "raw", "cum%", "aligned", "cum%");
+	for (r = 0; r <= last; r++)
+	{
+		cum_raw += st->log2_raw[r];
+		cum_aligned += st->log2_aligned[r];
+		if (st->log2_raw[r] == 0 && st->log2_aligned[r] == 0)
+			continue;
+		printf("  %12llu %8llu %6.1f%% %8llu %6.1f%%\n", 1ULL << r,
+			   (unsigned long long)st->log2_raw[r], 100.0 * cum_raw / n,
+			   (unsigned long long)st->log2_aligned[r], 100.0 * cum_aligned / n);
+	}
+}
+
+static void print_classes(stats_t *st)
+{
+	class_stats_t *c;
+	char name[32];
+	int i;
+
+	printf("Size classes of mm_3 (block size = ALIGN(size + %d)):\n", (int)DSIZE);
+	printf("  %-10s %7s %10s %7s %10s %10s %10s\n",
+		   "class", "ops%", "allocs", "allocs%", "life p50", "life p90", "life p99");
+	for (i = 0; i <= cur_classes; i++)
+	{
+		c = &st->cls[i];
+		if (c->ops == 0)
+			continue;
+		if (i == cur_classes)
+			sprintf(name, ">%lu", (unsigned long)cur_table[cur_classes - 1]);
+		else
+			sprintf(name, "%lu-%lu", i > 0 ? (unsigned long)cur_table[i - 1] + ALIGNMENT : 0UL,
+					(unsigned long)cur_table[i]);
+		printf("  %-10s %6.1f%% %10llu %6.1f%% %10llu %10llu %10llu\n", name,
+			   100.0 * c->ops / st->ops, (unsigned long long)c->allocs,
+			   st->allocs > 0 ? 100.0 * c->allocs / st->allocs : 0.0,
+			   hist_percentile(&c->life, 50), hist_percentile(&c->life, 90),
+			   hist_percentile(&c->life, 99));
+	}
+}
+
+static void print_reallocs(stats_t *st)
+{
+	int g;
+
+	if (st->reallocs == 0)
+	{
+		printf("No reallocs\n");
+		return;
+	}
+	printf("Reallocs: %llu on %llu blocks, chain length p50 %llu, p90 %llu, max %llu\n",
+		   (unsigned long long)st->reallocs, (unsigned long long)st->chain.count,
+		   hist_percentile(&st->chain, 50), hist_percentile(&st->chain, 90), st->chain.max);
+	printf("  growth:");
+	for (g = 0; g < GROWTH_BINS; g++)
+		printf(" %s %.1f%%", growth_names[g], 100.0 * st->growth[g] / st->reallocs);
+	printf("\n  geometric mean factor %.3f\n", exp2(st->growth_log / st->reallocs));
+}
+
+static void report(char *path, stats_t *st)
+{
+	printf("%s: %llu ops (%llu allocs, %llu reallocs, %llu frees)\n", path,
+		   (unsigned long long)st->ops, (unsigned long long)st->allocs,
+		   (unsigned long long)st->reallocs, (unsigned long long)st->frees);
+	if (st->ops == 0)
+		return;
+	print_sizes(st);
+	printf("Peak live set: %llu blocks at op %llu (%.0f%%), %.1f KB requested at op %llu (%.0f%%)\n",
+		   (unsigned long long)st->peak_blocks, (unsigned long long)st->peak_blocks_op,
+		   100.0 * st->peak_blocks_op / st->ops, st->peak_bytes / 1024.0,
+		   (unsigned long long)st->peak_bytes_op, 100.0 * st->peak_bytes_op / st->ops);
+	if (st->never_freed > 0)
+		printf("  %llu blocks are never freed\n", (unsigned long long)st->never_freed);
+	print_classes(st);
+	print_reallocs(st);
+}
+
+/****************************
+ * Suggested size-class table
+ ****************************/
+
+/*
+ * mix - The mix of a table of n classes (tops[]) over the block sizes
+ *     counted in w[] (by size / ALIGNMENT, up to g): the chance that
+ *     two requests drawn at random fall in the same class with
+ *     different sizes, the sum over the classes of C^2 - sum(c^2) over
+ *     the total squared, where C is the class's count and c its sizes'
+ */
+static double mix(double *w, size_t g, size_t *tops, int n)
+{
+	double C, c2, num = 0, total = 0;
+	size_t s;
+	int i;
+
+	for (i = 0; i < n; i++)
+	{
+		C = c2 = 0;
+		for (s = (i > 0 ? tops[i - 1] / ALIGNMENT + 1 : 0); s <= tops[i] / ALIGNMENT && s <= g; s++)
+		{
+			C += w[s];
+			c2 += w[s] * w[s];
+		}
+		num += C * C - c2;
+		total += C;
+	}
+	return total > 0 ? num / (total * total) : 0;
+}
+
+/*
+ * suggest - Print the table of k classes, the last one ending at
+ *     max_small, with the least mix over block_counts. The sizes are
+ *     the grid points lo..g (block size / ALIGNMENT); dp[c][j] is the
+ *     least cost of splitting lo..j-1 into c classes, where a class of
+ *     points i..j-1 costs C^2 - sum(c^2) as in mix(). With every weight
+ *     above zero, more classes never cost more, so all k are used.
+ */
+static void suggest(int k)
+{
+	size_t g = max_small / ALIGNMENT, lo = 2 * DSIZE / ALIGNMENT, i, j, s;
+	double *w, *s1, *s2, *dp, cost, floor_w, total = 0;
+	size_t *from, tops[BIN_COUNT];
+	int c;
+
+	if ((size_t)k > g - lo + 1)
+		k = g - lo + 1;
+	w = calloc(g + 2, sizeof(double));
+	s1 = calloc(g + 2, sizeof(double));
+	s2 = calloc(g + 2, sizeof(double));
+	dp = malloc((size_t)(k + 1) * (g + 2) * sizeof(double));
+	from = calloc((size_t)(k + 1) * (g + 2), sizeof(size_t));
+	if (w == NULL || s1 == NULL || s2 == NULL || dp == NULL || from == NULL)
+		app_error("traceanalyze: out of memory");
+#define DP(c, j) dp[(size_t)(c) * (g + 2) + (j)]
+#define FROM(c, j) from[(size_t)(c) * (g + 2) + (j)]
+
+	for (s = lo; s <= g; s++)
+		total += block_counts[s];
+	if (total == 0)
+	{
+		printf("No block sizes up to %lu to fit a table to\n", (unsigned long)max_small);
+		return;
+	}
+	floor_w = total / (100.0 * (g - lo + 1));
+	for (s = lo; s <= g; s++)
+	{
+		w[s] = block_counts[s] + floor_w;
+		s1[s + 1] = s1[s] + w[s];
+		s2[s + 1] = s2[s] + w[s] * w[s];
+	}
+
+	for (c = 0; c <= k; c++)
+		for (j = 0; j <= g + 1; j++)
+			DP(c, j) = HUGE_VAL;
+	DP(0, lo) = 0;
+	for (c = 1; c <= k; c++)
+		for (j = lo + c; j <= g + 1; j++)
+			for (i = lo + c - 1; i < j; i++)
+			{
+				cost = DP(c - 1, i) + (s1[j] - s1[i]) * (s1[j] - s1[i]) - (s2[j] - s2[i]);
+				if (cost < DP(c, j))
+				{
+					DP(c, j) = cost;
+					FROM(c, j) = i;
+				}
+			}
+
+	/* Walk back from the end of the last class */
+	for (c = k, j = g + 1; c > 0; j = FROM(c, j), c--)
+		tops[c - 1] = (j - 1) * ALIGNMENT;
+#undef DP
+#undef FROM
+
+	for (s = lo; s <= g; s++)
+		w[s] = block_counts[s];
+	printf("Suggested bin_sizes[] for mm_3.c, %d classes up to %lu (mix %.3f, now %.3f):\n",
+		   k, (unsigned long)max_small, mix(w, g, tops, k), mix(w, g, cur_table, cur_classes));
+	if (max_small != BIN_MAX_SIZE)
+		printf("(set BIN_MAX_SIZE in mm.h to %lu)\n", (unsigned long)max_small);
+	printf("static size_t bin_sizes[BIN_COUNT] = \n{\n    ");
+	for (c = 0; c < k; c++)
+		printf("%lu,%s", (unsigned long)tops[c], c == k - 1 ? "\n" : (c % 16 == 15) ? "\n    " : " ");
+	printf("};\n");
+	free(w);
+	free(s1);
+	free(s2);
+	free(dp);
+	free(from);
+}
+
+int main(int argc, char **argv)
+{
+	stats_t *st;
+	int k = 0, c;
+
+	/* As mm_3.c counts its bins */
+	while (cur_classes < BIN_COUNT && cur_table[cur_classes] != 0)
+		cur_classes++;
+
+	while ((c = getopt(argc, argv, "k:m:h")) != EOF)
+	{
+		switch (c)
+		{
+		case 'k': /* Number of classes in the suggested table */
+			k = atoi(optarg);
+			if (k < 1 || k > BIN_COUNT)
+			{
+				usage();
+				exit(1);
+			}
+			break;
+		case 'm': /* Largest class in the suggested table */
+			max_small = strtoul(optarg, NULL, 0);
+			if (max_small < 2 * DSIZE || max_small % ALIGNMENT != 0)
+			{
+				usage();
+				exit(1);
+			}
+			break;
+		case 'h':
+			usage();
+			exit(0);
+		default:
+			usage();
+			exit(1);
+		}
+	}
+	if (optind == argc)
+	{
+		usage();
+		exit(1);
+	}
+	if (k == 0)
+		k = cur_classes;
+
+	if ((block_counts = calloc(max_small / ALIGNMENT + 1, sizeof(uint64_t))) == NULL ||
+		(st = malloc(sizeof(stats_t))) == NULL)
+		app_error("traceanalyze: out of memory");
+	for (; optind < argc; optind++)
+	{
+		memset(st, 0, sizeof(stats_t));
+		analyze(argv[optind], st);
+		report(argv[optind], st);
+		printf("\n");
+		idmap_free(st->raw_count);
+		idmap_free(st->aligned_count);
+	}
+	suggest(k);
+	free(st);
+	free(block_counts);
+	exit(0);
+}
+
+static void usage(void)
+{
+	fprintf(stderr, "Usage: traceanalyze [-h] [-k <classes>] [-m <max>] <trace>...\n");
+	fprintf(stderr, "\tReports size, lifetime and realloc statistics of text or binary\n"
+					"\ttraces and suggests a bin_sizes[] table for mm_3.c.\n");
+	fprintf(stderr, "Options\n");
+	fprintf(stderr, "\t-h          Print this message.\n");
+	fprintf(stderr, "\t-k <n>      Classes in the suggested table (default %d, at most %d).\n",
+			cur_classes, BIN_COUNT);
+	fprintf(stderr, "\t-m <max>    Largest class, a multiple of %d (default BIN_MAX_SIZE, %d).\n",
+			ALIGNMENT, BIN_MAX_SIZE);
+}
+
+/*
+ * app_error - Report an arbitrary application error
+ */
+static void app_error(char *msg)
+{
+	printf("%s\n", msg);
+	exit(1);
+}
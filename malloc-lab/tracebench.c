@@ -0,0 +1,86 @@
+/*
+ * tracebench.c - Benchmark mm malloc on one trace compiled by trace2c
+ *
+ * Links with the C file trace2c generated from a trace (replay_run
+ * and friends) and times it with the same timing package and K-best
+ * scheme as mdriver. There is no interpreter between the requests, so
+ * the time is the allocator's alone. There is no checking either:
+ * run the trace through mdriver for that.
+ *
+ * usage: <trace>.replay [-v]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mm.h"
+#include "memlib.h"
+#include "fsecs.h"
+#include "config.h"
+
+int verbose = 0; /* needed by fsecs.c */
+
+/* Defined by the code trace2c generates */
+extern const char replay_trace[];
+extern const long replay_ops;
+extern long replay_run(void);
+
+static void usage(char *prog);
+static void app_error(char *msg);
+
+/*
+ * run_trace - One replay of the compiled trace on a fresh heap
+ */
+static void run_trace(void *ptr)
+{
+	char msg[256];
+	long rc;
+
+	mem_reset_brk();
+	if (mm_init() < 0)
+		app_error("mm_init failed in run_trace");
+	if ((rc = replay_run()) != 0)
+	{
+		snprintf(msg, sizeof(msg), "%s: a request at or after op %ld failed", replay_trace, rc - 1);
+		app_error(msg);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	double secs;
+
+	if (argc == 2 && strcmp(argv[1], "-v") == 0)
+		verbose = 1;
+	else if (argc > 1)
+	{
+		usage(argv[0]);
+		exit(1);
+	}
+
+	mem_init();
+	init_fsecs();
+
+	secs = fsecs(run_trace, NULL);
+	printf("%s: %ld ops, %.6f secs, %.0f Kops, %.1f ns/op, heap %.0f KB\n",
+		   replay_trace, replay_ops, secs, replay_ops / 1e3 / secs,
+		   secs * 1e9 / replay_ops, mem_heapsize() / 1024.0);
+
+	mem_deinit();
+	exit(0);
+}
+
+static void usage(char *prog)
+{
+	fprintf(stderr, "Usage: %s [-v]\n", prog);
+	fprintf(stderr, "\tTimes mm malloc on %s (compiled in by trace2c).\n", replay_trace);
+}
+
+/*
+ * app_error - Report an arbitrary application error
+ */
+static void app_error(char *msg)
+{
+	printf("%s\n", msg);
+	exit(1);
+}
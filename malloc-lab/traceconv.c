@@ -0,0 +1,189 @@
+/*
+ * traceconv.c - Convert traces between the text .rep format and the
+ *     binary format of traceio.h
+ *
+ * The direction is picked from the input: a binary trace is written
+ * out as text, anything else is read as text and written as binary.
+ *
+ * usage: traceconv <in> <out>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "traceio.h"
+
+/* Misc */
+#define MAXLINE 1024 /* max line length in a text trace */
+
+static void usage(void);
+static void app_error(char *msg);
+
+/*
+ * rep_to_binary - Read a text trace and write it in binary
+ */
+static void rep_to_binary(char *in, char *out)
+{
+	FILE *fp;
+	traceio_writer_t *w;
+	traceio_op_t op;
+	char line[MAXLINE], msg[2 * MAXLINE];
+	unsigned long long hdr[4]; /* sugg_heapsize, num_ids, num_ops, weight */
+	unsigned long long id, size;
+	int i, lineno = 0, n;
+
+	if ((fp = fopen(in, "r")) == NULL)
+	{
+		sprintf(msg, "traceconv: %s: %s", in, strerror(errno));
+		app_error(msg);
+	}
+	for (i = 0; i < 4; i++)
+	{
+		if (fscanf(fp, "%llu", &hdr[i]) != 1)
+		{
+			sprintf(msg, "traceconv: %s: bad header", in);
+			app_error(msg);
+		}
+		lineno++;
+	}
+	if ((w = traceio_create(out, hdr[0], hdr[3])) == NULL)
+	{
+		sprintf(msg, "traceconv: %s: %s", out, strerror(errno));
+		app_error(msg);
+	}
+
+	while (fgets(line, sizeof(line), fp) != NULL)
+	{
+		lineno++;
+		n = sscanf(line + 1, "%llu %llu", &id, &size);
+		switch (line[0])
+		{
+		case 'a':
+			op.type = TRACEIO_ALLOC;
+			break;
+		case 'r':
+			op.type = TRACEIO_REALLOC;
+			break;
+		case 'f':
+			op.type = TRACEIO_FREE;
+			size = 0;
+			n = (n >= 1) ? 2 : n;
+			break;
+		case '\n':
+			continue; /* the rest of the header line */
+		default:
+			n = 0;
+		}
+		if (n != 2)
+		{
+			sprintf(msg, "traceconv: %s:%d: bad op", in, lineno);
+			app_error(msg);
+		}
+		op.id = id;
+		op.size = size;
+		if (traceio_put(w, &op) < 0)
+		{
+			sprintf(msg, "traceconv: %s: %s", out, strerror(errno));
+			app_error(msg);
+		}
+	}
+	fclose(fp);
+
+	if (w->hdr.num_ops != hdr[2] || w->hdr.num_ids != hdr[1])
+		fprintf(stderr, "traceconv: warning: %s header says %llu ids, %llu ops; found %llu, %llu\n",
+				in, hdr[1], hdr[2], (unsigned long long)w->hdr.num_ids,
+				(unsigned long long)w->hdr.num_ops);
+	if (traceio_finish(w) < 0)
+	{
+		sprintf(msg, "traceconv: %s: %s", out, strerror(errno));
+		app_error(msg);
+	}
+}
+
+/*
+ * binary_to_rep - Read a binary trace and write it as text
+ */
+static void binary_to_rep(char *in, char *out)
+{
+	FILE *fp;
+	traceio_t *t;
+	traceio_op_t op;
+	char msg[2 * MAXLINE];
+	int rc;
+
+	if ((t = traceio_open(in)) == NULL)
+	{
+		sprintf(msg, "traceconv: %s: %s", in, strerror(errno));
+		app_error(msg);
+	}
+	if ((fp = fopen(out, "w")) == NULL)
+	{
+		sprintf(msg, "traceconv: %s: %s", out, strerror(errno));
+		app_error(msg);
+	}
+
+	fprintf(fp, "%llu\n%llu\n%llu\n%llu\n",
+			(unsigned long long)t->hdr->sugg_heapsize, (unsigned long long)t->hdr->num_ids,
+			(unsigned long long)t->hdr->num_ops, (unsigned long long)t->hdr->weight);
+	while ((rc = traceio_next(t, &op)) > 0)
+	{
+		if (op.type == TRACEIO_FREE)
+			fprintf(fp, "f %llu\n", (unsigned long long)op.id);
+		else
+			fprintf(fp, "%c %llu %llu\n", (op.type == TRACEIO_ALLOC) ? 'a' : 'r',
+					(unsigned long long)op.id, (unsigned long long)op.size);
+	}
+	if (rc < 0)
+	{
+		sprintf(msg, "traceconv: %s: corrupt op data", in);
+		app_error(msg);
+	}
+	if (fclose(fp) != 0)
+	{
+		sprintf(msg, "traceconv: %s: %s", out, strerror(errno));
+		app_error(msg);
+	}
+	traceio_close(t);
+}
+
+int main(int argc, char **argv)
+{
+	char msg[2 * MAXLINE];
+
+	if (argc != 3)
+	{
+		usage();
+		exit(1);
+	}
+
+	switch (traceio_is_binary(argv[1]))
+	{
+	case 1:
+		binary_to_rep(argv[1], argv[2]);
+		break;
+	case 0:
+		rep_to_binary(argv[1], argv[2]);
+		break;
+	default:
+		sprintf(msg, "traceconv: %s: %s", argv[1], strerror(errno));
+		app_error(msg);
+	}
+	exit(0);
+}
+
+static void usage(void)
+{
+	fprintf(stderr, "Usage: traceconv <in> <out>\n");
+	fprintf(stderr, "\tConverts a text .rep trace to the binary format, or a\n"
+					"\tbinary trace back to text, depending on what <in> is.\n");
+}
+
+/*
+ * app_error - Report an arbitrary application error
+ */
+static void app_error(char *msg)
+{
+	printf("%s\n", msg);
+	exit(1);
+}
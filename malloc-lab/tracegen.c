@@ -0,0 +1,865 @@
+/*
+ * tracegen.c - Generate synthetic traces from parametric workloads
+ *
+ * A seeded replacement for the Perl scripts in traces/. Every block
+ * gets a size and a lifetime (in ops) drawn from the current phase's
+ * distributions; a block is freed when its lifetime is up, and a
+ * fraction of the blocks are resized a few times over their life. The
+ * trace ends by freeing every block still live, so it is balanced like
+ * the -bal traces. The same seed always gives the same trace.
+ *
+ * Distributions (-S sizes in bytes, -T lifetimes in ops):
+ *
+ *     uniform:<lo>,<hi>            integers lo..hi
+ *     lognormal:<median>,<sigma>   median * e^(sigma * N(0,1))
+ *     powerlaw:<lo>,<hi>,<alpha>   density ~ x^-alpha on lo..hi
+ *     exp:<mean>                   exponential
+ *     fixed:<v>[@<w>],...          a mixture of fixed values, weights w
+ *
+ * A workload can change over the trace: -p <pct> starts a new phase at
+ * pct percent of the ops, and the -S, -T, -K and -G options after it
+ * apply to that phase (which starts as a copy of the previous one).
+ *
+ * With -F, the sizes, lifetimes, kept fraction and realloc growth of
+ * phase 0 are fitted from an existing trace, and -x <f> makes a
+ * lookalike f times as long whose lifetimes, and so live set, are f
+ * times bigger too.
+ *
+ * usage: tracegen [options] -o <out>, see usage()
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <getopt.h>
+#include <stdint.h>
+
+#include "traceio.h"
+#include "tracestream.h"
+#include "idmap.h"
+#include "hist.h"
+
+/* Misc */
+#define MAXLINE 1024	/* max length of a message */
+#define MAX_PHASES 16	/* most phases in a workload */
+#define MAX_FIXED 256	/* most values in a fixed mixture */
+#define MAX_SIZE (1ULL << 32)
+
+/* Kinds of distributions */
+#define DIST_UNIFORM 0
+#define DIST_LOGNORMAL 1
+#define DIST_POWERLAW 2
+#define DIST_EXP 3
+#define DIST_FIXED 4
+#define DIST_HIST 5 /* piecewise uniform, from a fit */
+
+typedef struct
+{
+	int kind;
+	double a, b, c; /* parameters of the analytic kinds, in spec order */
+	int n;			/* FIXED: number of values; HIST: number of bins */
+	double *val;	/* FIXED: the values; HIST: lo, hi of every bin */
+	double *cum;	/* cumulative weights, cum[n - 1] = 1 */
+} dist_t;
+
+/* A workload phase */
+typedef struct
+{
+	double start;	/* where it starts, as a fraction of the ops */
+	dist_t size;	/* block sizes */
+	dist_t life;	/* block lifetimes in ops */
+	double keep;	/* fraction of blocks that live to the end */
+	double grow;	/* fraction of blocks that are realloc'd... */
+	int grow_count; /* ... this many times over their life... */
+	double factor;	/* ... each time to size * factor + add */
+	double add;
+} phase_t;
+
+/* Something that happens to a live block */
+#define EV_REALLOC 0
+#define EV_FREE 1
+
+typedef struct
+{
+	uint64_t time; /* op at which it happens */
+	uint64_t id;
+	int kind;
+} event_t;
+
+/* Pending events, a binary min-heap on time */
+static event_t *events = NULL;
+static size_t nevents = 0, events_cap = 0;
+
+/* The random number generator (xoshiro256**) */
+static uint64_t rng[4];
+
+/* The output trace, text or binary */
+static traceio_writer_t *out = NULL;
+
+static void usage(void);
+static void app_error(char *msg);
+
+/****************
+ * Random numbers
+ ****************/
+
+/*
+ * splitmix64 - Seed expander, so that nearby seeds give unrelated states
+ */
+static uint64_t splitmix64(uint64_t *x)
+{
+	uint64_t z = (*x += 0x9e3779b97f4a7c15ULL);
+
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+static void rng_seed(uint64_t seed)
+{
+	int i;
+
+	for (i = 0; i < 4; i++)
+		rng[i] = splitmix64(&seed);
+}
+
+static uint64_t rotl(uint64_t x, int k)
+{
+	return (x << k) | (x >> (64 - k));
+}
+
+static uint64_t rng_next(void)
+{
+	uint64_t result = rotl(rng[1] * 5, 7) * 9;
+	uint64_t t = rng[1] << 17;
+
+	rng[2] ^= rng[0];
+	rng[3] ^= rng[1];
+	rng[1] ^= rng[2];
+	rng[0] ^= rng[3];
+	rng[2] ^= t;
+	rng[3] = rotl(rng[3], 45);
+	return result;
+}
+
+/* Uniform in [0, 1) */
+static double rng_unif(void)
+{
+	return (rng_next() >> 11) * 0x1.0p-53;
+}
+
+/* Standard normal (Box-Muller) */
+static double rng_normal(void)
+{
+	double u = 1.0 - rng_unif(); /* in (0, 1] */
+
+	return sqrt(-2 * log(u)) * cos(2 * M_PI * rng_unif());
+}
+
+/***************
+ * Distributions
+ ***************/
+
+/*
+ * pick - Index of the weight bucket u falls into
+ */
+static int pick(dist_t *d, double u)
+{
+	int lo = 0, hi = d->n - 1, mid;
+
+	while (lo < hi)
+	{
+		mid = (lo + hi) / 2;
+		if (u < d->cum[mid])
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+	return lo;
+}
+
+/*
+ * dist_sample - Draw a value (at least 1)
+ */
+static uint64_t dist_sample(dist_t *d)
+{
+	double u = rng_unif(), x, e;
+	int i;
+
+	switch (d->kind)
+	{
+	case DIST_UNIFORM:
+		x = floor(d->a + u * (d->b - d->a + 1));
+		break;
+	case DIST_LOGNORMAL:
+		x = d->a * exp(d->b * rng_normal());
+		break;
+	case DIST_POWERLAW:
+		if (fabs(d->c - 1) < 1e-9)
+			x = d->a * pow(d->b / d->a, u);
+		else
+		{
+			e = 1 - d->c;
+			x = pow(pow(d->a, e) + u * (pow(d->b, e) - pow(d->a, e)), 1 / e);
+		}
+		break;
+	case DIST_EXP:
+		x = -d->a * log(1 - u);
+		break;
+	case DIST_FIXED:
+		x = d->val[pick(d, u)];
+		break;
+	default: /* DIST_HIST */
+		i = pick(d, u);
+		x = floor(d->val[2 * i] + rng_unif() * (d->val[2 * i + 1] - d->val[2 * i] + 1));
+	}
+	if (x < 1)
+		return 1;
+	if (x > (double)MAX_SIZE)
+		return MAX_SIZE;
+	return (uint64_t)x;
+}
+
+/*
+ * dist_mean - Mean of a distribution (without the clamping)
+ */
+static double dist_mean(dist_t *d)
+{
+	double m = 0, e;
+	int i;
+
+	switch (d->kind)
+	{
+	case DIST_UNIFORM:
+		return (d->a + d->b) / 2;
+	case DIST_LOGNORMAL:
+		return d->a * exp(d->b * d->b / 2);
+	case DIST_POWERLAW:
+		if (fabs(d->c - 1) < 1e-9)
+			return (d->b - d->a) / log(d->b / d->a);
+		if (fabs(d->c - 2) < 1e-9)
+			return log(d->b / d->a) / (1 / d->a - 1 / d->b);
+		e = 1 - d->c;
+		return e / (e + 1) * (pow(d->b, e + 1) - pow(d->a, e + 1)) / (pow(d->b, e) - pow(d->a, e));
+	case DIST_EXP:
+		return d->a;
+	}
+	for (i = 0; i < d->n; i++)
+	{
+		e = d->cum[i] - (i > 0 ? d->cum[i - 1] : 0);
+		m += e * (d->kind == DIST_FIXED ? d->val[i] : (d->val[2 * i] + d->val[2 * i + 1]) / 2);
+	}
+	return m;
+}
+
+/*
+ * normalize - Turn the weights in cum into cumulative fractions
+ */
+static void normalize(dist_t *d)
+{
+	double total = 0;
+	int i;
+
+	for (i = 0; i < d->n; i++)
+		total += d->cum[i];
+	for (i = 0; i < d->n; i++)
+		d->cum[i] = (i > 0 ? d->cum[i - 1] : 0) + d->cum[i] / total;
+	d->cum[d->n - 1] = 1;
+}
+
+/*
+ * parse_dist - Parse a distribution spec; return -1 if it is bad
+ */
+static int parse_dist(char *spec, dist_t *d)
+{
+	char *args, *p, *end;
+	int n;
+
+	if ((args = strchr(spec, ':')) == NULL)
+		return -1;
+	args++;
+	memset(d, 0, sizeof(dist_t));
+
+	if (strncmp(spec, "fixed:", 6) == 0)
+	{
+		d->kind = DIST_FIXED;
+		d->val = malloc(MAX_FIXED * sizeof(double));
+		d->cum = malloc(MAX_FIXED * sizeof(double));
+		if (d->val == NULL || d->cum == NULL)
+			app_error("tracegen: out of memory");
+		for (p = args; *p != '\0' && d->n < MAX_FIXED; p = end + (*end == ','))
+		{
+			d->val[d->n] = strtod(p, &end);
+			if (end == p || d->val[d->n] < 1)
+				return -1;
+			d->cum[d->n] = 1;
+			if (*end == '@')
+			{
+				p = end + 1;
+				d->cum[d->n] = strtod(p, &end);
+				if (end == p || d->cum[d->n] <= 0)
+					return -1;
+			}
+			if (*end != ',' && *end != '\0')
+				return -1;
+			d->n++;
+		}
+		if (d->n == 0 || *p != '\0')
+			return -1;
+		normalize(d);
+		return 0;
+	}
+
+	n = sscanf(args, "%lf,%lf,%lf", &d->a, &d->b, &d->c);
+	if (strncmp(spec, "uniform:", 8) == 0 && n == 2 && d->a >= 0 && d->b >= d->a)
+		d->kind = DIST_UNIFORM;
+	else if (strncmp(spec, "lognormal:", 10) == 0 && n == 2 && d->a > 0 && d->b >= 0)
+		d->kind = DIST_LOGNORMAL;
+	else if (strncmp(spec, "powerlaw:", 9) == 0 && n == 3 && d->a > 0 && d->b > d->a)
+		d->kind = DIST_POWERLAW;
+	else if (strncmp(spec, "exp:", 4) == 0 && n == 1 && d->a > 0)
+		d->kind = DIST_EXP;
+	else
+		return -1;
+	return 0;
+}
+
+/*
+ * hist_dist - Make a piecewise uniform distribution from the nonempty
+ *     buckets of a histogram
+ */
+static void hist_dist(hist_t *h, dist_t *d)
+{
+	int b;
+
+	memset(d, 0, sizeof(dist_t));
+	d->kind = DIST_HIST;
+	d->val = malloc(2 * HIST_BUCKETS * sizeof(double));
+	d->cum = malloc(HIST_BUCKETS * sizeof(double));
+	if (d->val == NULL || d->cum == NULL)
+		app_error("tracegen: out of memory");
+	for (b = 0; b < HIST_BUCKETS; b++)
+	{
+		if (h->buckets[b] == 0)
+			continue;
+		d->val[2 * d->n] = (b == 0) ? 0 : hist_bucket_top(b - 1) + 1;
+		d->val[2 * d->n + 1] = hist_bucket_top(b);
+		d->cum[d->n++] = h->buckets[b];
+	}
+	normalize(d);
+}
+
+/*
+ * print_dist - Describe a distribution
+ */
+static void print_dist(dist_t *d)
+{
+	int i;
+
+	switch (d->kind)
+	{
+	case DIST_UNIFORM:
+		printf("uniform:%g,%g", d->a, d->b);
+		break;
+	case DIST_LOGNORMAL:
+		printf("lognormal:%g,%g", d->a, d->b);
+		break;
+	case DIST_POWERLAW:
+		printf("powerlaw:%g,%g,%g", d->a, d->b, d->c);
+		break;
+	case DIST_EXP:
+		printf("exp:%g", d->a);
+		break;
+	case DIST_FIXED:
+		printf("fixed:");
+		for (i = 0; i < d->n && i < 8; i++)
+			printf("%s%g@%.3f", i > 0 ? "," : "", d->val[i],
+				   d->cum[i] - (i > 0 ? d->cum[i - 1] : 0));
+		if (d->n > 8)
+			printf(",... (%d values)", d->n);
+		break;
+	default:
+		printf("histogram of %d bins", d->n);
+	}
+	printf(" (mean %.1f)", dist_mean(d));
+}
+
+/********
+ * Events
+ ********/
+
+static void push_event(uint64_t time, uint64_t id, int kind)
+{
+	size_t i = nevents++, parent;
+	event_t e = {time, id, kind};
+
+	if (nevents > events_cap)
+	{
+		events_cap = events_cap ? 2 * events_cap : 1024;
+		if ((events = realloc(events, events_cap * sizeof(event_t))) == NULL)
+			app_error("tracegen: out of memory");
+	}
+	for (; i > 0 && events[parent = (i - 1) / 2].time > time; i = parent)
+		events[i] = events[parent];
+	events[i] = e;
+}
+
+static event_t pop_event(void)
+{
+	event_t top = events[0], last = events[--nevents];
+	size_t i = 0, child;
+
+	while ((child = 2 * i + 1) < nevents)
+	{
+		if (child + 1 < nevents && events[child + 1].time < events[child].time)
+			child++;
+		if (last.time <= events[child].time)
+			break;
+		events[i] = events[child];
+		i = child;
+	}
+	events[i] = last;
+	return top;
+}
+
+/********
+ * Output
+ ********/
+
+static void open_output(char *path, int binary)
+{
+	char msg[2 * MAXLINE];
+
+	if ((out = binary ? traceio_create(path, 0, 1) : traceio_create_text(path, 0, 1)) == NULL)
+	{
+		sprintf(msg, "tracegen: %s: %s", path, strerror(errno));
+		app_error(msg);
+	}
+}
+
+static void emit(int type, uint64_t id, uint64_t size)
+{
+	traceio_op_t op = {type, id, size};
+
+	if (traceio_put(out, &op) < 0)
+		app_error("tracegen: write error");
+}
+
+static void close_output(char *path, uint64_t heap)
+{
+	char msg[2 * MAXLINE];
+
+	out->hdr.sugg_heapsize = heap;
+	if (traceio_finish(out) < 0)
+	{
+		sprintf(msg, "tracegen: %s: %s", path, strerror(errno));
+		app_error(msg);
+	}
+}
+
+/*********
+ * Fitting
+ *********/
+
+/*
+ * fit - Fit phase p to the trace at path: the size mixture (or a
+ *     histogram if it has too many distinct sizes), a histogram of the
+ *     lifetimes of the freed blocks, the fraction never freed, and the
+ *     fraction of blocks realloc'd, how often, and their mean growth:
+ *     additive if the size steps vary less than the ratios, else
+ *     multiplicative. Return the number of ops.
+ */
+static uint64_t fit(char *path, phase_t *p)
+{
+	static hist_t sizes, lives;
+	tracestream_t *s;
+	traceio_op_t *ops, *op;
+	idmap_t *live, *distinct;
+	idmap_entry_t *e, old;
+	uint64_t opnum = 0, allocs = 0, reallocs = 0, grown = 0, ngrowth = 0;
+	double sum_log = 0, sum_log2 = 0, sum_add = 0, sum_add2 = 0, v, w;
+	char msg[2 * MAXLINE];
+	long i, n;
+	size_t k;
+	int j;
+
+	if ((s = tracestream_open(path, TRACESTREAM_CHUNK)) == NULL)
+	{
+		sprintf(msg, "tracegen: %s: %s", path, strerror(errno));
+		app_error(msg);
+	}
+	if ((live = idmap_new()) == NULL || (distinct = idmap_new()) == NULL)
+		app_error("tracegen: out of memory");
+	hist_reset(&sizes);
+	hist_reset(&lives);
+
+	/* Live blocks map id -> size, and tag the op that allocated them;
+	   ptr marks the ones that have been realloc'd */
+	while ((n = tracestream_next(s, &ops)) > 0)
+	{
+		for (i = 0; i < n; i++, opnum++)
+		{
+			op = &ops[i];
+			if (op->type == TRACEIO_FREE)
+			{
+				if (idmap_remove(live, op->id, &old))
+					hist_record(&lives, opnum - old.tag);
+				continue;
+			}
+			if (op->type == TRACEIO_REALLOC && (e = idmap_get(live, op->id)) != NULL)
+			{
+				reallocs++;
+				if (e->ptr == NULL)
+				{
+					e->ptr = e;
+					grown++;
+				}
+				if (e->size > 0 && op->size > 0)
+				{
+					v = log((double)op->size / e->size);
+					w = (double)op->size - e->size;
+					sum_log += v;
+					sum_log2 += v * v;
+					sum_add += w;
+					sum_add2 += w * w;
+					ngrowth++;
+				}
+				e->size = op->size;
+				continue;
+			}
+			/* An alloc, or a realloc of a block that isn't live */
+			if ((e = idmap_put(live, op->id)) == NULL ||
+				idmap_put(distinct, op->size) == NULL)
+				app_error("tracegen: out of memory");
+			e->size = op->size;
+			e->tag = opnum;
+			e->ptr = NULL;
+			idmap_get(distinct, op->size)->tag++;
+			hist_record(&sizes, op->size);
+			allocs++;
+		}
+	}
+	if (n < 0)
+	{
+		sprintf(msg, "tracegen: %s: %s", path, s->error);
+		app_error(msg);
+	}
+	if (allocs == 0)
+	{
+		sprintf(msg, "tracegen: %s: no allocations to fit", path);
+		app_error(msg);
+	}
+
+	/* Sizes */
+	if (distinct->count <= MAX_FIXED)
+	{
+		memset(&p->size, 0, sizeof(dist_t));
+		p->size.kind = DIST_FIXED;
+		p->size.val = malloc(distinct->count * sizeof(double));
+		p->size.cum = malloc(distinct->count * sizeof(double));
+		if (p->size.val == NULL || p->size.cum == NULL)
+			app_error("tracegen: out of memory");
+		for (k = 0; k < distinct->cap; k++)
+		{
+			e = &distinct->slots[k];
+			if (idmap_get(distinct, e->id) != e)
+				continue; /* an empty slot */
+			/* Insert it in size order */
+			v = (e->id > 0) ? e->id : 1;
+			w = e->tag;
+			for (j = p->size.n++; j > 0 && p->size.val[j - 1] > v; j--)
+			{
+				p->size.val[j] = p->size.val[j - 1];
+				p->size.cum[j] = p->size.cum[j - 1];
+			}
+			p->size.val[j] = v;
+			p->size.cum[j] = w;
+		}
+		normalize(&p->size);
+	}
+	else
+		hist_dist(&sizes, &p->size);
+
+	/* Lifetimes; the blocks still live at the end are kept */
+	if (lives.count > 0)
+		hist_dist(&lives, &p->life);
+	p->keep = (double)live->count / allocs;
+
+	/* Realloc growth */
+	p->grow = (double)grown / allocs;
+	p->grow_count = (grown > 0) ? (int)((double)reallocs / grown + 0.5) : 0;
+	p->factor = 1;
+	p->add = 0;
+	if (ngrowth > 0)
+	{
+		v = sum_log / ngrowth;
+		w = sum_add / ngrowth;
+		/* Compare the coefficients of variation */
+		if (sqrt(fmax(sum_add2 / ngrowth - w * w, 0)) * fabs(v) <
+			sqrt(fmax(sum_log2 / ngrowth - v * v, 0)) * fabs(w))
+			p->add = w;
+		else
+			p->factor = exp(v);
+	}
+
+	idmap_free(live);
+	idmap_free(distinct);
+	tracestream_close(s);
+	return opnum;
+}
+
+/************
+ * Generating
+ ************/
+
+/*
+ * generate - Write a trace of num_ops ops following the phases, with
+ *     at most max_live blocks live at once (0 for no limit) and all
+ *     lifetimes multiplied by scale
+ */
+static void generate(phase_t *phases, int nphases, uint64_t num_ops,
+					 uint64_t max_live, double scale, char *path, int binary)
+{
+	phase_t *p = &phases[0];
+	idmap_t *live;
+	idmap_entry_t *e, old;
+	event_t ev;
+	uint64_t ops = 0, next_id = 0, size, life, death;
+	uint64_t live_bytes = 0, peak_bytes = 0, peak_live = 0, reallocs = 0;
+	int ph = 0, i;
+
+	if ((live = idmap_new()) == NULL)
+		app_error("tracegen: out of memory");
+	open_output(path, binary);
+
+	/* Every step is one op. An alloc leaves one more free to do at the
+	   end, so stop once the ops so far plus those frees reach num_ops. */
+	while (ops + live->count < num_ops)
+	{
+		while (ph + 1 < nphases && ops >= phases[ph + 1].start * num_ops)
+			p = &phases[++ph];
+
+		if (nevents > 0 &&
+			(events[0].time <= ops || (max_live > 0 && live->count >= max_live) ||
+			 ops + live->count + 2 > num_ops))
+		{
+			ev = pop_event();
+			if (ev.kind == EV_REALLOC)
+			{
+				e = idmap_get(live, ev.id);
+				size = (uint64_t)(e->size * p->factor + p->add);
+				size = (size < 1) ? 1 : (size > MAX_SIZE) ? MAX_SIZE
+														  : size;
+				emit(TRACEIO_REALLOC, ev.id, size);
+				live_bytes = live_bytes - e->size + size;
+				e->size = size;
+				reallocs++;
+			}
+			else
+			{
+				idmap_remove(live, ev.id, &old);
+				emit(TRACEIO_FREE, ev.id, 0);
+				live_bytes -= old.size;
+			}
+		}
+		else if (ops + live->count + 2 <= num_ops)
+		{
+			size = dist_sample(&p->size);
+			life = (uint64_t)(dist_sample(&p->life) * scale);
+			life = (life < 1) ? 1 : life;
+			if ((e = idmap_put(live, next_id)) == NULL)
+				app_error("tracegen: out of memory");
+			e->size = size;
+			emit(TRACEIO_ALLOC, next_id, size);
+			live_bytes += size;
+
+			death = (rng_unif() < p->keep) ? UINT64_MAX : ops + 1 + life;
+			push_event(death, next_id, EV_FREE);
+			if (rng_unif() < p->grow)
+				for (i = 1; i <= p->grow_count; i++)
+					push_event(ops + 1 + life * i / (p->grow_count + 1), next_id, EV_REALLOC);
+			next_id++;
+		}
+		else
+			break; /* one op short; can't fit an alloc and its free */
+		ops++;
+		if (live->count > peak_live)
+			peak_live = live->count;
+		if (live_bytes > peak_bytes)
+			peak_bytes = live_bytes;
+	}
+
+	/* Free whatever is left, dropping the reallocs that didn't happen */
+	while (nevents > 0)
+	{
+		ev = pop_event();
+		if (ev.kind == EV_FREE)
+		{
+			emit(TRACEIO_FREE, ev.id, 0);
+			ops++;
+		}
+	}
+
+	close_output(path, peak_bytes);
+	printf("%s: %llu ops, %llu blocks, %llu reallocs, peak %llu live blocks, %llu KB\n",
+			   path, (unsigned long long)ops, (unsigned long long)next_id,
+			   (unsigned long long)reallocs, (unsigned long long)peak_live,
+			   (unsigned long long)(peak_bytes / 1024));
+	idmap_free(live);
+}
+
+int main(int argc, char **argv)
+{
+	static phase_t phases[MAX_PHASES];
+	phase_t *p = &phases[0];
+	uint64_t seed = 1, num_ops = 0, max_live = 0, fitted_ops = 0;
+	double scale = 1;
+	char *out = NULL, *growth, *end;
+	char msg[2 * MAXLINE];
+	int binary = 0, verbose = 0, nphases = 1, c, i;
+
+	/* Defaults for phase 0 */
+	parse_dist("lognormal:64,1", &p->size);
+	parse_dist("exp:1000", &p->life);
+	p->factor = 1;
+
+	while ((c = getopt(argc, argv, "o:bs:n:L:S:T:K:G:p:F:x:vh")) != EOF)
+	{
+		switch (c)
+		{
+		case 'o': /* Output file */
+			out = optarg;
+			break;
+		case 'b': /* Write a binary trace */
+			binary = 1;
+			break;
+		case 's': /* Random seed */
+			seed = strtoull(optarg, NULL, 0);
+			break;
+		case 'n': /* Number of ops */
+			num_ops = strtoull(optarg, NULL, 0);
+			break;
+		case 'L': /* Most blocks live at once */
+			max_live = strtoull(optarg, NULL, 0);
+			break;
+		case 'S': /* Size distribution */
+		case 'T': /* Lifetime distribution */
+			if (parse_dist(optarg, c == 'S' ? &p->size : &p->life) < 0)
+			{
+				sprintf(msg, "tracegen: bad distribution %s", optarg);
+				app_error(msg);
+			}
+			break;
+		case 'K': /* Fraction of blocks kept to the end */
+			p->keep = atof(optarg);
+			break;
+		case 'G': /* Realloc growth: <frac>:<count>:x<factor> or +<bytes> */
+			p->grow = strtod(optarg, &end);
+			if (*end != ':' || (p->grow_count = strtol(end + 1, &growth, 10)) < 1 ||
+				*growth != ':' || (growth[1] != 'x' && growth[1] != '+'))
+			{
+				sprintf(msg, "tracegen: bad growth %s", optarg);
+				app_error(msg);
+			}
+			p->factor = (growth[1] == 'x') ? atof(growth + 2) : 1;
+			p->add = (growth[1] == '+') ? atof(growth + 2) : 0;
+			break;
+		case 'p': /* Start a new phase at <pct> percent of the ops */
+			if (nphases == MAX_PHASES)
+				app_error("tracegen: too many phases");
+			phases[nphases] = *p;
+			p = &phases[nphases++];
+			p->start = atof(optarg) / 100;
+			if (p->start <= phases[nphases - 2].start || p->start >= 1)
+			{
+				sprintf(msg, "tracegen: phase start %s must be increasing and below 100", optarg);
+				app_error(msg);
+			}
+			break;
+		case 'F': /* Fit phase 0 to a trace */
+			if (nphases > 1)
+				app_error("tracegen: -F must come before -p");
+			fitted_ops = fit(optarg, &phases[0]);
+			break;
+		case 'x': /* Scale the ops and lifetimes */
+			scale = atof(optarg);
+			if (scale <= 0)
+			{
+				usage();
+				exit(1);
+			}
+			break;
+		case 'v': /* Print the workload */
+			verbose = 1;
+			break;
+		case 'h':
+			usage();
+			exit(0);
+		default:
+			usage();
+			exit(1);
+		}
+	}
+	if (out == NULL || optind < argc)
+	{
+		usage();
+		exit(1);
+	}
+	if (num_ops == 0)
+		num_ops = fitted_ops > 0 ? (uint64_t)(fitted_ops * scale) : 100000;
+	if (strlen(out) > 4 && strcmp(out + strlen(out) - 4, ".mtr") == 0)
+		binary = 1;
+
+	if (verbose)
+		for (i = 0; i < nphases; i++)
+		{
+			p = &phases[i];
+			printf("phase %d from %.0f%%:\n  sizes: ", i, p->start * 100);
+			print_dist(&p->size);
+			printf("\n  lifetimes: ");
+			print_dist(&p->life);
+			printf(" x %g\n  kept: %.3f, realloc'd: %.3f x %d, growth x%g +%g\n",
+				   scale, p->keep, p->grow, p->grow_count, p->factor, p->add);
+		}
+
+	rng_seed(seed);
+	generate(phases, nphases, num_ops, max_live, scale, out, binary);
+	exit(0);
+}
+
+static void usage(void)
+{
+	fprintf(stderr, "Usage: tracegen [-bvh] [-s <seed>] [-n <ops>] [-L <n>] [-F <trace> [-x <f>]]\n"
+					"                [-S <dist>] [-T <dist>] [-K <frac>] [-G <growth>]\n"
+					"                [-p <pct> [-S ...] ...] -o <out>\n");
+	fprintf(stderr, "Options\n");
+	fprintf(stderr, "\t-b          Write a binary trace (also if <out> ends in .mtr).\n");
+	fprintf(stderr, "\t-F <trace>  Fit sizes, lifetimes and growth to <trace>.\n");
+	fprintf(stderr, "\t-G <f>:<n>:x<k>|+<b>  A fraction f of blocks is realloc'd n times,\n"
+					"\t            each time to k times its size, or b bytes bigger.\n");
+	fprintf(stderr, "\t-h          Print this message.\n");
+	fprintf(stderr, "\t-K <frac>   Fraction of blocks that live to the end.\n");
+	fprintf(stderr, "\t-L <n>      At most <n> blocks live at once.\n");
+	fprintf(stderr, "\t-n <ops>    Number of ops (default 100000, or that of the fitted\n"
+					"\t            trace times -x).\n");
+	fprintf(stderr, "\t-o <out>    Output trace.\n");
+	fprintf(stderr, "\t-p <pct>    Start a new phase at <pct>%% of the ops; the options\n"
+					"\t            after it apply to the new phase.\n");
+	fprintf(stderr, "\t-s <seed>   Random seed (default 1).\n");
+	fprintf(stderr, "\t-S <dist>   Size distribution (default lognormal:64,1).\n");
+	fprintf(stderr, "\t-T <dist>   Lifetime distribution in ops (default exp:1000).\n");
+	fprintf(stderr, "\t-v          Print the workload.\n");
+	fprintf(stderr, "\t-x <f>      Multiply lifetimes (and fitted ops) by <f>.\n");
+	fprintf(stderr, "Distributions: uniform:<lo>,<hi>  lognormal:<median>,<sigma>\n"
+					"\tpowerlaw:<lo>,<hi>,<alpha>  exp:<mean>  fixed:<v>[@<w>],...\n");
+}
+
+/*
+ * app_error - Report an arbitrary application error
+ */
+static void app_error(char *msg)
+{
+	printf("%s\n", msg);
+	exit(1);
+}
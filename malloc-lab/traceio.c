@@ -0,0 +1,286 @@
+/****************************
+ * Binary trace files (and text ones being written)
+ ****************************/
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "traceio.h"
+
+/*
+ * get_varint - Decode a LEB128 varint at *pp (not past end), advancing
+ *     *pp; return -1 if it runs off the end or over 64 bits
+ */
+static int get_varint(const unsigned char **pp, const unsigned char *end, uint64_t *v)
+{
+    const unsigned char *p = *pp;
+    uint64_t x = 0;
+    int shift = 0;
+
+    do {
+	if (p == end || shift > 63)
+	    return -1;
+	x |= (uint64_t) (*p & 0x7f) << shift;
+	shift += 7;
+    } while (*p++ & 0x80);
+
+    *v = x;
+    *pp = p;
+    return 0;
+}
+
+/*
+ * put_varint - Append v as a LEB128 varint to buf; return its length
+ */
+static int put_varint(unsigned char *buf, uint64_t v)
+{
+    int n = 0;
+
+    while (v >= 0x80) {
+	buf[n++] = (unsigned char) (v | 0x80);
+	v >>= 7;
+    }
+    buf[n++] = (unsigned char) v;
+    return n;
+}
+
+/*
+ * traceio_is_binary - Return 1 if path starts with the binary magic,
+ *     0 if it doesn't, -1 if it can't be read
+ */
+int traceio_is_binary(char *path)
+{
+    FILE *fp;
+    char magic[8];
+    int n;
+
+    if ((fp = fopen(path, "rb")) == NULL)
+	return -1;
+    n = fread(magic, 1, sizeof(magic), fp);
+    fclose(fp);
+    return n == sizeof(magic) && memcmp(magic, TRACEIO_MAGIC, sizeof(magic)) == 0;
+}
+
+/*
+ * traceio_open - Map a binary trace and check its header
+ */
+traceio_t *traceio_open(char *path)
+{
+    traceio_t *t;
+    struct stat st;
+    int fd;
+
+    if ((fd = open(path, O_RDONLY)) < 0)
+	return NULL;
+    if (fstat(fd, &st) < 0) {
+	close(fd);
+	return NULL;
+    }
+    if ((t = calloc(1, sizeof(traceio_t))) == NULL) {
+	close(fd);
+	return NULL;
+    }
+    t->map_size = st.st_size;
+    if (t->map_size < sizeof(traceio_hdr_t)) {
+	close(fd);
+	free(t);
+	errno = EINVAL;
+	return NULL;
+    }
+    t->map = mmap(NULL, t->map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (t->map == MAP_FAILED) {
+	free(t);
+	return NULL;
+    }
+    madvise(t->map, t->map_size, MADV_SEQUENTIAL);
+
+    t->hdr = (traceio_hdr_t *) t->map;
+    if (memcmp(t->hdr->magic, TRACEIO_MAGIC, sizeof(t->hdr->magic)) != 0 ||
+	t->hdr->version != TRACEIO_VERSION ||
+	t->hdr->hdr_size < sizeof(traceio_hdr_t) ||
+	t->hdr->hdr_size > t->map_size ||
+	t->hdr->data_size > t->map_size - t->hdr->hdr_size) {
+	traceio_close(t);
+	errno = EINVAL;
+	return NULL;
+    }
+    t->start = (const unsigned char *) t->map + t->hdr->hdr_size;
+    t->end = t->start + t->hdr->data_size;
+    traceio_rewind(t);
+    return t;
+}
+
+/*
+ * traceio_next - Decode the next op
+ */
+int traceio_next(traceio_t *t, traceio_op_t *op)
+{
+    uint64_t v, delta;
+
+    if (t->pos == t->end)
+	return 0;
+    if (get_varint(&t->pos, t->end, &v) < 0)
+	return -1;
+
+    op->type = (int) (v & 3);
+    delta = v >> 2;
+    t->last_id += (delta >> 1) ^ -(delta & 1);   /* undo the zigzag */
+    op->id = t->last_id;
+    op->size = 0;
+
+    switch (op->type) {
+    case TRACEIO_ALLOC:
+    case TRACEIO_REALLOC:
+	return (get_varint(&t->pos, t->end, &op->size) < 0) ? -1 : 1;
+    case TRACEIO_FREE:
+	return 1;
+    default:
+	return -1;
+    }
+}
+
+/*
+ * traceio_rewind - Start over at the first op
+ */
+void traceio_rewind(traceio_t *t)
+{
+    t->pos = t->start;
+    t->last_id = 0;
+}
+
+/*
+ * traceio_close - Unmap the trace
+ */
+void traceio_close(traceio_t *t)
+{
+    munmap(t->map, t->map_size);
+    free(t);
+}
+
+/*
+ * traceio_create - Start writing a binary trace; the header is filled
+ *     in by traceio_finish
+ */
+traceio_writer_t *traceio_create(char *path, uint64_t sugg_heapsize, uint64_t weight)
+{
+    traceio_writer_t *w;
+
+    if ((w = calloc(1, sizeof(traceio_writer_t))) == NULL)
+	return NULL;
+    if ((w->fp = fopen(path, "wb")) == NULL) {
+	free(w);
+	return NULL;
+    }
+    memcpy(w->hdr.magic, TRACEIO_MAGIC, sizeof(w->hdr.magic));
+    w->hdr.version = TRACEIO_VERSION;
+    w->hdr.hdr_size = sizeof(traceio_hdr_t);
+    w->hdr.sugg_heapsize = sugg_heapsize;
+    w->hdr.weight = weight;
+    if (fwrite(&w->hdr, sizeof(w->hdr), 1, w->fp) != 1) {
+	fclose(w->fp);
+	free(w);
+	return NULL;
+    }
+    return w;
+}
+
+/* Room for each number of a text header, so it can be rewritten */
+#define TEXT_HDR_WIDTH 20
+
+static int write_text_header(traceio_writer_t *w)
+{
+    return fprintf(w->fp, "%-*llu\n%-*llu\n%-*llu\n%llu\n",
+		   TEXT_HDR_WIDTH, (unsigned long long) w->hdr.sugg_heapsize,
+		   TEXT_HDR_WIDTH, (unsigned long long) w->hdr.num_ids,
+		   TEXT_HDR_WIDTH, (unsigned long long) w->hdr.num_ops,
+		   (unsigned long long) w->hdr.weight) < 0 ? -1 : 0;
+}
+
+/*
+ * traceio_create_text - Start writing a text trace; the header is
+ *     rewritten by traceio_finish
+ */
+traceio_writer_t *traceio_create_text(char *path, uint64_t sugg_heapsize, uint64_t weight)
+{
+    traceio_writer_t *w;
+
+    if ((w = calloc(1, sizeof(traceio_writer_t))) == NULL)
+	return NULL;
+    if ((w->fp = fopen(path, "w")) == NULL) {
+	free(w);
+	return NULL;
+    }
+    w->text = 1;
+    w->hdr.sugg_heapsize = sugg_heapsize;
+    w->hdr.weight = weight;
+    if (write_text_header(w) < 0) {
+	fclose(w->fp);
+	free(w);
+	return NULL;
+    }
+    return w;
+}
+
+/*
+ * traceio_put_tag - Append one op, with tag after it on a text line
+ */
+int traceio_put_tag(traceio_writer_t *w, traceio_op_t *op, char *tag)
+{
+    unsigned char buf[24];
+    int64_t d = (int64_t) (op->id - w->last_id);
+    uint64_t zz = ((uint64_t) d << 1) ^ (uint64_t) (d >> 63);
+    int n, rc;
+
+    if (w->text) {
+	if (op->type == TRACEIO_FREE)
+	    rc = fprintf(w->fp, "f %llu", (unsigned long long) op->id);
+	else
+	    rc = fprintf(w->fp, "%c %llu %llu", op->type == TRACEIO_ALLOC ? 'a' : 'r',
+			 (unsigned long long) op->id, (unsigned long long) op->size);
+	if (rc < 0 || (tag != NULL && fprintf(w->fp, " %s", tag) < 0) ||
+	    fputc('\n', w->fp) == EOF)
+	    return -1;
+    }
+    else {
+	n = put_varint(buf, (zz << 2) | (uint64_t) op->type);
+	if (op->type != TRACEIO_FREE)
+	    n += put_varint(buf + n, op->size);
+	if (fwrite(buf, 1, n, w->fp) != (size_t) n)
+	    return -1;
+	w->hdr.data_size += n;
+    }
+
+    w->last_id = op->id;
+    w->hdr.num_ops++;
+    if (op->id + 1 > w->hdr.num_ids)
+	w->hdr.num_ids = op->id + 1;
+    return 0;
+}
+
+/*
+ * traceio_put - Append one op
+ */
+int traceio_put(traceio_writer_t *w, traceio_op_t *op)
+{
+    return traceio_put_tag(w, op, NULL);
+}
+
+/*
+ * traceio_finish - Write the final header and close the file
+ */
+int traceio_finish(traceio_writer_t *w)
+{
+    int ok;
+
+    ok = fseek(w->fp, 0, SEEK_SET) == 0 &&
+	(w->text ? write_text_header(w) == 0 :
+	 fwrite(&w->hdr, sizeof(w->hdr), 1, w->fp) == 1);
+    if (fclose(w->fp) != 0)
+	ok = 0;
+    free(w);
+    return ok ? 0 : -1;
+}
@@ -0,0 +1,102 @@
+/*
+ * traceio.h - Binary trace files
+ *
+ * A compact alternative to the text .rep format for big captured
+ * traces. The file is a fixed 64-byte header followed by the ops, each
+ * one encoded as
+ *
+ *     varint(zigzag(id - previous id) << 2 | type)  [varint(size)]
+ *
+ * with LEB128 varints (7 bits per byte, low bits first). Ids are delta
+ * coded because most traces allocate ids in order, so a typical op
+ * takes 2-4 bytes; sizes are 64-bit. Readers mmap the file and decode
+ * the ops in one pass, with no text parsing. Everything is little
+ * endian.
+ *
+ * A writer can also produce a text trace, so that the tools that write
+ * traces of either kind share one writer.
+ */
+#ifndef __TRACEIO_H_
+#define __TRACEIO_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define TRACEIO_MAGIC   "MMTRACE"   /* 8 bytes with the terminating 0 */
+#define TRACEIO_VERSION 1
+
+/* Op types */
+#define TRACEIO_ALLOC   0
+#define TRACEIO_FREE    1
+#define TRACEIO_REALLOC 2
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t hdr_size;       /* sizeof(traceio_hdr_t), where the ops start */
+    uint64_t sugg_heapsize;  /* the .rep header fields */
+    uint64_t num_ids;
+    uint64_t num_ops;
+    uint64_t weight;
+    uint64_t data_size;      /* bytes of encoded ops */
+    uint64_t reserved;
+} traceio_hdr_t;
+
+/* One decoded op */
+typedef struct {
+    int type;                /* TRACEIO_ALLOC, _FREE or _REALLOC */
+    uint64_t id;
+    uint64_t size;           /* 0 for frees */
+} traceio_op_t;
+
+/* A binary trace opened for reading */
+typedef struct {
+    traceio_hdr_t *hdr;      /* the header, in the mapping */
+    const unsigned char *start, *pos, *end;   /* the encoded ops */
+    uint64_t last_id;
+    void *map;
+    size_t map_size;
+} traceio_t;
+
+/* A trace being written: binary, or text (.rep) with a header padded
+   so that traceio_finish can rewrite it in place */
+typedef struct {
+    FILE *fp;
+    int text;
+    traceio_hdr_t hdr;
+    uint64_t last_id;
+} traceio_writer_t;
+
+/* Return 1 if path is a binary trace, 0 if not, -1 if it can't be read */
+int traceio_is_binary(char *path);
+
+/* Map a binary trace; return NULL with errno set (EINVAL if it is bad) */
+traceio_t *traceio_open(char *path);
+
+/* Decode the next op: return 1, 0 at the end, -1 if the data is corrupt */
+int traceio_next(traceio_t *t, traceio_op_t *op);
+
+/* Start over at the first op */
+void traceio_rewind(traceio_t *t);
+
+/* Unmap the trace */
+void traceio_close(traceio_t *t);
+
+/* Start writing a binary trace; return NULL with errno set */
+traceio_writer_t *traceio_create(char *path, uint64_t sugg_heapsize, uint64_t weight);
+
+/* Start writing a text trace; return NULL with errno set */
+traceio_writer_t *traceio_create_text(char *path, uint64_t sugg_heapsize, uint64_t weight);
+
+/* Append one op; return 0, or -1 on a write error */
+int traceio_put(traceio_writer_t *w, traceio_op_t *op);
+
+/* Append one op followed by " <tag>" on its line (text traces; binary
+   ones have nowhere to keep it and drop it) */
+int traceio_put_tag(traceio_writer_t *w, traceio_op_t *op, char *tag);
+
+/* Fill in the header (num_ids is the largest id + 1) and close the
+   file; return 0, or -1 on a write error */
+int traceio_finish(traceio_writer_t *w);
+
+#endif /* __TRACEIO_H_ */
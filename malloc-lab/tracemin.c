@@ -0,0 +1,556 @@
+/*
+ * tracemin.c - Cut a trace down to a quick benchmark subset
+ *
+ * Two ways to reduce a trace, which can be combined:
+ *
+ *   -s <frac>          keep a random fraction of the ids (a block is
+ *                      kept or dropped as a whole, with all its ops),
+ *                      which keeps the size mix, the lifetimes in
+ *                      requests and the shape of the live-set curve,
+ *                      with the live set scaled by frac;
+ *   -w <first>,<count> keep only ops first..first+count-1. The blocks
+ *                      live at the start of the window are allocated
+ *                      first, oldest first, so the window starts with
+ *                      the live set it had; those live at its end are
+ *                      freed, so the result is balanced.
+ *
+ * Ids are renumbered from 0 in the order the reduced trace allocates
+ * them. With -c, tracemin shows how close the reduced trace stays to
+ * the original: the size mix (exact p50 and p99, and the KS distance
+ * between the size distributions, each counting the blocks live at the
+ * start of the window and the requests in it) and the live-set curve
+ * (largest difference between the two curves, each relative to its
+ * peak, at CURVE_POINTS points), both over the window, and mm_3's
+ * utilization and throughput on the whole of both traces (best of -r
+ * streaming passes each).
+ *
+ * usage: tracemin [-c] [-r <runs>] [-S <seed>] [-s <frac>] [-w <first>,<count>] <in> <out>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <getopt.h>
+#include <stdint.h>
+
+#include "tracestream.h"
+#include "idmap.h"
+#include "mm.h"
+#include "memlib.h"
+#include "config.h"
+#include "mmreplay.h"
+
+/* Misc */
+#define MAXLINE 1024	  /* max length of a message */
+#define CURVE_POINTS 100 /* samples of the live-set curve */
+
+/* The output trace, text or binary, while it is being written */
+static traceio_writer_t *out = NULL;
+static char *out_path = NULL;
+static uint64_t out_ops = 0;
+
+/* The size mix and live-set curve of a trace over the window, for -c */
+typedef struct
+{
+	idmap_t *sizes;				 /* request size -> count (in tag) */
+	uint64_t count;				 /* requests counted */
+	uint64_t live[CURVE_POINTS]; /* live bytes after each 1/CURVE_POINTS of the window */
+	uint64_t peak;				 /* most live bytes in the window */
+} shape_t;
+
+static void usage(void);
+static void app_error(char *msg);
+
+/*
+ * keep_id - Decide whether id is sampled: a hash of the id and seed
+ *     below frac of the range (splitmix64's finalizer)
+ */
+static int keep_id(uint64_t id, uint64_t seed, double frac)
+{
+	uint64_t z = id + seed * 0x9e3779b97f4a7c15ULL;
+
+	if (frac >= 1)
+		return 1;
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	z ^= z >> 31;
+	return (z >> 11) < frac * (double)(1ULL << 53);
+}
+
+/********
+ * Output
+ ********/
+
+static void open_output(char *path, int binary)
+{
+	char msg[2 * MAXLINE];
+
+	if ((out = binary ? traceio_create(path, 0, 1) : traceio_create_text(path, 0, 1)) == NULL)
+	{
+		sprintf(msg, "tracemin: %s: %s", path, strerror(errno));
+		app_error(msg);
+	}
+	out_path = path;
+}
+
+static void emit(int type, uint64_t id, uint64_t size)
+{
+	traceio_op_t op = {type, id, size};
+
+	out_ops++;
+	if (traceio_put(out, &op) < 0)
+		app_error("tracemin: write error");
+}
+
+static void close_output(char *path, uint64_t heap)
+{
+	char msg[2 * MAXLINE];
+	int err;
+
+	out->hdr.sugg_heapsize = heap;
+	err = traceio_finish(out);
+	out = NULL;
+	if (err < 0)
+	{
+		sprintf(msg, "tracemin: %s: %s", path, strerror(errno));
+		remove(path);
+		app_error(msg);
+	}
+}
+
+/***********
+ * Reduction
+ ***********/
+
+static void record_size(shape_t *sh, uint64_t size)
+{
+	idmap_entry_t *e;
+
+	if ((e = idmap_put(sh->sizes, size)) == NULL)
+		app_error("tracemin: out of memory");
+	e->tag++;
+	sh->count++;
+}
+
+static int cmp_tag(const void *a, const void *b)
+{
+	uint64_t x = ((const idmap_entry_t *)a)->tag, y = ((const idmap_entry_t *)b)->tag;
+
+	return (x > y) - (x < y);
+}
+
+/*
+ * free_all - Free every block in live, in output id order
+ */
+static void free_all(idmap_t *live)
+{
+	idmap_entry_t *v;
+	size_t i, k = 0;
+
+	if ((v = malloc(live->count * sizeof(idmap_entry_t) + 1)) == NULL)
+		app_error("tracemin: out of memory");
+	for (i = 0; i < live->cap; i++)
+		if (live->slots[i].id != UINT64_MAX)
+			v[k++] = live->slots[i];
+	qsort(v, k, sizeof(idmap_entry_t), cmp_tag);
+	for (i = 0; i < k; i++)
+		emit(TRACEIO_FREE, v[i].tag, 0);
+	free(v);
+}
+
+/*
+ * reduce - Write the ops of in that are in the window [first, last)
+ *     and on sampled ids to out. The live sampled ids are in a map
+ *     whose tag is, before the window, the op that allocated the
+ *     block, and from the start of the window its output id. If orig
+ *     is not NULL, the shapes of the original and reduced traces over
+ *     the window are recorded in orig and red; that needs the sizes of
+ *     all the live ids of the original as well.
+ */
+static void reduce(char *in, char *out, int binary, double frac, uint64_t seed,
+				   uint64_t first, uint64_t last, shape_t *orig, shape_t *red)
+{
+	tracestream_t *s;
+	traceio_op_t *ops, *op;
+	idmap_t *live, *all = NULL;
+	idmap_entry_t *e, old, *v;
+	char msg[2 * MAXLINE];
+	uint64_t opnum = 0, next_id = 0, live_bytes = 0, peak_bytes = 0, all_bytes = 0, len;
+	size_t j, k;
+	long i, n = 0;
+	int pt = 0;
+
+	if ((s = tracestream_open(in, TRACESTREAM_CHUNK)) == NULL)
+	{
+		sprintf(msg, "tracemin: %s: %s", in, strerror(errno));
+		app_error(msg);
+	}
+	if ((live = idmap_new()) == NULL || (orig != NULL && (all = idmap_new()) == NULL))
+		app_error("tracemin: out of memory");
+	if (first >= s->num_ops)
+	{
+		sprintf(msg, "tracemin: %s has only %llu ops", in, (unsigned long long)s->num_ops);
+		app_error(msg);
+	}
+	len = (last < s->num_ops ? last : s->num_ops) - first;
+	open_output(out, binary);
+
+	while (opnum < last && (n = tracestream_next(s, &ops)) > 0)
+		for (i = 0; i < n && opnum < last; i++, opnum++)
+		{
+			op = &ops[i];
+
+			/* The window starts with the live set it had */
+			if (opnum == first && first > 0)
+			{
+				if ((v = malloc(live->count * sizeof(idmap_entry_t) + 1)) == NULL)
+					app_error("tracemin: out of memory");
+				for (j = 0, k = 0; j < live->cap; j++)
+					if (live->slots[j].id != UINT64_MAX)
+						v[k++] = live->slots[j];
+				qsort(v, k, sizeof(idmap_entry_t), cmp_tag);
+				for (j = 0; j < k; j++)
+				{
+					e = idmap_get(live, v[j].id);
+					e->tag = next_id++;
+					emit(TRACEIO_ALLOC, e->tag, e->size);
+					if (red != NULL)
+						record_size(red, e->size);
+				}
+				free(v);
+
+				/* ... and so does the original's size mix */
+				if (orig != NULL)
+					for (j = 0; j < all->cap; j++)
+						if (all->slots[j].id != UINT64_MAX)
+							record_size(orig, all->slots[j].size);
+			}
+
+			if (all != NULL)
+			{
+				if (op->type == TRACEIO_FREE)
+				{
+					if (idmap_remove(all, op->id, &old))
+						all_bytes -= old.size;
+				}
+				else
+				{
+					if ((e = idmap_put(all, op->id)) == NULL)
+						app_error("tracemin: out of memory");
+					all_bytes += op->size - e->size;
+					e->size = op->size;
+					if (opnum >= first)
+						record_size(orig, op->size);
+				}
+			}
+
+			if (keep_id(op->id, seed, frac))
+				switch (op->type)
+				{
+				case TRACEIO_ALLOC:
+					if ((e = idmap_put(live, op->id)) == NULL)
+						app_error("tracemin: out of memory");
+					e->size = op->size;
+					live_bytes += op->size;
+					if (opnum < first)
+						e->tag = opnum;
+					else
+					{
+						e->tag = next_id++;
+						emit(TRACEIO_ALLOC, e->tag, op->size);
+					}
+					break;
+
+				case TRACEIO_REALLOC:
+					if ((e = idmap_get(live, op->id)) == NULL)
+					{
+						sprintf(msg, "tracemin: %s: op %llu: realloc of id %llu, which is not live",
+								in, (unsigned long long)opnum, (unsigned long long)op->id);
+						app_error(msg);
+					}
+					live_bytes += op->size - e->size;
+					e->size = op->size;
+					if (opnum >= first)
+						emit(TRACEIO_REALLOC, e->tag, op->size);
+					break;
+
+				default:
+					if (!idmap_remove(live, op->id, &old))
+					{
+						sprintf(msg, "tracemin: %s: op %llu: free of id %llu, which is not live",
+								in, (unsigned long long)opnum, (unsigned long long)op->id);
+						app_error(msg);
+					}
+					live_bytes -= old.size;
+					if (opnum >= first)
+						emit(TRACEIO_FREE, old.tag, 0);
+					break;
+				}
+
+			if (opnum < first)
+				continue;
+			if (op->type != TRACEIO_FREE && red != NULL && keep_id(op->id, seed, frac))
+				record_size(red, op->size);
+			if (live_bytes > peak_bytes)
+				peak_bytes = live_bytes;
+			if (orig != NULL)
+			{
+				if (all_bytes > orig->peak)
+					orig->peak = all_bytes;
+				while (pt < CURVE_POINTS && (opnum - first + 1) * CURVE_POINTS >= (pt + 1) * len)
+				{
+					orig->live[pt] = all_bytes;
+					red->live[pt++] = live_bytes;
+				}
+			}
+		}
+	if (opnum < last && n < 0)
+	{
+		sprintf(msg, "tracemin: %s: %s", in, s->error);
+		app_error(msg);
+	}
+	tracestream_close(s);
+	if (opnum <= first)
+	{
+		sprintf(msg, "tracemin: %s has only %llu ops", in, (unsigned long long)opnum);
+		app_error(msg);
+	}
+
+	free_all(live);
+	close_output(out, peak_bytes);
+	idmap_free(live);
+	if (all != NULL)
+		idmap_free(all);
+	if (red != NULL)
+		red->peak = peak_bytes;
+}
+
+/************
+ * Comparison
+ ************/
+
+static int cmp_size(const void *a, const void *b)
+{
+	uint64_t x = ((const idmap_entry_t *)a)->id, y = ((const idmap_entry_t *)b)->id;
+
+	return (x > y) - (x < y);
+}
+
+/*
+ * sort_sizes - Return the entries of a shape's size -> count map by
+ *     size, and their number in *k
+ */
+static idmap_entry_t *sort_sizes(shape_t *sh, size_t *k)
+{
+	idmap_entry_t *v;
+	size_t i;
+
+	if ((v = malloc(sh->sizes->count * sizeof(idmap_entry_t) + 1)) == NULL)
+		app_error("tracemin: out of memory");
+	for (i = 0, *k = 0; i < sh->sizes->cap; i++)
+		if (sh->sizes->slots[i].id != UINT64_MAX)
+			v[(*k)++] = sh->sizes->slots[i];
+	qsort(v, *k, sizeof(idmap_entry_t), cmp_size);
+	return v;
+}
+
+/*
+ * size_percentile - The exact pct-th percentile of the sizes of a shape
+ */
+static uint64_t size_percentile(shape_t *sh, int pct)
+{
+	idmap_entry_t *v;
+	uint64_t cum = 0, size = 0;
+	size_t i, k;
+
+	v = sort_sizes(sh, &k);
+	for (i = 0; i < k; i++)
+	{
+		cum += v[i].tag;
+		if (cum * 100 >= pct * sh->count)
+		{
+			size = v[i].id;
+			break;
+		}
+	}
+	free(v);
+	return size;
+}
+
+/*
+ * ks_distance - Largest difference between the cumulative distributions
+ *     of the sizes of two shapes
+ */
+static double ks_distance(shape_t *a, shape_t *b)
+{
+	idmap_entry_t *va, *vb;
+	uint64_t ca = 0, cb = 0, size;
+	size_t i = 0, j = 0, ka, kb;
+	double d, max = 0;
+
+	if (a->count == 0 || b->count == 0)
+		return 1;
+	va = sort_sizes(a, &ka);
+	vb = sort_sizes(b, &kb);
+	while (i < ka || j < kb)
+	{
+		size = (j == kb || (i < ka && va[i].id < vb[j].id)) ? va[i].id : vb[j].id;
+		if (i < ka && va[i].id == size)
+			ca += va[i++].tag;
+		if (j < kb && vb[j].id == size)
+			cb += vb[j++].tag;
+		d = (double)ca / a->count - (double)cb / b->count;
+		if (d < 0)
+			d = -d;
+		if (d > max)
+			max = d;
+	}
+	free(va);
+	free(vb);
+	return max;
+}
+
+static void print_row(char *name, mmreplay_t *p, shape_t *sh)
+{
+	printf("%-9s %8llu %8llu", name, (unsigned long long)size_percentile(sh, 50),
+		   (unsigned long long)size_percentile(sh, 99));
+	if (p->valid)
+		printf(" %12llu %10llu %10.1f %6.1f%% %9.0f %8.3f\n", (unsigned long long)p->ops,
+			   (unsigned long long)p->ids, p->peak_bytes / 1024.0, p->util * 100,
+			   p->kops, p->secs);
+	else
+		printf("  %s\n", p->error);
+}
+
+static void compare(char *in, char *out, int runs, shape_t *orig, shape_t *red)
+{
+	mmreplay_t a, b;
+	double d, max = 0;
+	int k;
+
+	mem_init();
+	mmreplay(in, runs, &a);
+	mmreplay(out, runs, &b);
+	mem_deinit();
+
+	printf("\n%-9s %8s %8s %12s %10s %10s %7s %9s %8s\n", "", "size p50", "p99",
+		   "ops", "ids", "peak(KB)", "util", "Kops", "secs");
+	print_row("original", &a, orig);
+	print_row("reduced", &b, red);
+
+	for (k = 0; k < CURVE_POINTS; k++)
+	{
+		d = (orig->peak > 0 ? (double)orig->live[k] / orig->peak : 0) -
+			(red->peak > 0 ? (double)red->live[k] / red->peak : 0);
+		if (d < 0)
+			d = -d;
+		if (d > max)
+			max = d;
+	}
+	printf("size mix: KS distance %.3f\n", ks_distance(orig, red));
+	printf("live-set curve: differs by at most %.1f%% of the peak\n", max * 100);
+	if (a.valid && b.valid)
+		printf("mm_3: util %+.1f points, throughput %+.1f%%, replay %.1fx faster\n",
+			   (b.util - a.util) * 100, (b.kops / a.kops - 1) * 100, a.secs / b.secs);
+}
+
+int main(int argc, char **argv)
+{
+	double frac = 1;
+	uint64_t seed = 1, first = 0, count = UINT64_MAX;
+	char *in, *out, *end;
+	shape_t *orig = NULL, *red = NULL;
+	int binary = 0, check = 0, runs = 3, c;
+
+	while ((c = getopt(argc, argv, "bcr:S:s:w:h")) != EOF)
+	{
+		switch (c)
+		{
+		case 'b': /* Write a binary trace */
+			binary = 1;
+			break;
+		case 'c': /* Compare the reduced trace with the original */
+			check = 1;
+			break;
+		case 'r': /* Replays of each trace for -c */
+			if ((runs = atoi(optarg)) < 1)
+			{
+				usage();
+				exit(1);
+			}
+			break;
+		case 'S': /* Seed of the id sampling */
+			seed = strtoull(optarg, NULL, 0);
+			break;
+		case 's': /* Fraction of the ids to keep */
+			frac = atof(optarg);
+			if (frac <= 0 || frac > 1)
+			{
+				usage();
+				exit(1);
+			}
+			break;
+		case 'w': /* Window of ops: <first>,<count> */
+			first = strtoull(optarg, &end, 0);
+			if (*end != ',' || (count = strtoull(end + 1, NULL, 0)) == 0)
+			{
+				usage();
+				exit(1);
+			}
+			break;
+		case 'h':
+			usage();
+			exit(0);
+		default:
+			usage();
+			exit(1);
+		}
+	}
+	if (argc - optind != 2)
+	{
+		usage();
+		exit(1);
+	}
+	in = argv[optind];
+	out = argv[optind + 1];
+	if (strlen(out) > 4 && strcmp(out + strlen(out) - 4, ".mtr") == 0)
+		binary = 1;
+
+	if (check && ((orig = calloc(1, sizeof(shape_t))) == NULL ||
+				  (red = calloc(1, sizeof(shape_t))) == NULL ||
+				  (orig->sizes = idmap_new()) == NULL || (red->sizes = idmap_new()) == NULL))
+		app_error("tracemin: out of memory");
+	reduce(in, out, binary, frac, seed, first,
+		   count > UINT64_MAX - first ? UINT64_MAX : first + count, orig, red);
+	printf("%s: %llu ops\n", out, (unsigned long long)out_ops);
+	if (check)
+		compare(in, out, runs, orig, red);
+	exit(0);
+}
+
+static void usage(void)
+{
+	fprintf(stderr, "Usage: tracemin [-bch] [-r <runs>] [-S <seed>] [-s <frac>] [-w <first>,<count>]\n"
+					"                <in> <out>\n");
+	fprintf(stderr, "Options\n");
+	fprintf(stderr, "\t-b                  Write a binary trace (also if <out> ends in .mtr).\n");
+	fprintf(stderr, "\t-c                  Compare the reduced trace with the original,\n"
+					"\t                    including mm_3's util and throughput.\n");
+	fprintf(stderr, "\t-h                  Print this message.\n");
+	fprintf(stderr, "\t-r <runs>           Replays of each trace for -c, best counts (default 3).\n");
+	fprintf(stderr, "\t-S <seed>           Seed of the id sampling (default 1).\n");
+	fprintf(stderr, "\t-s <frac>           Keep this fraction of the ids (0 < frac <= 1).\n");
+	fprintf(stderr, "\t-w <first>,<count>  Keep the ops from <first> on, <count> of them.\n");
+}
+
+/*
+ * app_error - Report an arbitrary application error, removing the
+ *     output if it was left half written
+ */
+static void app_error(char *msg)
+{
+	printf("%s\n", msg);
+	if (out != NULL)
+		remove(out_path);
+	exit(1);
+}
@@ -0,0 +1,476 @@
+/*
+ * tracemix.c - Interleave several traces into one, as if their
+ *     programs shared a heap
+ *
+ * Each input keeps its own order of ops; how the inputs take turns is
+ * set by -m:
+ *
+ *   rr      round-robin: -q ops of each input in turn (default);
+ *   random  an input picked at random for each -q ops, with the
+ *           weights of -W (default: each input's op count, so that
+ *           they all end at about the same time), seeded by -S;
+ *   phased  -p phases: in each, the next 1/p of every input's ops,
+ *           one input after the other. -p 1 runs the inputs back to
+ *           back, on the heap the ones before left behind.
+ *
+ * Every mode is deterministic. Ids are renumbered from 0 in the order
+ * the mix allocates them, so inputs can use the same ids. With -c,
+ * each input and the mix are replayed through mm_3 (best of -r
+ * streaming passes each) to show what sharing the heap costs: heap
+ * size and utilization against the inputs replayed alone, and the
+ * throughput against the time the inputs take alone.
+ *
+ * usage: tracemix [-bc] [-m rr|random|phased] [-q <ops>] [-p <phases>]
+ *                 [-W <w1>,<w2>,...] [-S <seed>] [-r <runs>] <in>... <out>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <getopt.h>
+#include <stdint.h>
+
+#include "tracestream.h"
+#include "idmap.h"
+#include "mm.h"
+#include "memlib.h"
+#include "config.h"
+#include "mmreplay.h"
+
+/* Misc */
+#define MAXLINE 1024	/* max length of a message */
+#define MAX_INPUTS 64	/* max number of traces to mix */
+#define MIX_CHUNK 4096	/* ops per stream buffer of an input */
+
+/* Interleavings */
+#define MIX_RR 0
+#define MIX_RANDOM 1
+#define MIX_PHASED 2
+
+/* An input trace */
+typedef struct
+{
+	char *path;
+	tracestream_t *s;
+	traceio_op_t *ops; /* the chunk being worked through... */
+	long n, next;	   /* ... its size and the next op in it */
+	uint64_t done;	   /* ops taken so far */
+	uint64_t num_ops;  /* ops in it, from the header */
+	idmap_t *ids;	   /* live ids; tag is the id in the mix */
+	double weight;	   /* for -m random */
+	int ended;
+} input_t;
+
+static input_t inputs[MAX_INPUTS];
+static int num_inputs = 0;
+
+/* The output trace, text or binary */
+static traceio_writer_t *out = NULL;
+static uint64_t out_ops = 0;
+
+/* The mix: ids handed out so far, and its live bytes */
+static uint64_t next_id = 0;
+static uint64_t live_bytes = 0, peak_bytes = 0;
+
+/* The state of -m random */
+static uint64_t rng_state;
+
+static void usage(void);
+static void app_error(char *msg);
+
+/*
+ * splitmix64 - A small generator that is plenty for picking inputs
+ */
+static uint64_t splitmix64(uint64_t *x)
+{
+	uint64_t z = (*x += 0x9e3779b97f4a7c15ULL);
+
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+/* Uniform in [0, 1) */
+static double rng_unif(void)
+{
+	return (splitmix64(&rng_state) >> 11) * 0x1.0p-53;
+}
+
+/********
+ * Output
+ ********/
+
+static void open_output(char *path, int binary)
+{
+	char msg[2 * MAXLINE];
+
+	if ((out = binary ? traceio_create(path, 0, 1) : traceio_create_text(path, 0, 1)) == NULL)
+	{
+		sprintf(msg, "tracemix: %s: %s", path, strerror(errno));
+		app_error(msg);
+	}
+}
+
+static void emit(int type, uint64_t id, uint64_t size)
+{
+	traceio_op_t op = {type, id, size};
+
+	out_ops++;
+	if (traceio_put(out, &op) < 0)
+		app_error("tracemix: write error");
+}
+
+static void close_output(char *path, uint64_t heap)
+{
+	char msg[2 * MAXLINE];
+
+	out->hdr.sugg_heapsize = heap;
+	if (traceio_finish(out) < 0)
+	{
+		sprintf(msg, "tracemix: %s: %s", path, strerror(errno));
+		app_error(msg);
+	}
+}
+
+/********
+ * Mixing
+ ********/
+
+static void open_input(input_t *in, char *path)
+{
+	char msg[2 * MAXLINE];
+
+	in->path = path;
+	if ((in->s = tracestream_open(path, MIX_CHUNK)) == NULL)
+	{
+		sprintf(msg, "tracemix: %s: %s", path, strerror(errno));
+		app_error(msg);
+	}
+	if ((in->ids = idmap_new()) == NULL)
+		app_error("tracemix: out of memory");
+	in->num_ops = in->s->num_ops; /* the stream is closed at its end */
+}
+
+/*
+ * step - Move the next op of in into the mix; return 0 if in has ended
+ */
+static int step(input_t *in)
+{
+	traceio_op_t *op;
+	idmap_entry_t *e, old;
+	char msg[2 * MAXLINE];
+
+	if (in->ended)
+		return 0;
+	if (in->next == in->n)
+	{
+		if ((in->n = tracestream_next(in->s, &in->ops)) <= 0)
+		{
+			if (in->n < 0)
+			{
+				sprintf(msg, "tracemix: %s: %s", in->path, in->s->error);
+				app_error(msg);
+			}
+			in->ended = 1;
+			tracestream_close(in->s);
+			return 0;
+		}
+		in->next = 0;
+	}
+	op = &in->ops[in->next++];
+
+	switch (op->type)
+	{
+	case TRACEIO_ALLOC:
+		if ((e = idmap_put(in->ids, op->id)) == NULL)
+			app_error("tracemix: out of memory");
+		e->tag = next_id++;
+		e->size = op->size;
+		live_bytes += op->size;
+		emit(TRACEIO_ALLOC, e->tag, op->size);
+		break;
+
+	case TRACEIO_REALLOC:
+		if ((e = idmap_get(in->ids, op->id)) == NULL)
+		{
+			sprintf(msg, "tracemix: %s: op %llu: realloc of id %llu, which is not live",
+					in->path, (unsigned long long)in->done, (unsigned long long)op->id);
+			app_error(msg);
+		}
+		live_bytes += op->size - e->size;
+		e->size = op->size;
+		emit(TRACEIO_REALLOC, e->tag, op->size);
+		break;
+
+	default:
+		if (!idmap_remove(in->ids, op->id, &old))
+		{
+			sprintf(msg, "tracemix: %s: op %llu: free of id %llu, which is not live",
+					in->path, (unsigned long long)in->done, (unsigned long long)op->id);
+			app_error(msg);
+		}
+		live_bytes -= old.size;
+		emit(TRACEIO_FREE, old.tag, 0);
+		break;
+	}
+	if (live_bytes > peak_bytes)
+		peak_bytes = live_bytes;
+	in->done++;
+	return 1;
+}
+
+/*
+ * take - Move up to quantum ops of in into the mix
+ */
+static void take(input_t *in, uint64_t quantum)
+{
+	uint64_t k;
+
+	for (k = 0; k < quantum && step(in); k++)
+		;
+}
+
+static void mix_rr(uint64_t quantum)
+{
+	int k, active = num_inputs;
+
+	while (active > 0)
+		for (k = 0, active = 0; k < num_inputs; k++)
+		{
+			take(&inputs[k], quantum);
+			active += !inputs[k].ended;
+		}
+}
+
+static void mix_random(uint64_t quantum)
+{
+	double total, r;
+	int k;
+
+	for (;;)
+	{
+		for (k = 0, total = 0; k < num_inputs; k++)
+			if (!inputs[k].ended)
+				total += inputs[k].weight;
+		if (total <= 0)
+			break;
+		r = rng_unif() * total;
+		for (k = 0; k < num_inputs - 1; k++)
+			if (!inputs[k].ended && (r -= inputs[k].weight) < 0)
+				break;
+		while (inputs[k].ended) /* r ran past the end by rounding */
+			k--;
+		take(&inputs[k], quantum);
+	}
+
+	/* Inputs of weight 0 go last */
+	for (k = 0; k < num_inputs; k++)
+		while (step(&inputs[k]))
+			;
+}
+
+static void mix_phased(int phases)
+{
+	input_t *in;
+	int p, k;
+
+	for (p = 1; p <= phases; p++)
+		for (k = 0; k < num_inputs; k++)
+		{
+			in = &inputs[k];
+			while ((p == phases || in->done < in->num_ops * p / phases) && step(in))
+				;
+		}
+}
+
+/************
+ * Comparison
+ ************/
+
+static void print_row(char *name, mmreplay_t *p)
+{
+	printf("%-20.20s", name);
+	if (p->valid)
+		printf(" %10llu %10.1f %10.1f %6.1f%% %9.0f %8.3f\n", (unsigned long long)p->ops,
+			   p->peak_bytes / 1024.0, p->heap / 1024.0, p->util * 100, p->kops, p->secs);
+	else
+		printf("  %s\n", p->error);
+}
+
+/*
+ * compare - Replay every input alone and then the mix. "alone" adds
+ *     up the inputs' ops, peaks, heaps and times, with the average
+ *     utilization as mdriver takes it.
+ */
+static void compare(char *out, int runs)
+{
+	mmreplay_t r, sum, mix;
+	int k;
+
+	memset(&sum, 0, sizeof(sum));
+	sum.valid = 1;
+	mem_init();
+	printf("\n%-20s %10s %10s %10s %7s %9s %8s\n", "", "ops", "peak(KB)", "heap(KB)",
+		   "util", "Kops", "secs");
+	for (k = 0; k < num_inputs; k++)
+	{
+		mmreplay(inputs[k].path, runs, &r);
+		print_row(inputs[k].path, &r);
+		sum.valid &= r.valid;
+		sum.ops += r.ops;
+		sum.peak_bytes += r.peak_bytes;
+		sum.heap += r.heap;
+		sum.util += r.util / num_inputs;
+		sum.secs += r.secs;
+	}
+	mmreplay(out, runs, &mix);
+	mem_deinit();
+
+	sum.kops = sum.secs > 0 ? sum.ops / sum.secs / 1e3 : 0;
+	if (!sum.valid)
+		strcpy(sum.error, "(an input failed)");
+	print_row("alone", &sum);
+	print_row("mixed", &mix);
+	if (sum.valid && mix.valid)
+		printf("mm_3 mixed vs alone: heap %+.1f%%, util %+.1f points, throughput %+.1f%%\n",
+			   (mix.heap / (double)sum.heap - 1) * 100, (mix.util - sum.util) * 100,
+			   (mix.kops / sum.kops - 1) * 100);
+}
+
+int main(int argc, char **argv)
+{
+	uint64_t quantum = 1, seed = 1;
+	double weights[MAX_INPUTS];
+	int num_weights = 0, mode = MIX_RR, phases = 4;
+	int binary = 0, check = 0, runs = 3, c, k;
+	char *out, *p, *end;
+
+	while ((c = getopt(argc, argv, "bcm:p:q:r:S:W:h")) != EOF)
+	{
+		switch (c)
+		{
+		case 'b': /* Write a binary trace */
+			binary = 1;
+			break;
+		case 'c': /* Compare the mix with the inputs alone */
+			check = 1;
+			break;
+		case 'm': /* How the inputs take turns */
+			if (strcmp(optarg, "rr") == 0)
+				mode = MIX_RR;
+			else if (strcmp(optarg, "random") == 0)
+				mode = MIX_RANDOM;
+			else if (strcmp(optarg, "phased") == 0)
+				mode = MIX_PHASED;
+			else
+			{
+				usage();
+				exit(1);
+			}
+			break;
+		case 'p': /* Phases for -m phased */
+			if ((phases = atoi(optarg)) < 1)
+			{
+				usage();
+				exit(1);
+			}
+			break;
+		case 'q': /* Ops per turn for -m rr and random */
+			if ((quantum = strtoull(optarg, NULL, 0)) == 0)
+			{
+				usage();
+				exit(1);
+			}
+			break;
+		case 'r': /* Replays of each trace for -c */
+			if ((runs = atoi(optarg)) < 1)
+			{
+				usage();
+				exit(1);
+			}
+			break;
+		case 'S': /* Seed for -m random */
+			seed = strtoull(optarg, NULL, 0);
+			break;
+		case 'W': /* Weights for -m random: <w1>,<w2>,... */
+			for (p = optarg; num_weights < MAX_INPUTS; p = end + 1)
+			{
+				weights[num_weights++] = strtod(p, &end);
+				if (end == p || weights[num_weights - 1] < 0 || (*end != ',' && *end != '\0'))
+				{
+					usage();
+					exit(1);
+				}
+				if (*end == '\0')
+					break;
+			}
+			break;
+		case 'h':
+			usage();
+			exit(0);
+		default:
+			usage();
+			exit(1);
+		}
+	}
+	if (argc - optind < 2 || argc - optind - 1 > MAX_INPUTS ||
+		(num_weights > 0 && num_weights != argc - optind - 1))
+	{
+		usage();
+		exit(1);
+	}
+	out = argv[argc - 1];
+	if (strlen(out) > 4 && strcmp(out + strlen(out) - 4, ".mtr") == 0)
+		binary = 1;
+
+	for (k = optind; k < argc - 1; k++)
+	{
+		open_input(&inputs[num_inputs], argv[k]);
+		inputs[num_inputs].weight = num_weights > 0 ? weights[num_inputs]
+													: (double)inputs[num_inputs].num_ops;
+		num_inputs++;
+	}
+	rng_state = seed;
+
+	open_output(out, binary);
+	if (mode == MIX_RR)
+		mix_rr(quantum);
+	else if (mode == MIX_RANDOM)
+		mix_random(quantum);
+	else
+		mix_phased(phases);
+	close_output(out, peak_bytes);
+
+	printf("%s: %llu ops from %d traces\n", out, (unsigned long long)out_ops, num_inputs);
+	if (check)
+		compare(out, runs);
+	exit(0);
+}
+
+static void usage(void)
+{
+	fprintf(stderr, "Usage: tracemix [-bch] [-m rr|random|phased] [-q <ops>] [-p <phases>]\n"
+					"                [-W <w1>,<w2>,...] [-S <seed>] [-r <runs>] <in>... <out>\n");
+	fprintf(stderr, "Options\n");
+	fprintf(stderr, "\t-b                  Write a binary trace (also if <out> ends in .mtr).\n");
+	fprintf(stderr, "\t-c                  Compare mm_3 on the mix with mm_3 on each input alone.\n");
+	fprintf(stderr, "\t-h                  Print this message.\n");
+	fprintf(stderr, "\t-m rr               Take turns round-robin (default).\n");
+	fprintf(stderr, "\t-m random           Pick the next input at random, by weight.\n");
+	fprintf(stderr, "\t-m phased           Run the inputs one after the other, in phases.\n");
+	fprintf(stderr, "\t-p <phases>         Phases for -m phased (default 4).\n");
+	fprintf(stderr, "\t-q <ops>            Ops per turn for -m rr and random (default 1).\n");
+	fprintf(stderr, "\t-r <runs>           Replays of each trace for -c, best counts (default 3).\n");
+	fprintf(stderr, "\t-S <seed>           Seed for -m random (default 1).\n");
+	fprintf(stderr, "\t-W <w1>,<w2>,...    Weights of the inputs for -m random\n"
+					"\t                    (default: their op counts).\n");
+}
+
+/*
+ * app_error - Report an arbitrary application error
+ */
+static void app_error(char *msg)
+{
+	printf("%s\n", msg);
+	exit(1);
+}
@@ -0,0 +1,273 @@
+/****************************
+ * Streaming trace reader
+ ****************************/
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "tracestream.h"
+
+#define MAXLINE 1024     /* max line length in a text trace */
+
+/*
+ * fail - Record why the trace is bad
+ */
+static void fail(tracestream_t *s, char *what)
+{
+    s->failed = 1;
+    if (s->fp != NULL)
+	snprintf(s->error, sizeof(s->error), "line %llu: %s",
+		 (unsigned long long) s->lineno, what);
+    else
+	snprintf(s->error, sizeof(s->error), "%s", what);
+}
+
+/*
+ * fill_binary - Decode up to n ops of a binary trace, then drop the
+ *     whole pages that are behind us from the mapping so a long trace
+ *     doesn't stay resident
+ */
+static size_t fill_binary(tracestream_t *s, traceio_op_t *ops, size_t n)
+{
+    size_t i, page = sysconf(_SC_PAGESIZE);
+    const unsigned char *upto;
+    int rc = 1;
+
+    for (i = 0; i < n && (rc = traceio_next(s->bin, &ops[i])) > 0; i++)
+	;
+    if (rc < 0)
+	fail(s, "corrupt op data");
+
+    upto = (const unsigned char *) ((uintptr_t) s->bin->pos & ~(uintptr_t) (page - 1));
+    if (upto > s->dropped) {
+	madvise((void *) s->dropped, upto - s->dropped, MADV_DONTNEED);
+	s->dropped = upto;
+    }
+    return i;
+}
+
+/*
+ * fill_text - Parse up to n ops of a text trace
+ */
+static size_t fill_text(tracestream_t *s, traceio_op_t *ops, size_t n)
+{
+    char line[MAXLINE], *p, *end;
+    size_t i = 0;
+
+    while (i < n && fgets(line, sizeof(line), s->fp) != NULL) {
+	s->lineno++;
+	switch (line[0]) {
+	case 'a':
+	    ops[i].type = TRACEIO_ALLOC;
+	    break;
+	case 'f':
+	    ops[i].type = TRACEIO_FREE;
+	    break;
+	case 'r':
+	    ops[i].type = TRACEIO_REALLOC;
+	    break;
+	case '\n':
+	case '\r':
+	    continue;
+	default:
+	    fail(s, "bad op");
+	    return i;
+	}
+	p = line + 1;
+	ops[i].id = strtoull(p, &end, 10);
+	if (end == p) {
+	    fail(s, "missing id");
+	    return i;
+	}
+	ops[i].size = 0;
+	if (ops[i].type != TRACEIO_FREE) {
+	    p = end;
+	    ops[i].size = strtoull(p, &end, 10);
+	    if (end == p) {
+		fail(s, "missing size");
+		return i;
+	    }
+	}
+	i++;
+    }
+    return i;
+}
+
+/*
+ * reader - The reader thread: fill the buffers in turn, each as soon as
+ *     the caller gives it back. The last buffer it fills is empty (n = 0),
+ *     which tells the caller the trace is over.
+ */
+static void *reader(void *arg)
+{
+    tracestream_t *s = arg;
+    tracestream_buf_t *b;
+    size_t n;
+    int k = 0, stop;
+
+    for (;;) {
+	b = &s->buf[k];
+	pthread_mutex_lock(&s->lock);
+	while (b->full && !s->stop)
+	    pthread_cond_wait(&s->cond, &s->lock);
+	stop = s->stop;
+	pthread_mutex_unlock(&s->lock);
+	if (stop)
+	    break;
+
+	n = 0;
+	if (!s->failed)
+	    n = (s->bin != NULL) ? fill_binary(s, b->ops, s->chunk)
+		: fill_text(s, b->ops, s->chunk);
+
+	pthread_mutex_lock(&s->lock);
+	b->n = n;
+	b->full = 1;
+	pthread_cond_broadcast(&s->cond);
+	pthread_mutex_unlock(&s->lock);
+	if (n == 0)
+	    break;
+	k ^= 1;
+    }
+    return NULL;
+}
+
+/*
+ * read_text_header - Read the four header numbers of a text trace
+ */
+static int read_text_header(tracestream_t *s)
+{
+    unsigned long long v[4];
+    char line[MAXLINE];
+    int i;
+
+    for (i = 0; i < 4; i++) {
+	if (fgets(line, sizeof(line), s->fp) == NULL ||
+	    sscanf(line, "%llu", &v[i]) != 1)
+	    return -1;
+	s->lineno++;
+    }
+    s->sugg_heapsize = v[0];
+    s->num_ids = v[1];
+    s->num_ops = v[2];
+    s->weight = v[3];
+    return 0;
+}
+
+/*
+ * tracestream_open - Open a trace and start the reader thread
+ */
+tracestream_t *tracestream_open(char *path, size_t chunk)
+{
+    tracestream_t *s;
+    int binary, k;
+
+    if ((binary = traceio_is_binary(path)) < 0)
+	return NULL;
+    if ((s = calloc(1, sizeof(tracestream_t))) == NULL)
+	return NULL;
+
+    if (binary) {
+	if ((s->bin = traceio_open(path)) == NULL)
+	    goto err;
+	s->sugg_heapsize = s->bin->hdr->sugg_heapsize;
+	s->num_ids = s->bin->hdr->num_ids;
+	s->num_ops = s->bin->hdr->num_ops;
+	s->weight = s->bin->hdr->weight;
+	s->dropped = (const unsigned char *) s->bin->map;
+    } else {
+	if ((s->fp = fopen(path, "r")) == NULL)
+	    goto err;
+	if (read_text_header(s) < 0) {
+	    errno = EINVAL;
+	    goto err;
+	}
+    }
+
+    s->chunk = chunk;
+    s->cur = -1;
+    for (k = 0; k < 2; k++)
+	if ((s->buf[k].ops = malloc(chunk * sizeof(traceio_op_t))) == NULL)
+	    goto err;
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->cond, NULL);
+    if ((errno = pthread_create(&s->reader, NULL, reader, s)) != 0) {
+	pthread_mutex_destroy(&s->lock);
+	pthread_cond_destroy(&s->cond);
+	goto err;
+    }
+    return s;
+
+ err:
+    k = errno;
+    if (s->bin != NULL)
+	traceio_close(s->bin);
+    if (s->fp != NULL)
+	fclose(s->fp);
+    free(s->buf[0].ops);
+    free(s->buf[1].ops);
+    free(s);
+    errno = k;
+    return NULL;
+}
+
+/*
+ * tracestream_next - Give back the buffer the caller has and wait for
+ *     the other one
+ */
+long tracestream_next(tracestream_t *s, traceio_op_t **ops)
+{
+    struct timespec t0, t1;
+    tracestream_buf_t *b;
+    int k;
+
+    pthread_mutex_lock(&s->lock);
+    if (s->cur >= 0) {
+	if (s->buf[s->cur].n == 0) {       /* already at the end */
+	    pthread_mutex_unlock(&s->lock);
+	    return s->failed ? -1 : 0;
+	}
+	s->buf[s->cur].full = 0;
+	pthread_cond_broadcast(&s->cond);
+    }
+    k = (s->cur < 0) ? 0 : s->cur ^ 1;
+    b = &s->buf[k];
+    if (!b->full) {
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	while (!b->full)
+	    pthread_cond_wait(&s->cond, &s->lock);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	s->stall_secs += (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+    }
+    s->cur = k;
+    pthread_mutex_unlock(&s->lock);
+
+    if (b->n == 0)
+	return s->failed ? -1 : 0;
+    *ops = b->ops;
+    return (long) b->n;
+}
+
+/*
+ * tracestream_close - Stop the reader and close the trace
+ */
+void tracestream_close(tracestream_t *s)
+{
+    pthread_mutex_lock(&s->lock);
+    s->stop = 1;
+    pthread_cond_broadcast(&s->cond);
+    pthread_mutex_unlock(&s->lock);
+    pthread_join(s->reader, NULL);
+
+    pthread_mutex_destroy(&s->lock);
+    pthread_cond_destroy(&s->cond);
+    if (s->bin != NULL)
+	traceio_close(s->bin);
+    if (s->fp != NULL)
+	fclose(s->fp);
+    free(s->buf[0].ops);
+    free(s->buf[1].ops);
+    free(s);
+}
@@ -0,0 +1,64 @@
+/*
+ * tracestream.h - Read a trace in chunks from a background thread
+ *
+ * For traces too long to load. A reader thread decodes the ops of a
+ * text (.rep) or binary (traceio.h) trace into two fixed buffers of
+ * chunk ops each: while the caller works through one, the reader
+ * fills the other. Memory use depends only on the chunk size. Pages of
+ * a binary trace that have been decoded are dropped from the mapping
+ * as the reader moves on.
+ */
+#ifndef __TRACESTREAM_H_
+#define __TRACESTREAM_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "traceio.h"
+
+/* Default number of ops per buffer */
+#define TRACESTREAM_CHUNK 65536
+
+typedef struct {
+    traceio_op_t *ops;
+    size_t n;                /* ops in the buffer, 0 at the end */
+    int full;                /* filled by the reader, not yet given back */
+} tracestream_buf_t;
+
+typedef struct {
+    /* The trace header */
+    uint64_t sugg_heapsize, num_ids, num_ops, weight;
+
+    /* Set by the reader if the trace is bad */
+    int failed;
+    char error[128];
+
+    /* Seconds the caller spent waiting for the reader */
+    double stall_secs;
+
+    /* Private */
+    traceio_t *bin;          /* binary trace, or */
+    FILE *fp;                /* text trace */
+    uint64_t lineno;
+    const unsigned char *dropped;   /* mapping dropped up to here */
+    size_t chunk;
+    tracestream_buf_t buf[2];
+    int cur;                 /* buffer the caller has, or -1 */
+    int stop;
+    pthread_t reader;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} tracestream_t;
+
+/* Open a trace and start reading it with chunk ops per buffer; return
+   NULL with errno set (EINVAL for a bad header) */
+tracestream_t *tracestream_open(char *path, size_t chunk);
+
+/* Give back the previous chunk and get the next one in *ops; return
+   the number of ops, 0 at the end, -1 if the trace is bad */
+long tracestream_next(tracestream_t *s, traceio_op_t **ops);
+
+/* Stop the reader and close the trace */
+void tracestream_close(tracestream_t *s);
+
+#endif /* __TRACESTREAM_H_ */